@@ -0,0 +1,234 @@
+#include "accurate_seeker.hpp"
+#include "demuxer.hpp"
+
+#include "utils/logger.hpp"
+
+#include <chrono>
+
+namespace
+{
+    int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::string errorString(int error)
+    {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(error, errbuf, sizeof(errbuf));
+        return errbuf;
+    }
+}
+
+AccurateSeeker::AccurateSeeker(Demuxer &demuxer)
+    : demuxer_(demuxer), stream_(nullptr), codec_ctx_(nullptr), packet_(nullptr), decoded_(nullptr), frame_duration_(0)
+{
+}
+
+AccurateSeeker::~AccurateSeeker()
+{
+    close();
+}
+
+bool AccurateSeeker::open(const AccurateSeekOptions &options)
+{
+    close();
+    options_ = options;
+    stream_ = demuxer_.getAVStream(MediaType::VIDEO);
+    if (!stream_ || !stream_->codecpar)
+    {
+        LOG_ERROR << "Accurate seek needs a video stream.";
+        return false;
+    }
+    const AVCodec *codec = avcodec_find_decoder(stream_->codecpar->codec_id);
+    if (!codec)
+    {
+        LOG_ERROR << "No decoder for " << avcodec_get_name(stream_->codecpar->codec_id) << ".";
+        return false;
+    }
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_)
+    {
+        LOG_ERROR << "Failed to allocate decoder context.";
+        return false;
+    }
+    int ret = avcodec_parameters_to_context(codec_ctx_, stream_->codecpar);
+    if (ret < 0)
+    {
+        LOG_ERROR << "Failed to copy codec parameters: " << errorString(ret);
+        close();
+        return false;
+    }
+    // 帧的时长和时间戳使用流的时间基
+    codec_ctx_->pkt_timebase = stream_->time_base;
+    codec_ctx_->thread_count = options_.threads;
+    ret = avcodec_open2(codec_ctx_, codec, nullptr);
+    if (ret < 0)
+    {
+        LOG_ERROR << "Failed to open decoder: " << errorString(ret);
+        close();
+        return false;
+    }
+    packet_ = av_packet_alloc();
+    decoded_ = av_frame_alloc();
+    if (!packet_ || !decoded_)
+    {
+        LOG_ERROR << "Failed to allocate packet or frame.";
+        close();
+        return false;
+    }
+    // 帧没有携带时长时按平均帧率估算
+    AVRational rate = stream_->avg_frame_rate.num > 0 ? stream_->avg_frame_rate : stream_->r_frame_rate;
+    frame_duration_ = rate.num > 0 && rate.den > 0 ? av_rescale_q(1, av_inv_q(rate), stream_->time_base) : 0;
+    LOG_INFO << "Accurate seeker opened with decoder " << codec->name << ".";
+    return true;
+}
+
+void AccurateSeeker::close()
+{
+    avcodec_free_context(&codec_ctx_);
+    av_packet_free(&packet_);
+    av_frame_free(&decoded_);
+    stream_ = nullptr;
+}
+
+bool AccurateSeeker::seek(int64_t timestamp, AVFrame *frame)
+{
+    last_stats_ = AccurateSeekStats();
+    if (!codec_ctx_ || !frame)
+    {
+        LOG_ERROR << "Accurate seeker not opened.";
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    // 落在目标之前的关键帧上，从那里往后解码才能得到目标帧
+    if (!demuxer_.seek(timestamp, AVSEEK_FLAG_BACKWARD))
+    {
+        return false;
+    }
+    last_stats_.seek_us = elapsedMicroseconds(start);
+    auto decode_start = std::chrono::steady_clock::now();
+    // 解码器中还留着定位之前的参考帧和延迟输出的帧
+    avcodec_flush_buffers(codec_ctx_);
+    av_frame_unref(frame);
+
+    int64_t target = av_rescale_q(timestamp, AV_TIME_BASE_Q, stream_->time_base);
+    bool found = false;
+    bool draining = false;
+    bool failed = false;
+    while (!found && !failed)
+    {
+        if (!draining)
+        {
+            if (demuxer_.readPacket(MediaType::VIDEO, packet_))
+            {
+                if (last_stats_.keyframe_pts == AV_NOPTS_VALUE && packet_->pts != AV_NOPTS_VALUE)
+                {
+                    last_stats_.keyframe_pts = av_rescale_q(packet_->pts, stream_->time_base, AV_TIME_BASE_Q);
+                }
+                // 显示区间在目标之前结束的包一定会被丢掉；没有时间戳的包按需要输出处理
+                int64_t duration = packet_->duration > 0 ? packet_->duration : frame_duration_;
+                bool before_target = packet_->pts != AV_NOPTS_VALUE && packet_->pts + duration <= target;
+                applyDiscard(before_target);
+                int ret = avcodec_send_packet(codec_ctx_, packet_);
+                av_packet_unref(packet_);
+                last_stats_.packets_sent++;
+                if (ret < 0 && ret != AVERROR(EAGAIN))
+                {
+                    // 单个损坏的包不影响后面的解码
+                    LOG_WARN << "Error sending packet to decoder: " << errorString(ret);
+                }
+            }
+            else if (demuxer_.isEOF())
+            {
+                // 目标在最后一个包之后，取出解码器中剩余的帧
+                applyDiscard(false);
+                avcodec_send_packet(codec_ctx_, nullptr);
+                draining = true;
+            }
+            else
+            {
+                if (demuxer_.getLastStatus() == DemuxStatus::AGAIN)
+                {
+                    LOG_ERROR << "Too many packets pending for other consumers while decoding to the target.";
+                }
+                failed = true;
+                break;
+            }
+        }
+
+        while (true)
+        {
+            int ret = avcodec_receive_frame(codec_ctx_, decoded_);
+            if (ret == AVERROR(EAGAIN))
+            {
+                break;
+            }
+            if (ret == AVERROR_EOF)
+            {
+                // 解码器已经取空，最后一帧还留在frame中
+                found = true;
+                break;
+            }
+            if (ret < 0)
+            {
+                LOG_ERROR << "Error decoding frame: " << errorString(ret);
+                failed = true;
+                break;
+            }
+            last_stats_.frames_decoded++;
+            // 丢掉的帧只是移动引用，保留最近的一帧作为目标超出文件末尾时的结果，不做任何转换
+            av_frame_unref(frame);
+            av_frame_move_ref(frame, decoded_);
+            if (reachesTarget(frame, target))
+            {
+                found = true;
+                break;
+            }
+            last_stats_.frames_discarded++;
+        }
+    }
+    // 之后继续往后解码的帧都需要完整输出
+    applyDiscard(false);
+    if (failed || !frame->data[0])
+    {
+        av_frame_unref(frame);
+        if (!failed)
+        {
+            LOG_ERROR << "No frame decoded after seeking to " << timestamp << "us.";
+        }
+        return false;
+    }
+    last_stats_.frame_pts = frameTimestamp(frame);
+    last_stats_.decode_us = elapsedMicroseconds(decode_start);
+    last_stats_.total_us = elapsedMicroseconds(start);
+    return true;
+}
+
+// 目标之前的非参考帧不会被输出，也不会被其他帧引用，可以直接跳过解码；参考帧一定要解码
+// 环路滤波同样只对非参考帧跳过，参考帧跳过环路滤波会把误差传给目标帧；
+// 两个都打开时非参考帧已经不解码，skip_loop_filter不起作用，只在关闭skip_nonref时解码这些帧但省掉滤波
+void AccurateSeeker::applyDiscard(bool before_target)
+{
+    codec_ctx_->skip_frame = before_target && options_.skip_nonref ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    codec_ctx_->skip_loop_filter = before_target && options_.skip_loop_filter ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+}
+
+// 帧的显示区间[pts, pts + duration)包含目标或者已经在目标之后
+bool AccurateSeeker::reachesTarget(const AVFrame *frame, int64_t target) const
+{
+    int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    if (pts == AV_NOPTS_VALUE)
+    {
+        // 没有时间戳无法判断，直接返回这一帧
+        return true;
+    }
+    int64_t duration = frame->duration > 0 ? frame->duration : frame_duration_;
+    return duration > 0 ? pts + duration > target : pts >= target;
+}
+
+int64_t AccurateSeeker::frameTimestamp(const AVFrame *frame) const
+{
+    int64_t pts = frame->best_effort_timestamp != AV_NOPTS_VALUE ? frame->best_effort_timestamp : frame->pts;
+    return pts == AV_NOPTS_VALUE ? AV_NOPTS_VALUE : av_rescale_q(pts, stream_->time_base, AV_TIME_BASE_Q);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/frame.h>
+}
+
+#include <cstdint>
+
+class Demuxer;
+
+// 精确定位的选项
+struct AccurateSeekOptions
+{
+    bool skip_nonref = true;      // 目标之前的非参考帧不解码（AVDISCARD_NONREF），它们不会被其他帧引用，也不会被输出
+    // 目标之前的非参考帧跳过环路滤波，不会让后面的帧产生误差
+    // skip_nonref为true时这些帧已经整个不解码，这个选项只在skip_nonref为false时才起作用
+    bool skip_loop_filter = true;
+    int threads = 0;              // 解码线程数，0表示由FFmpeg自动选择
+};
+
+// 一次精确定位的统计
+struct AccurateSeekStats
+{
+    int64_t seek_us = 0;          // 容器定位到关键帧的耗时（微秒）
+    int64_t decode_us = 0;        // 从关键帧解码到目标帧的耗时（微秒）
+    int64_t total_us = 0;         // 总耗时（微秒）
+    int packets_sent = 0;         // 送进解码器的包数
+    int frames_decoded = 0;       // 解码器输出的帧数
+    int frames_discarded = 0;     // 目标之前被丢掉的帧数
+    int64_t keyframe_pts = AV_NOPTS_VALUE; // 落在的关键帧的时间戳（微秒），读到第一个包之后才知道
+    int64_t frame_pts = AV_NOPTS_VALUE;    // 返回的帧的时间戳（微秒）
+};
+
+// 精确定位：先定位到目标之前的关键帧，再往后解码，丢掉目标之前的帧，返回显示区间覆盖目标时间的那一帧
+// 丢掉的帧不做任何格式转换；目标之前的非参考帧可以直接跳过解码和环路滤波，参考帧必须完整解码，否则目标帧会出现花屏
+// 使用Demuxer的视频流，解码器上下文由AccurateSeeker持有；与其他消费者共用一个Demuxer时，定位会改变它们的读取位置
+// 多流模式下往后解码时读到的其他类型的包会暂存，超过PendingPacketOptions的上限时seek()失败
+class AccurateSeeker
+{
+public:
+    // demuxer需要已经打开并且比AccurateSeeker活得更久
+    explicit AccurateSeeker(Demuxer &demuxer);
+    ~AccurateSeeker();
+
+    AccurateSeeker(const AccurateSeeker &) = delete;
+    AccurateSeeker &operator=(const AccurateSeeker &) = delete;
+
+    // 为Demuxer的视频流打开解码器，失败返回false
+    bool open(const AccurateSeekOptions &options = AccurateSeekOptions());
+    void close();
+    bool isOpen() const { return codec_ctx_ != nullptr; }
+
+    // 定位到timestamp（微秒），把显示区间覆盖目标时间的帧放入frame（frame中原来的数据会被释放）
+    // 目标超出最后一帧时返回最后一帧；定位或解码失败返回false
+    // 返回之后Demuxer停在目标帧之后的位置，调用者可以继续读包并送入getCodecContext()接着往后解码
+    bool seek(int64_t timestamp, AVFrame *frame);
+
+    // 最近一次seek()的统计
+    const AccurateSeekStats &getLastStats() const { return last_stats_; }
+    // 解码器上下文，调用者可以继续用它往后解码
+    AVCodecContext *getCodecContext() const { return codec_ctx_; }
+
+private:
+    // 根据下一个包是否在目标之前设置跳过规则
+    void applyDiscard(bool before_target);
+    // 帧的显示区间是否已经到达目标（流的时间基）
+    bool reachesTarget(const AVFrame *frame, int64_t target) const;
+    // 把帧的时间戳转换成微秒
+    int64_t frameTimestamp(const AVFrame *frame) const;
+
+    Demuxer &demuxer_;
+    AVStream *stream_;              // Demuxer的视频流
+    AVCodecContext *codec_ctx_;     // 解码器上下文
+    AVPacket *packet_;              // 复用的包
+    AVFrame *decoded_;              // 复用的解码帧
+    AccurateSeekOptions options_;   // open()的选项
+    int64_t frame_duration_;        // 按帧率估算的一帧时长（流的时间基），帧本身没有时长时使用
+    AccurateSeekStats last_stats_;  // 最近一次seek()的统计
+};
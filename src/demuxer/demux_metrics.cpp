@@ -0,0 +1,85 @@
+#include "demux_metrics.hpp"
+
+// 找到累计样本数达到p的桶，返回它的上界
+int64_t LatencyHistogram::percentileNs(double p) const
+{
+    if (count <= 0)
+    {
+        return 0;
+    }
+    int64_t target = static_cast<int64_t>(p * count);
+    if (target >= count)
+    {
+        target = count - 1;
+    }
+    int64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += buckets[i];
+        if (seen > target)
+        {
+            return (int64_t(1) << (i + 1)) - 1;
+        }
+    }
+    return (int64_t(1) << BUCKET_COUNT) - 1;
+}
+
+void DemuxMetrics::reset()
+{
+    for (Counter *counter : {&packets_read_, &bytes_read_, &packets_delivered_, &bytes_delivered_,
+                             &packets_discarded_, &bytes_discarded_, &read_errors_})
+    {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    resetHistogram(read_latency_);
+    resetHistogram(seek_latency_);
+    for (Stream &stream : streams_)
+    {
+        stream.packets_read.store(0, std::memory_order_relaxed);
+        stream.bytes_read.store(0, std::memory_order_relaxed);
+        stream.packets_discarded.store(0, std::memory_order_relaxed);
+        stream.bytes_discarded.store(0, std::memory_order_relaxed);
+    }
+}
+
+DemuxMetricsSnapshot DemuxMetrics::snapshot() const
+{
+    DemuxMetricsSnapshot snapshot;
+    snapshot.packets_read = packets_read_.load(std::memory_order_relaxed);
+    snapshot.bytes_read = bytes_read_.load(std::memory_order_relaxed);
+    snapshot.packets_delivered = packets_delivered_.load(std::memory_order_relaxed);
+    snapshot.bytes_delivered = bytes_delivered_.load(std::memory_order_relaxed);
+    snapshot.packets_discarded = packets_discarded_.load(std::memory_order_relaxed);
+    snapshot.bytes_discarded = bytes_discarded_.load(std::memory_order_relaxed);
+    snapshot.read_errors = read_errors_.load(std::memory_order_relaxed);
+    copyHistogram(read_latency_, snapshot.read_latency);
+    copyHistogram(seek_latency_, snapshot.seek_latency);
+    for (int i = 0; i < DemuxMetricsSnapshot::MAX_STREAMS; i++)
+    {
+        snapshot.streams[i].packets_read = streams_[i].packets_read.load(std::memory_order_relaxed);
+        snapshot.streams[i].bytes_read = streams_[i].bytes_read.load(std::memory_order_relaxed);
+        snapshot.streams[i].packets_discarded = streams_[i].packets_discarded.load(std::memory_order_relaxed);
+        snapshot.streams[i].bytes_discarded = streams_[i].bytes_discarded.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void DemuxMetrics::resetHistogram(Histogram &histogram)
+{
+    for (Counter &bucket : histogram.buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    histogram.count.store(0, std::memory_order_relaxed);
+    histogram.total_ns.store(0, std::memory_order_relaxed);
+}
+
+void DemuxMetrics::copyHistogram(const Histogram &histogram, LatencyHistogram &out)
+{
+    for (int i = 0; i < LatencyHistogram::BUCKET_COUNT; i++)
+    {
+        out.buckets[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+    }
+    out.count = histogram.count.load(std::memory_order_relaxed);
+    out.total_ns = histogram.total_ns.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// 以2为底按对数分桶的延迟直方图的快照，第i个桶统计[2^i, 2^(i+1))纳秒的样本，第0个桶还包括0
+struct LatencyHistogram
+{
+    static constexpr int BUCKET_COUNT = 40; // 最大约18分钟，足够覆盖任何一次读取
+    std::array<int64_t, BUCKET_COUNT> buckets{};
+    int64_t count = 0;
+    int64_t total_ns = 0;
+
+    // 估算分位数（纳秒），返回样本所在桶的上界，p取0到1
+    int64_t percentileNs(double p) const;
+    int64_t meanNs() const { return count > 0 ? total_ns / count : 0; }
+};
+
+// 单个流的包计数
+struct StreamMetrics
+{
+    int64_t packets_read = 0;      // av_read_frame读出的包数
+    int64_t bytes_read = 0;        // av_read_frame读出的字节数
+    int64_t packets_discarded = 0; // 读出后被丢掉的包数
+    int64_t bytes_discarded = 0;   // 读出后被丢掉的字节数
+};
+
+// Demuxer热路径统计的快照
+struct DemuxMetricsSnapshot
+{
+    static constexpr int MAX_STREAMS = 16; // 流索引不小于MAX_STREAMS的包计入最后一项
+    int64_t packets_read = 0;
+    int64_t bytes_read = 0;
+    int64_t packets_delivered = 0; // 属于被选中的流、交给调用者的包数
+    int64_t bytes_delivered = 0;
+    int64_t packets_discarded = 0;
+    int64_t bytes_discarded = 0;
+    int64_t read_errors = 0; // EOF之外的读取错误次数
+    LatencyHistogram read_latency; // av_read_frame的耗时，total_ns就是阻塞在读取上的总时间
+    LatencyHistogram seek_latency; // seek()的耗时，count就是定位次数
+    std::array<StreamMetrics, MAX_STREAMS> streams{};
+
+    // 被丢掉的包占读出的包的比例
+    double discardRatio() const { return packets_read > 0 ? static_cast<double>(packets_discarded) / packets_read : 0.0; }
+};
+
+// Demuxer热路径上的计数器和延迟直方图
+// 所有记录都在Demuxer的mutex_保护下进行，只有一个写者，所以计数器用relaxed的load+store更新，不需要带锁前缀的原子加
+// 其他线程随时可以无锁地调用snapshot()，各个计数器各自是准确的，但彼此之间不保证是同一时刻的值
+class DemuxMetrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // av_read_frame返回之后调用
+    void recordRead(Clock::time_point start, int stream_index, int size)
+    {
+        addLatency(read_latency_, elapsedNs(start));
+        add(packets_read_, 1);
+        add(bytes_read_, size);
+        Stream &stream = streams_[streamSlot(stream_index)];
+        add(stream.packets_read, 1);
+        add(stream.bytes_read, size);
+    }
+
+    void recordReadError(Clock::time_point start)
+    {
+        addLatency(read_latency_, elapsedNs(start));
+        add(read_errors_, 1);
+    }
+
+    void recordDelivered(int size)
+    {
+        add(packets_delivered_, 1);
+        add(bytes_delivered_, size);
+    }
+
+    void recordDiscarded(int stream_index, int size)
+    {
+        add(packets_discarded_, 1);
+        add(bytes_discarded_, size);
+        Stream &stream = streams_[streamSlot(stream_index)];
+        add(stream.packets_discarded, 1);
+        add(stream.bytes_discarded, size);
+    }
+
+    void recordSeek(Clock::time_point start) { addLatency(seek_latency_, elapsedNs(start)); }
+
+    // 清零所有计数，同样只能由写者调用
+    void reset();
+    // 无锁读取当前的统计
+    DemuxMetricsSnapshot snapshot() const;
+
+private:
+    using Counter = std::atomic<int64_t>;
+
+    struct Stream
+    {
+        Counter packets_read{0};
+        Counter bytes_read{0};
+        Counter packets_discarded{0};
+        Counter bytes_discarded{0};
+    };
+
+    struct Histogram
+    {
+        std::array<Counter, LatencyHistogram::BUCKET_COUNT> buckets{};
+        Counter count{0};
+        Counter total_ns{0};
+    };
+
+    static void add(Counter &counter, int64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static int64_t elapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    // 桶号是纳秒数的二进制位数减一
+    static void addLatency(Histogram &histogram, int64_t ns)
+    {
+        int bucket = ns > 1 ? 63 - __builtin_clzll(static_cast<unsigned long long>(ns)) : 0;
+        if (bucket >= LatencyHistogram::BUCKET_COUNT)
+        {
+            bucket = LatencyHistogram::BUCKET_COUNT - 1;
+        }
+        add(histogram.buckets[bucket], 1);
+        add(histogram.count, 1);
+        add(histogram.total_ns, ns);
+    }
+
+    static int streamSlot(int stream_index)
+    {
+        if (stream_index < 0 || stream_index >= DemuxMetricsSnapshot::MAX_STREAMS)
+        {
+            return DemuxMetricsSnapshot::MAX_STREAMS - 1;
+        }
+        return stream_index;
+    }
+
+    static void resetHistogram(Histogram &histogram);
+    static void copyHistogram(const Histogram &histogram, LatencyHistogram &out);
+
+    Counter packets_read_{0};
+    Counter bytes_read_{0};
+    Counter packets_delivered_{0};
+    Counter bytes_delivered_{0};
+    Counter packets_discarded_{0};
+    Counter bytes_discarded_{0};
+    Counter read_errors_{0};
+    Histogram read_latency_;
+    Histogram seek_latency_;
+    std::array<Stream, DemuxMetricsSnapshot::MAX_STREAMS> streams_;
+};
@@ -2,12 +2,74 @@
 
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+// 与MediaType对应的FFmpeg流类型
+AVMediaType toAVMediaType(MediaType type)
+{
+    switch (type)
+    {
+    case MediaType::VIDEO:
+        return AVMEDIA_TYPE_VIDEO;
+    case MediaType::AUDIO:
+        return AVMEDIA_TYPE_AUDIO;
+    case MediaType::SUBTITLE:
+        return AVMEDIA_TYPE_SUBTITLE;
+    default:
+        return AVMEDIA_TYPE_DATA;
+    }
+}
+
+// FFmpeg流类型对应的MediaType，附件等其他类型归为DATA
+MediaType fromAVMediaType(AVMediaType type)
+{
+    switch (type)
+    {
+    case AVMEDIA_TYPE_VIDEO:
+        return MediaType::VIDEO;
+    case AVMEDIA_TYPE_AUDIO:
+        return MediaType::AUDIO;
+    case AVMEDIA_TYPE_SUBTITLE:
+        return MediaType::SUBTITLE;
+    default:
+        return MediaType::DATA;
+    }
+}
+}
+
 // 构造函数，根据多媒体类型来进行初始化
 Demuxer::Demuxer(MediaType type)
-    : format_ctx_(nullptr), type_(type), video_stream_(nullptr), audio_stream_(nullptr),
-      video_stream_index_(-1), audio_stream_index_(-1), eof_file_(false)
+    : type_(type), multi_stream_(false), format_ctx_(nullptr), video_stream_(nullptr), audio_stream_(nullptr),
+      video_stream_index_(-1), audio_stream_index_(-1), opened_video_stream_index_(-1),
+      opened_audio_stream_index_(-1), subtitle_stream_(nullptr), data_stream_(nullptr),
+      subtitle_stream_index_(-1), data_stream_index_(-1), eof_file_(false), pending_bytes_(),
+      probe_cache_(nullptr), packet_pool_(nullptr), demuxer_pool_(nullptr), streams_discarded_(0),
+      index_stream_index_(-1), index_abort_(false), index_cache_enabled_(false),
+      read_error_(0), last_status_(DemuxStatus::OK), read_ahead_queue_(0, 0, 0), read_ahead_abort_(false), read_ahead_running_(false), seek_pending_(false), pending_seek_timestamp_(0),
+      pending_seek_flags_(0), pending_seek_id_(0), pending_seek_deferred_(false), seek_serial_(0),
+      gop_start_pts_(AV_NOPTS_VALUE), gop_max_pts_(AV_NOPTS_VALUE), indexed_keyframe_pts_(AV_NOPTS_VALUE)
+{
+    LOG_INFO << "Demuxer initialized for type: " << mediaTypeName(type);
+}
+
+// 多流模式的构造函数，视频和音频共用一次打开和探测
+Demuxer::Demuxer()
+    : type_(MediaType::VIDEO), multi_stream_(true), format_ctx_(nullptr), video_stream_(nullptr), audio_stream_(nullptr),
+      video_stream_index_(-1), audio_stream_index_(-1), opened_video_stream_index_(-1),
+      opened_audio_stream_index_(-1), subtitle_stream_(nullptr), data_stream_(nullptr),
+      subtitle_stream_index_(-1), data_stream_index_(-1), eof_file_(false), pending_bytes_(),
+      probe_cache_(nullptr), packet_pool_(nullptr), demuxer_pool_(nullptr), streams_discarded_(0),
+      index_stream_index_(-1), index_abort_(false), index_cache_enabled_(false),
+      read_error_(0), last_status_(DemuxStatus::OK), read_ahead_queue_(0, 0, 0), read_ahead_abort_(false), read_ahead_running_(false), seek_pending_(false), pending_seek_timestamp_(0),
+      pending_seek_flags_(0), pending_seek_id_(0), pending_seek_deferred_(false), seek_serial_(0),
+      gop_start_pts_(AV_NOPTS_VALUE), gop_max_pts_(AV_NOPTS_VALUE), indexed_keyframe_pts_(AV_NOPTS_VALUE)
 {
-    LOG_INFO << "Demuxer initialized for type: " << (type == MediaType::VIDEO ? "VIDEO" : "AUDIO");
+    LOG_INFO << "Demuxer initialized for VIDEO and AUDIO.";
 }
 
 // 析构函数
@@ -25,124 +87,1282 @@ bool Demuxer::open(const std::string &filename)
     // 检查文件名是否为空
     if (filename.empty())
     {
-        LOG_ERROR << "Filename is empty.";
+        LOG_ERROR << "Filename is empty.";
+        return false;
+    }
+
+    // 确保之前的资源已经释放
+    if (format_ctx_)
+    {
+        LOG_WARN << "Demuxer already initialized. Closing previous context.";
+        close();
+    }
+
+    // close()之后仍然保留上一次读取的结果，方便被打断的读取线程查询，重新打开时才清除
+    last_status_ = DemuxStatus::OK;
+    open_timing_ = OpenTiming();
+    auto open_start = std::chrono::steady_clock::now();
+
+    // 缓存中有同一个文件、同样打开选项的上下文时直接接管，不需要重新打开和探测
+    pool_options_key_ = poolOptionsKey();
+    open_timing_.pool_hit = demuxer_pool_ && adoptPooledContext(filename);
+
+    // 快速打开模式下限制探测的字节数和时长
+    if (!open_timing_.pool_hit && !openContext(filename, open_options_.fast_open))
+    {
+        return false;
+    }
+
+    // 限制探测后关键的编解码参数不完整时，退回完整探测重新打开
+    if (!open_timing_.pool_hit && open_options_.fast_open && open_options_.full_probe_fallback && !hasCompleteCodecParameters())
+    {
+        LOG_WARN << "Codec parameters incomplete after fast open, falling back to full probe.";
+        close();
+        open_timing_.full_probe_fallback = true;
+        if (!openContext(filename, false))
+        {
+            return false;
+        }
+    }
+    // 放回缓存的上下文沿用打开时选出的流，之后切换音轨不影响下一次打开
+    opened_video_stream_index_ = video_stream_index_;
+    opened_audio_stream_index_ = audio_stream_index_;
+
+    // 其余的流（多流模式下没有选中的字幕和数据、其他语言的音轨、封面图片以及单流模式下不需要的类型）都交给libavformat跳过
+    discardUnusedStreams();
+    captureStreamTiming();
+
+    // 关键帧索引针对定位使用的流
+    filename_ = filename;
+    index_stream_index_ = getStreamIndex();
+    // 有未过期的索引文件时直接映射使用，不需要再扫描
+    if (index_cache_enabled_)
+    {
+        SeekIndexKey key;
+        if (makeSeekIndexKey(key))
+        {
+            seek_index_.load(seekIndexPath(), key);
+        }
+    }
+
+    open_timing_.total_us = elapsedMicroseconds(open_start);
+    LOG_INFO << "Demuxer opened in " << open_timing_.total_us << "us (open_input: " << open_timing_.open_input_us
+             << "us, find_stream_info: " << open_timing_.find_stream_info_us
+             << "us, select_streams: " << open_timing_.select_streams_us << "us)";
+
+    // 查找成功返回true
+    return true;
+}
+
+// 接管缓存的上下文，它已经回到了文件开头，流的选择沿用上次打开时的结果
+bool Demuxer::adoptPooledContext(const std::string &filename)
+{
+    std::unique_ptr<PooledContext> context = demuxer_pool_->acquire(filename, pool_options_key_);
+    if (!context)
+    {
+        return false;
+    }
+    format_ctx_ = context->format_ctx;
+    context->format_ctx = nullptr;
+    mmap_io_ = std::move(context->mmap_io);
+    uring_io_ = std::move(context->uring_io);
+    io_link_ = std::move(context->io_link);
+    io_link_->target = &io_interrupt_;
+    video_stream_index_ = validStreamIndex(context->video_stream_index, AVMEDIA_TYPE_VIDEO);
+    audio_stream_index_ = validStreamIndex(context->audio_stream_index, AVMEDIA_TYPE_AUDIO);
+    video_stream_ = video_stream_index_ >= 0 ? format_ctx_->streams[video_stream_index_] : nullptr;
+    audio_stream_ = audio_stream_index_ >= 0 ? format_ctx_->streams[audio_stream_index_] : nullptr;
+    selectSparseStreams();
+    LOG_INFO << "Reusing pooled format context for " << filename;
+    return true;
+}
+
+// 把当前的上下文交给缓存，调用者需要持有mutex_
+void Demuxer::releaseToPool()
+{
+    std::unique_ptr<PooledContext> context(new PooledContext());
+    context->filename = filename_;
+    context->options_key = pool_options_key_; // 打开之后修改的选项不影响这个上下文
+    context->format_ctx = format_ctx_;
+    context->io_link = std::move(io_link_);
+    context->mmap_io = std::move(mmap_io_);
+    context->uring_io = std::move(uring_io_);
+    context->video_stream_index = opened_video_stream_index_;
+    context->audio_stream_index = opened_audio_stream_index_;
+    format_ctx_ = nullptr;
+    demuxer_pool_->release(std::move(context));
+}
+
+// 快速打开的探测预算决定了探测出的流信息，自定义IO决定了上下文的pb；io_timeout_us只作用于本次的中断回调，不影响上下文
+std::string Demuxer::poolOptionsKey() const
+{
+    std::ostringstream key;
+    key << "fast=" << open_options_.fast_open;
+    if (open_options_.fast_open)
+    {
+        key << ",probe=" << open_options_.probe_size << ",analyze=" << open_options_.analyze_duration
+            << ",fallback=" << open_options_.full_probe_fallback;
+    }
+    if (open_options_.use_mmap)
+    {
+        key << ",io=mmap";
+    }
+    else if (open_options_.use_uring)
+    {
+        key << ",io=uring," << open_options_.uring_queue_depth << "x" << open_options_.uring_block_size;
+    }
+    return key.str();
+}
+
+// 本地文件使用自定义IO时，需要先分配format_ctx_并设置pb，libavformat不会关闭自定义的IO
+void Demuxer::setupCustomIO(const std::string &filename)
+{
+    std::string path;
+    if (!(open_options_.use_mmap || open_options_.use_uring) || !MmapIO::isLocalPath(filename, path))
+    {
+        return;
+    }
+    AVIOContext *pb = nullptr;
+    if (open_options_.use_mmap)
+    {
+        auto io = std::make_unique<MmapIO>();
+        if (io->open(path))
+        {
+            pb = io->getAVIOContext();
+            mmap_io_ = std::move(io);
+        }
+        else
+        {
+            LOG_WARN << "Memory mapping unavailable for " << filename << ", using default IO.";
+        }
+    }
+    else
+    {
+        auto io = std::make_unique<UringIO>();
+        if (io->open(path, open_options_.uring_queue_depth, open_options_.uring_block_size))
+        {
+            pb = io->getAVIOContext();
+            uring_io_ = std::move(io);
+        }
+        else
+        {
+            LOG_WARN << "Failed to open " << filename << " for io_uring, using default IO.";
+        }
+    }
+    if (!pb)
+    {
+        return;
+    }
+    format_ctx_ = avformat_alloc_context();
+    if (!format_ctx_)
+    {
+        mmap_io_.reset();
+        uring_io_.reset();
+        return;
+    }
+    format_ctx_->pb = pb;
+    format_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+}
+
+// 打开文件、探测流信息并选出最佳的视频流和音频流，各阶段耗时累加到open_timing_
+// limit_probe为true时使用open_options_中的探测预算
+bool Demuxer::openContext(const std::string &filename, bool limit_probe)
+{
+    // 探测预算通过选项字典传给avformat_open_input，它会同时作用于avformat_find_stream_info
+    AVDictionary *options = nullptr;
+    if (limit_probe)
+    {
+        if (open_options_.probe_size > 0)
+        {
+            av_dict_set_int(&options, "probesize", open_options_.probe_size, 0);
+        }
+        if (open_options_.analyze_duration > 0)
+        {
+            av_dict_set_int(&options, "analyzeduration", open_options_.analyze_duration, 0);
+        }
+    }
+
+    // 打开媒体文件
+    // 它会探测文件格式并填充format_ctx_，执行完后fomat_ctx_会包含媒体文件的基本信息
+    // 参数：AVFormatContext* 的指针地址，媒体文件路径，指定的输入格式（nullptr表示自动探测），以及可选的字典参数
+    auto stage_start = std::chrono::steady_clock::now();
+    setupCustomIO(filename);
+    // 预先分配上下文才能在打开之前装上中断回调，seek()和close()可以打断阻塞的IO
+    if (!format_ctx_ && !(format_ctx_ = avformat_alloc_context()))
+    {
+        LOG_ERROR << "Failed to allocate format context.";
+        av_dict_free(&options);
+        return false;
+    }
+    io_link_.reset(new IOInterruptLink(&io_interrupt_));
+    format_ctx_->interrupt_callback.callback = &IOInterruptLink::callback;
+    format_ctx_->interrupt_callback.opaque = io_link_.get();
+    armIODeadline();
+    int ret = avformat_open_input(&format_ctx_, filename.c_str(), nullptr, &options);
+    disarmIODeadline();
+    av_dict_free(&options); // 未被使用的选项留在字典里，一并释放
+    open_timing_.open_input_us += elapsedMicroseconds(stage_start);
+    if (ret < 0)
+    {
+        // 打开失败时format_ctx_已经被释放
+        mmap_io_.reset();
+        uring_io_.reset();
+        LOG_ERROR << "Failed to open media file: " << filename;
+        return false; // 打开失败，返回false
+    }
+
+    // 探测缓存命中时直接把缓存的编解码参数填回流中，跳过耗时的avformat_find_stream_info
+    ProbeResult cached;
+    bool cache_hit = probe_cache_ && probe_cache_->lookup(filename, cached) && ProbeCache::apply(cached, format_ctx_);
+    open_timing_.probe_cache_hit = cache_hit;
+
+    // 查找流信息
+    // 读取文件开头的部分数据，解析并填充到streams数组中
+    // 通常包括编解码参数、时长、码率等详细信息
+    // 第二个参数是用来传递额外选项的
+    if (!cache_hit)
+    {
+        stage_start = std::chrono::steady_clock::now();
+        armIODeadline();
+        ret = avformat_find_stream_info(format_ctx_, nullptr);
+        disarmIODeadline();
+        open_timing_.find_stream_info_us += elapsedMicroseconds(stage_start);
+        if (ret < 0)
+        {
+            LOG_ERROR << "Could not find stream information in file: " << filename;
+            close();      // 关闭demuxer
+            return false; // 查找流信息失败，返回false
+        }
+    }
+
+    stage_start = std::chrono::steady_clock::now();
+    if (cache_hit)
+    {
+        // 使用缓存中上次选出的流
+        video_stream_index_ = validStreamIndex(cached.video_stream_index, AVMEDIA_TYPE_VIDEO);
+        audio_stream_index_ = validStreamIndex(cached.audio_stream_index, AVMEDIA_TYPE_AUDIO);
+    }
+    else
+    {
+        // 查找最佳视频流
+        // 第三和第四个参数通常用于指定首选流和相关流，这里不指定，第五个参数用来指定编解码器，nullptr表示不指定，最后一个为查找选项
+        video_stream_index_ = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        // 查找最佳音频流
+        audio_stream_index_ = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    }
+    // 如果找到视频流
+    if (video_stream_index_ >= 0)
+    {
+        video_stream_ = format_ctx_->streams[video_stream_index_]; // 获取视频流
+        LOG_INFO << "Video stream found at index: " << video_stream_index_;
+    }
+    else
+    {
+        LOG_WARN << "No video stream found in file: " << filename;
+    }
+
+    // 如果找到音频流
+    if (audio_stream_index_ >= 0)
+    {
+        audio_stream_ = format_ctx_->streams[audio_stream_index_]; // 获取音频流
+        LOG_INFO << "Audio stream found at index: " << audio_stream_index_;
+    }
+    else
+    {
+        LOG_WARN << "No audio stream found in file: " << filename;
+    }
+    selectSparseStreams();
+
+    // 完整的探测结果写入缓存，供下次打开同一文件时使用
+    if (probe_cache_ && !cache_hit && hasCompleteCodecParameters())
+    {
+        probe_cache_->store(filename, ProbeCache::capture(format_ctx_, video_stream_index_, audio_stream_index_));
+    }
+    open_timing_.select_streams_us += elapsedMicroseconds(stage_start);
+    return true;
+}
+
+// 字幕和数据流不进探测缓存，每次打开时重新选
+// 多流模式下默认只输出音视频，字幕和数据流由调用者通过selectTrack()选中，避免没人读的稀疏流包一直堆在暂存队列里
+void Demuxer::selectSparseStreams()
+{
+    subtitle_stream_index_ = -1;
+    data_stream_index_ = -1;
+    subtitle_stream_ = nullptr;
+    data_stream_ = nullptr;
+    if (multi_stream_ || !isSparseMediaType(type_))
+    {
+        return;
+    }
+    // 数据流没有对应的解码器，av_find_best_stream按流的顺序取第一个
+    int &index = (type_ == MediaType::SUBTITLE) ? subtitle_stream_index_ : data_stream_index_;
+    index = av_find_best_stream(format_ctx_, toAVMediaType(type_), -1, -1, nullptr, 0);
+    if (index >= 0)
+    {
+        (type_ == MediaType::SUBTITLE ? subtitle_stream_ : data_stream_) = format_ctx_->streams[index];
+        LOG_INFO << mediaTypeName(type_) << " stream found at index: " << index;
+    }
+    else
+    {
+        LOG_WARN << "No " << mediaTypeName(type_) << " stream found in file: " << format_ctx_->url;
+    }
+}
+
+// 多流模式下任意一种类型有流就可以读，单流模式下要有构造时指定类型的流
+bool Demuxer::hasOutputStream() const
+{
+    if (!multi_stream_)
+    {
+        return getStreamIndex() >= 0;
+    }
+    for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+    {
+        if (getStreamIndex(static_cast<MediaType>(i)) >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 检查缓存中的流索引是否有效且类型正确，无效时返回负数
+int Demuxer::validStreamIndex(int stream_index, AVMediaType type) const
+{
+    if (stream_index < 0 || stream_index >= static_cast<int>(format_ctx_->nb_streams) ||
+        format_ctx_->streams[stream_index]->codecpar->codec_type != type)
+    {
+        return AVERROR_STREAM_NOT_FOUND;
+    }
+    return stream_index;
+}
+
+// 检查需要输出的流的编解码参数是否足够用来初始化解码器
+bool Demuxer::hasCompleteCodecParameters() const
+{
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
+    {
+        MediaType type;
+        if (!mediaTypeOf(static_cast<int>(i), type))
+        {
+            continue;
+        }
+        const AVCodecParameters *par = format_ctx_->streams[i]->codecpar;
+        if (par->codec_id == AV_CODEC_ID_NONE)
+        {
+            return false;
+        }
+        // 视频需要分辨率和像素格式，音频需要采样率、声道数和采样格式
+        if (type == MediaType::VIDEO && (par->width <= 0 || par->height <= 0 || par->format < 0))
+        {
+            return false;
+        }
+        if (type == MediaType::AUDIO && (par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0 || par->format < 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 返回从start到现在经过的微秒数
+int64_t Demuxer::elapsedMicroseconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 从媒体文件中读取目标流的下一个包，返回新分配的AVPacket
+AVPacket *Demuxer::readPacket()
+{
+    AVPacket *packet = av_packet_alloc(); // 只为返回给调用者的包分配一次
+    if (!packet)
+    {
+        LOG_ERROR << "Failed to allocate packet.";
+        return nullptr;
+    }
+    if (!readPacket(packet))
+    {
+        av_packet_free(&packet); // 释放AVPacket
+        return nullptr;          // 返回nullptr表示读取失败或到达文件末尾
+    }
+    return packet;
+}
+
+// 返回自动释放的句柄
+PacketPtr Demuxer::readPacketPtr()
+{
+    return PacketPtr(readPacket());
+}
+
+// 从媒体文件中循环读取数据包，过滤出目标流的包并填入调用者提供的packet
+// 非目标流的包只unref数据，packet结构体本身一直复用，稳态下不会分配新的AVPacket
+// 多流模式下视频和音频的包都会返回，由调用者根据stream_index分发
+bool Demuxer::readPacket(AVPacket *packet)
+{
+    // 异步预读模式下从队列中取，一直等到有包、EOF或出错
+    if (read_ahead_running_)
+    {
+        return popPacket(packet, -1) == DemuxStatus::OK;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 确保上下文初始化
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return false; // 如果没有初始化，返回false
+    }
+    if (!packet)
+    {
+        LOG_ERROR << "Packet is null.";
+        return false;
+    }
+    // 检查是否有可以输出的流
+    if (!hasOutputStream())
+    {
+        LOG_ERROR << "No valid stream index found.";
+        return false; // 如果没有有效的流索引，返回false
+    }
+
+    // 丢弃调用者上一次使用后残留的数据
+    av_packet_unref(packet);
+    applyPendingSeek();
+    return readSelectedPacket(packet);
+}
+
+// 一次读取最多max_count个包，整批只加一次锁
+int Demuxer::readPackets(AVPacket **packets, int max_count, int64_t max_bytes)
+{
+    if (!packets || max_count <= 0)
+    {
+        return 0;
+    }
+    // 异步预读模式下第一个包阻塞等待，之后只取队列中已经有的包
+    if (read_ahead_running_)
+    {
+        int count = 0;
+        int64_t bytes = 0;
+        while (count < max_count && (max_bytes <= 0 || bytes < max_bytes) &&
+               popPacket(packets[count], count == 0 ? -1 : 0) == DemuxStatus::OK)
+        {
+            bytes += packets[count]->size;
+            count++;
+        }
+        return count;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return 0;
+    }
+    if (!hasOutputStream())
+    {
+        LOG_ERROR << "No valid stream index found.";
+        return 0;
+    }
+
+    applyPendingSeek();
+    int count = 0;
+    int64_t bytes = 0;
+    while (count < max_count && (max_bytes <= 0 || bytes < max_bytes))
+    {
+        AVPacket *packet = packets[count];
+        av_packet_unref(packet);
+        if (!readSelectedPacket(packet))
+        {
+            break; // EOF或出错，已经读到的包照常返回
+        }
+        bytes += packet->size;
+        count++;
+    }
+    return count;
+}
+
+// 多流模式下一次读取最多max_count个指定类型的包，其他类型的包转入各自的暂存队列
+int Demuxer::readPackets(MediaType type, AVPacket **packets, int max_count, int64_t max_bytes)
+{
+    if (!packets || max_count <= 0)
+    {
+        return 0;
+    }
+    if (read_ahead_running_ && multi_stream_)
+    {
+        LOG_ERROR << "Typed reads are not available while read-ahead is running.";
+        return 0;
+    }
+    if (!multi_stream_)
+    {
+        if (type != type_)
+        {
+            LOG_ERROR << "Demuxer only serves " << mediaTypeName(type_) << " packets.";
+            return 0;
+        }
+        return readPackets(packets, max_count, max_bytes);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return 0;
+    }
+    if (getStreamIndex(type) < 0)
+    {
+        LOG_ERROR << "No " << mediaTypeName(type) << " stream found.";
+        return 0;
+    }
+
+    applyPendingSeek();
+    int count = 0;
+    int64_t bytes = 0;
+    while (count < max_count && (max_bytes <= 0 || bytes < max_bytes))
+    {
+        AVPacket *packet = packets[count];
+        av_packet_unref(packet);
+        if (!readTypedPacket(type, packet))
+        {
+            break;
+        }
+        bytes += packet->size;
+        count++;
+    }
+    return count;
+}
+
+// 循环读取包，直到读到需要输出的流的包，调用者需要持有mutex_
+bool Demuxer::readSelectedPacket(AVPacket *packet)
+{
+    // 循环读取包
+    while (readFrame(packet))
+    {
+        if (isSelectedStream(packet->stream_index)) // 如果包属于目标流
+        {
+            return true; // 读取成功
+        }
+        // 如果包不属于目标流，只释放包内数据，结构体留给下一次读取
+        dropPacket(packet);
+    }
+    return false; // 读取失败或到达文件末尾
+}
+
+// 启动异步预读线程
+// 队列和Demuxer同生命周期，只用read_ahead_running_切换模式：不加锁的消费者随时可能在使用队列
+bool Demuxer::startReadAhead(const ReadAheadOptions &options)
+{
+    std::lock_guard<std::mutex> control_lock(read_ahead_mutex_);
+    if (read_ahead_running_)
+    {
+        return true; // 已经在预读
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!format_ctx_)
+        {
+            LOG_ERROR << "Demuxer not initialized.";
+            return false;
+        }
+        // 清空多流模式下暂存的包，之后的包全部从预读队列中取
+        clearPending();
+        read_ahead_queue_.start(options.max_packets, options.max_bytes, options.max_duration_us, packet_pool_);
+        read_ahead_abort_ = false;
+        read_ahead_running_ = true;
+    }
+    read_ahead_thread_ = std::thread(&Demuxer::readAheadThread, this);
+    LOG_INFO << "Read-ahead started (max " << options.max_packets << " packets, " << options.max_bytes
+             << " bytes, " << options.max_duration_us << "us).";
+    return true;
+}
+
+// 停止异步预读线程，丢弃队列中剩余的包
+// 队列保持中止状态，还在popPacket()中的消费者得到ABORTED，之后的读取回到同步模式
+void Demuxer::stopReadAhead()
+{
+    std::lock_guard<std::mutex> control_lock(read_ahead_mutex_);
+    if (!read_ahead_running_)
+    {
+        return;
+    }
+    read_ahead_running_ = false;
+    read_ahead_abort_ = true;
+    read_ahead_queue_.abort();
+    // 预读线程可能阻塞在读取上，打断它
+    io_interrupt_.requests++;
+    if (read_ahead_thread_.joinable())
+    {
+        read_ahead_thread_.join();
+    }
+    io_interrupt_.requests--;
+    read_ahead_queue_.flush();
+    LOG_INFO << "Read-ahead stopped.";
+}
+
+// 从预读队列中取一个包，最多等待timeout_ms毫秒，负数表示一直等待
+DemuxStatus Demuxer::popPacket(AVPacket *packet, int timeout_ms)
+{
+    if (!read_ahead_running_)
+    {
+        LOG_ERROR << "Read-ahead is not running.";
+        return DemuxStatus::ERROR;
+    }
+    if (!packet)
+    {
+        LOG_ERROR << "Packet is null.";
+        return DemuxStatus::ERROR;
+    }
+    int serial = read_ahead_queue_.serial();
+    DemuxStatus status = read_ahead_queue_.pop(packet, timeout_ms);
+    last_status_ = status;
+    // 队列中前面的包都取完了才算到达文件末尾；取的过程中发生了定位时这个EOF已经过期
+    if (status == DemuxStatus::END_OF_FILE)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (read_ahead_queue_.serial() == serial)
+        {
+            eof_file_ = true;
+        }
+    }
+    return status;
+}
+
+// 预读线程：持锁读一个包，放锁后入队
+// 入队前记录读包时的序号，定位会在持锁时递增序号，所以旧位置读到的包入队时会被丢弃
+// 到达EOF或出错时把状态按顺序放进队列，然后等待下一次定位
+void Demuxer::readAheadThread()
+{
+    AVPacket *packet = nullptr;
+    while (!read_ahead_abort_)
+    {
+        // 先执行挂起的定位请求；被限速推迟时不再读旧位置的包，等到可以定位时再读
+        if (seek_pending_)
+        {
+            int64_t defer_us;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                defer_us = applyPendingSeek();
+            }
+            if (defer_us > 0)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min<int64_t>(defer_us, 5000)));
+                continue;
+            }
+        }
+        PacketQueueItem item;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            item.serial = read_ahead_queue_.serial();
+            if (!packet)
+            {
+                packet = acquirePacket();
+            }
+            if (!packet)
+            {
+                LOG_ERROR << "Failed to allocate packet.";
+                item.status = DemuxStatus::ERROR;
+            }
+            else if (readSelectedPacket(packet))
+            {
+                AVStream *stream = format_ctx_->streams[packet->stream_index];
+                int64_t dts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : packet->pts;
+                item.dts_us = toMicroseconds(dts, stream->time_base);
+                item.packet = packet;
+                packet = nullptr; // 所有权交给队列
+            }
+            else
+            {
+                item.status = statusFromError(read_error_);
+            }
+        }
+        // 读取被打断或超时不是流的状态，不放进队列，等打断它的操作拿到锁之后重新读
+        if (item.status == DemuxStatus::ABORTED || item.status == DemuxStatus::TIMEOUT)
+        {
+            while (io_interrupt_.requests > 0 && !read_ahead_abort_)
+            {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        bool reached_end = item.status != DemuxStatus::OK;
+        int serial = item.serial;
+        read_ahead_queue_.push(item);
+        if (reached_end)
+        {
+            read_ahead_queue_.waitForSerialChange(serial);
+        }
+    }
+    releasePacket(&packet);
+}
+
+// 多流模式下读取指定类型的下一个包，返回新分配的AVPacket
+AVPacket *Demuxer::readPacket(MediaType type)
+{
+    AVPacket *packet = av_packet_alloc();
+    if (!packet)
+    {
+        LOG_ERROR << "Failed to allocate packet.";
+        return nullptr;
+    }
+    if (!readPacket(type, packet))
+    {
+        av_packet_free(&packet);
+        return nullptr;
+    }
+    return packet;
+}
+
+// 多流模式下读取指定类型的下一个包
+// 先从该类型的暂存队列中取，队列为空时继续读文件，读到的其他被选中类型的包转入各自的队列
+bool Demuxer::readPacket(MediaType type, AVPacket *packet)
+{
+    // 预读队列中的包按文件顺序排列，不再按类型分发
+    if (read_ahead_running_ && multi_stream_)
+    {
+        LOG_ERROR << "Typed reads are not available while read-ahead is running.";
+        return false;
+    }
+    // 单流模式下只能读取构造时指定的类型
+    if (!multi_stream_)
+    {
+        if (type != type_)
+        {
+            LOG_ERROR << "Demuxer only serves " << mediaTypeName(type_) << " packets.";
+            return false;
+        }
+        return readPacket(packet);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return false;
+    }
+    if (!packet)
+    {
+        LOG_ERROR << "Packet is null.";
+        return false;
+    }
+    if (getStreamIndex(type) < 0)
+    {
+        LOG_ERROR << "No " << mediaTypeName(type) << " stream found.";
+        return false;
+    }
+
+    av_packet_unref(packet);
+    applyPendingSeek();
+    return readTypedPacket(type, packet);
+}
+
+// 读取指定类型的下一个包，调用者需要持有mutex_，packet必须是空的
+bool Demuxer::readTypedPacket(MediaType type, AVPacket *packet)
+{
+    // 优先输出之前读其他类型时暂存下来的包
+    std::deque<AVPacket *> &queue = pending_[static_cast<int>(type)];
+    if (!queue.empty())
+    {
+        AVPacket *pending = queue.front();
+        queue.pop_front();
+        pending_bytes_[static_cast<int>(type)] -= pending->size;
+        av_packet_move_ref(packet, pending);
+        releasePacket(&pending);
+        return true;
+    }
+
+    while (true)
+    {
+        // 其他类型的消费者不取包（例如音频线程暂停）或者要读的稀疏流隔得很远时，暂存队列会一直增长，达到上限就不再往后读
+        if (pendingFull(type))
+        {
+            last_status_ = DemuxStatus::AGAIN;
+            return false;
+        }
+        if (!readFrame(packet))
+        {
+            return false;
+        }
+        MediaType packet_type;
+        if (!mediaTypeOf(packet->stream_index, packet_type)) // 不是被选中的流，直接丢弃数据
+        {
+            dropPacket(packet);
+            continue;
+        }
+        if (packet_type == type) // 正是调用者要的类型
+        {
+            return true;
+        }
+        // 属于另一个消费者，转移到它的暂存队列中
+        AVPacket *pending = acquirePacket();
+        if (!pending)
+        {
+            LOG_ERROR << "Failed to allocate packet.";
+            av_packet_unref(packet);
+            return false;
+        }
+        av_packet_move_ref(pending, packet);
+        pending_[static_cast<int>(packet_type)].push_back(pending);
+        pending_bytes_[static_cast<int>(packet_type)] += pending->size;
+    }
+}
+
+// 统计为type以外的类型暂存的包，调用者需要持有mutex_
+bool Demuxer::pendingFull(MediaType type) const
+{
+    int packets = 0;
+    int64_t bytes = 0;
+    for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+    {
+        if (i == static_cast<int>(type))
+        {
+            continue;
+        }
+        packets += static_cast<int>(pending_[i].size());
+        bytes += pending_bytes_[i];
+    }
+    return (pending_options_.max_pending_packets > 0 && packets >= pending_options_.max_pending_packets) ||
+           (pending_options_.max_pending_bytes > 0 && bytes >= pending_options_.max_pending_bytes);
+}
+
+// 读取一个包，处理EOF和错误日志，调用者需要持有mutex_
+bool Demuxer::readFrame(AVPacket *packet)
+{
+    auto read_start = DemuxMetrics::Clock::now();
+    armIODeadline();
+    int ret = av_read_frame(format_ctx_, packet); // 从媒体文件中读取数据包
+    disarmIODeadline();
+    // 错误处理
+    if (ret < 0)
+    {
+        read_error_ = ret;
+        DemuxStatus status = statusFromError(ret);
+        // 预读线程的结果由popPacket()报告给消费者
+        if (!read_ahead_running_)
+        {
+            last_status_ = status;
+        }
+        if (ret != AVERROR_EOF)
+        {
+            metrics_.recordReadError(read_start);
+        }
+        // 如果是文件结束，设置eof标志；预读模式下队列中还有没取走的包，由popPacket()取到EOF时设置
+        if (ret == AVERROR_EOF)
+        {
+            if (!read_ahead_running_)
+            {
+                eof_file_ = true;
+            }
+            LOG_INFO << "End of file reached.";
+        }
+        else if (status == DemuxStatus::ABORTED || status == DemuxStatus::TIMEOUT)
+        {
+            LOG_INFO << (status == DemuxStatus::ABORTED ? "Read interrupted." : "Read timed out.");
+        }
+        else // 否则记录日志
+        {
+            char errbuf[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, errbuf, sizeof(errbuf));
+            LOG_ERROR << "Error reading frame: " << errbuf;
+        }
+        return false;
+    }
+    if (!read_ahead_running_)
+    {
+        last_status_ = DemuxStatus::OK;
+    }
+    metrics_.recordRead(read_start, packet->stream_index, packet->size);
+    // 顺便把读到的目标流关键帧加入索引
+    if (packet->stream_index == index_stream_index_)
+    {
+        recordKeyframe(packet, indexed_keyframe_pts_);
+    }
+    // 跟踪定位流正在读取的GOP，用来判断定位请求能否直接往后读
+    if (packet->stream_index == getStreamIndex())
+    {
+        int64_t pts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+        if (packet->flags & AV_PKT_FLAG_KEY)
+        {
+            gop_start_pts_ = pts;
+            gop_max_pts_ = pts;
+        }
+        else if (gop_start_pts_ != AV_NOPTS_VALUE && pts != AV_NOPTS_VALUE)
+        {
+            gop_max_pts_ = std::max(gop_max_pts_, pts);
+        }
+    }
+    if (isSelectedStream(packet->stream_index))
+    {
+        metrics_.recordDelivered(packet->size);
+    }
+    return true;
+}
+
+// 列出所有轨道，元数据取自容器
+std::vector<TrackInfo> Demuxer::getTracks() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TrackInfo> tracks;
+    if (!format_ctx_)
+    {
+        return tracks;
+    }
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
+    {
+        const AVStream *stream = format_ctx_->streams[i];
+        const AVCodecParameters *par = stream->codecpar;
+        TrackInfo track;
+        track.stream_index = static_cast<int>(i);
+        track.codec_type = par->codec_type;
+        track.codec_name = avcodec_get_name(par->codec_id);
+        const AVDictionaryEntry *entry = av_dict_get(stream->metadata, "language", nullptr, 0);
+        if (entry)
+        {
+            track.language = entry->value;
+        }
+        entry = av_dict_get(stream->metadata, "title", nullptr, 0);
+        if (entry)
+        {
+            track.title = entry->value;
+        }
+        track.is_default = (stream->disposition & AV_DISPOSITION_DEFAULT) != 0;
+        track.is_attached_picture = (stream->disposition & AV_DISPOSITION_ATTACHED_PIC) != 0;
+        MediaType type;
+        track.selected = mediaTypeOf(track.stream_index, type);
+        track.width = par->width;
+        track.height = par->height;
+        track.frame_rate = stream->avg_frame_rate;
+        track.sample_rate = par->sample_rate;
+        track.channels = par->ch_layout.nb_channels;
+        track.bit_rate = par->bit_rate;
+        tracks.push_back(track);
+    }
+    return tracks;
+}
+
+int Demuxer::findTrack(MediaType type, const std::string &language) const
+{
+    AVMediaType wanted = toAVMediaType(type);
+    for (const TrackInfo &track : getTracks())
+    {
+        if (track.codec_type == wanted && !track.is_attached_picture && track.language == language)
+        {
+            return track.stream_index;
+        }
+    }
+    return -1;
+}
+
+// 切换轨道只改变选中的流和丢弃标志，libavformat的读取位置不变
+// mov等按样本表读取的容器在丢弃的流上也会推进读取位置，交错存放的容器按文件顺序读，新轨道都能从当前位置接着输出
+bool Demuxer::selectTrack(MediaType type, int stream_index, bool reseek)
+{
+    // 预读队列中已经有旧轨道的包，不能在不加锁的消费路径上过滤
+    if (read_ahead_running_)
+    {
+        LOG_ERROR << "Track switching is not available while read-ahead is running.";
+        return false;
+    }
+    // 只有之后要重新定位时才打断其他线程正在进行的读取；不定位时被打断的读取没有机会重新同步，
+    // 部分读取的包（例如matroska、TS）会丢失或不完整，所以等它读完
+    std::unique_lock<std::mutex> lock = reseek ? lockInterrupting() : std::unique_lock<std::mutex>(mutex_);
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return false;
+    }
+    // 字幕和数据流可以不选，音视频必须选一条
+    bool deselect = stream_index < 0 && isSparseMediaType(type);
+    if (!deselect && (stream_index < 0 || stream_index >= static_cast<int>(format_ctx_->nb_streams) ||
+                      format_ctx_->streams[stream_index]->codecpar->codec_type != toAVMediaType(type) ||
+                      (format_ctx_->streams[stream_index]->disposition & AV_DISPOSITION_ATTACHED_PIC)))
+    {
+        LOG_ERROR << "Stream " << stream_index << " is not a " << mediaTypeName(type) << " track.";
+        return false;
+    }
+    if (deselect)
+    {
+        stream_index = -1;
+    }
+    if (getStreamIndex(type) == stream_index)
+    {
+        return true;
+    }
+
+    // 切换之前的读取位置
+    AVStream *position_stream = getAVStream();
+    int64_t position = position_stream ? toMicroseconds(gop_max_pts_, position_stream->time_base) : AV_NOPTS_VALUE;
+    int old_primary = getStreamIndex();
+
+    int old_index = getStreamIndex(type);
+    AVStream *stream = stream_index >= 0 ? format_ctx_->streams[stream_index] : nullptr;
+    switch (type)
+    {
+    case MediaType::VIDEO:
+        video_stream_index_ = stream_index;
+        video_stream_ = stream;
+        break;
+    case MediaType::AUDIO:
+        audio_stream_index_ = stream_index;
+        audio_stream_ = stream;
+        break;
+    case MediaType::SUBTITLE:
+        subtitle_stream_index_ = stream_index;
+        subtitle_stream_ = stream;
+        break;
+    default:
+        data_stream_index_ = stream_index;
+        data_stream_ = stream;
+        break;
+    }
+    // 旧轨道暂存的包不再输出
+    clearPending(type);
+    discardUnusedStreams();
+
+    // 定位流变了，关键帧索引和GOP跟踪都属于旧的流
+    if (getStreamIndex() != old_primary)
+    {
+        stopIndexing();
+        seek_index_.clear();
+        index_stream_index_ = getStreamIndex();
+        gop_start_pts_ = AV_NOPTS_VALUE;
+        gop_max_pts_ = AV_NOPTS_VALUE;
+        indexed_keyframe_pts_ = AV_NOPTS_VALUE;
+    }
+    LOG_INFO << "Switched " << mediaTypeName(type) << " track from stream " << old_index << " to " << stream_index << ".";
+
+    if (reseek && position != AV_NOPTS_VALUE)
+    {
+        return seekLocked(position, AVSEEK_FLAG_BACKWARD, nullptr, DemuxMetrics::Clock::now());
+    }
+    return true;
+}
+
+// 读包成功后按open()时保存的时间基换算
+bool Demuxer::readPacket(AVPacket *packet, PacketInfo &info)
+{
+    return readPacket(packet) && describePacket(packet, info);
+}
+
+bool Demuxer::readPacket(MediaType type, AVPacket *packet, PacketInfo &info)
+{
+    return readPacket(type, packet) && describePacket(packet, info);
+}
+
+// 时间基在open()之后不会变，复制到连续的数组中，换算时只读这一小块内存
+// 消费者线程不加锁读取，所以每次打开都建立新的快照整体替换，不修改已经发布的数组
+void Demuxer::captureStreamTiming()
+{
+    auto timing = std::make_shared<StreamTiming>();
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
+    {
+        timing->time_bases.push_back(format_ctx_->streams[i]->time_base);
+        timing->types.push_back(fromAVMediaType(format_ctx_->streams[i]->codecpar->codec_type));
+    }
+    std::atomic_store(&stream_timing_, std::shared_ptr<const StreamTiming>(std::move(timing)));
+}
+
+bool Demuxer::describePacket(const AVPacket *packet, PacketInfo &info) const
+{
+    std::shared_ptr<const StreamTiming> timing = std::atomic_load(&stream_timing_);
+    return describePacket(timing.get(), packet, info);
+}
+
+bool Demuxer::describePacket(const StreamTiming *timing, const AVPacket *packet, PacketInfo &info)
+{
+    if (!timing || !packet || packet->stream_index < 0 || packet->stream_index >= static_cast<int>(timing->time_bases.size()))
+    {
+        return false;
+    }
+    info = PacketInfo::from(packet, timing->time_bases[packet->stream_index], timing->types[packet->stream_index]);
+    return true;
+}
+
+// 整批使用同一个快照
+int Demuxer::describePackets(AVPacket *const *packets, int count, PacketInfo *infos) const
+{
+    std::shared_ptr<const StreamTiming> timing = std::atomic_load(&stream_timing_);
+    int described = 0;
+    while (described < count && describePacket(timing.get(), packets[described], infos[described]))
+    {
+        described++;
+    }
+    return described;
+}
+
+// 包所属流是否为当前需要输出的流
+bool Demuxer::isSelectedStream(int stream_index) const
+{
+    if (stream_index < 0)
+    {
         return false;
     }
-
-    // 确保之前的资源已经释放
-    if (format_ctx_)
+    if (!multi_stream_)
     {
-        LOG_WARN << "Demuxer already initialized. Closing previous context.";
-        close();
+        return stream_index == getStreamIndex();
     }
+    MediaType type;
+    return mediaTypeOf(stream_index, type);
+}
 
-    // 打开媒体文件
-    // 它会探测文件格式并填充format_ctx_，执行完后fomat_ctx_会包含媒体文件的基本信息
-    // 参数：AVFormatContext* 的指针地址，媒体文件路径，指定的输入格式（nullptr表示自动探测），以及可选的字典参数（通常为nullptr）
-    if (avformat_open_input(&format_ctx_, filename.c_str(), nullptr, nullptr) < 0)
+// 根据流索引找到对应的媒体类型
+bool Demuxer::mediaTypeOf(int stream_index, MediaType &type) const
+{
+    if (stream_index < 0)
     {
-        LOG_ERROR << "Failed to open media file: " << filename;
-        return false; // 打开失败，返回false
+        return false;
     }
-
-    // 查找流信息
-    // 读取文件开头的部分数据，解析并填充到streams数组中
-    // 通常包括编解码参数、时长、码率等详细信息
-    // 第二个参数是用来传递额外选项的
-    if (avformat_find_stream_info(format_ctx_, nullptr) < 0)
+    if (stream_index == video_stream_index_ && (multi_stream_ || type_ == MediaType::VIDEO))
     {
-        LOG_ERROR << "Could not find stream information in file: " << filename;
-        close();      // 关闭demuxer
-        return false; // 查找流信息失败，返回false
+        type = MediaType::VIDEO;
+        return true;
     }
-
-    // 查找最佳视频流
-    // 第三和第四个参数通常用于指定首选流和相关流，这里不指定，第五个参数用来指定编解码器，nullptr表示不指定，最后一个为查找选项
-    video_stream_index_ = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
-    // 如果找到视频流
-    if (video_stream_index_ >= 0)
+    if (stream_index == audio_stream_index_ && (multi_stream_ || type_ == MediaType::AUDIO))
     {
-        video_stream_ = format_ctx_->streams[video_stream_index_]; // 获取视频流
-        LOG_INFO << "Video stream found at index: " << video_stream_index_;
+        type = MediaType::AUDIO;
+        return true;
     }
-    else
+    if (stream_index == subtitle_stream_index_ && (multi_stream_ || type_ == MediaType::SUBTITLE))
     {
-        LOG_WARN << "No video stream found in file: " << filename;
+        type = MediaType::SUBTITLE;
+        return true;
     }
-
-    // 查找最佳音频流
-    audio_stream_index_ = av_find_best_stream(format_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
-    // 如果找到音频流
-    if (audio_stream_index_ >= 0)
+    if (stream_index == data_stream_index_ && (multi_stream_ || type_ == MediaType::DATA))
     {
-        audio_stream_ = format_ctx_->streams[audio_stream_index_]; // 获取音频流
-        LOG_INFO << "Audio stream found at index: " << audio_stream_index_;
+        type = MediaType::DATA;
+        return true;
     }
-    else
+    return false;
+}
+
+// 把没有被选中的流标记为AVDISCARD_ALL
+// 对于mp4、mkv等容器，libavformat会直接跳过这些流的数据而不再读取和打包
+void Demuxer::discardUnusedStreams()
+{
+    streams_discarded_ = 0;
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
     {
-        LOG_WARN << "No audio stream found in file: " << filename;
+        AVStream *stream = format_ctx_->streams[i];
+        MediaType type;
+        if (mediaTypeOf(static_cast<int>(i), type))
+        {
+            stream->discard = AVDISCARD_DEFAULT;
+            continue;
+        }
+        stream->discard = AVDISCARD_ALL;
+        streams_discarded_++;
     }
+    LOG_INFO << "Discarded " << streams_discarded_ << " of " << format_ctx_->nb_streams << " streams.";
+}
 
-    // 查找成功返回true
-    return true;
+// 丢掉一个不需要的包，并记录仍然被读出来的包数和字节数
+void Demuxer::dropPacket(AVPacket *packet)
+{
+    metrics_.recordDiscarded(packet->stream_index, packet->size);
+    av_packet_unref(packet);
 }
 
-// 从媒体文件中循环读取数据包，过滤出目标流的包并返回
-AVPacket *Demuxer::readPacket()
+// 分配一个空的包结构体
+AVPacket *Demuxer::acquirePacket()
 {
-    // 确保上下文初始化
-    if (!format_ctx_)
+    return packet_pool_ ? packet_pool_->acquire() : av_packet_alloc();
+}
+
+// 释放包结构体，有缓冲池时放回池中
+void Demuxer::releasePacket(AVPacket **packet)
+{
+    if (packet_pool_)
     {
-        LOG_ERROR << "Demuxer not initialized.";
-        return nullptr; // 如果没有初始化，返回nullptr
+        packet_pool_->release(packet);
     }
-    // 获取目标流的索引
-    int target_stream_index = getStreamIndex();
-    if (target_stream_index < 0)
+    else
     {
-        LOG_ERROR << "No valid stream index found.";
-        return nullptr; // 如果没有有效的流索引，返回nullptr
+        av_packet_free(packet);
     }
+}
 
-    // 循环读取包
-    while (true)
+// 返回流丢弃的统计信息
+// 跳过的包数和字节数根据被丢弃流的容器索引估算：位于当前读取位置之前的索引项都已经被跳过
+// 没有索引的容器（如MPEG-TS）无法估算，只有被丢弃的流数量和被过滤的包数
+DiscardStats Demuxer::getDiscardStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    DiscardStats stats;
+    stats.streams_discarded = streams_discarded_;
+    DemuxMetricsSnapshot metrics = metrics_.snapshot();
+    stats.packets_filtered = metrics.packets_discarded;
+    stats.bytes_filtered = metrics.bytes_discarded;
+    if (!format_ctx_ || !format_ctx_->pb)
     {
-        AVPacket *packet = av_packet_alloc();         // 分配一个新的AVPacket
-        int ret = av_read_frame(format_ctx_, packet); // 从媒体文件中读取数据包
-        // 错误处理
-        if (ret < 0)
-        {
-            // 如果是文件结束，设置eof标志
-            if (ret == AVERROR_EOF)
-            {
-                eof_file_ = true;
-                LOG_INFO << "End of file reached.";
-            }
-            else // 否则记录日志
-            {
-                char errbuf[AV_ERROR_MAX_STRING_SIZE];
-                av_strerror(ret, errbuf, sizeof(errbuf));
-                LOG_ERROR << "Error reading frame: " << errbuf;
-            }
-            av_packet_free(&packet); // 释放AVPacket
-            return nullptr;          // 返回nullptr表示读取失败或到达文件末尾
-        }
-        if (packet->stream_index == target_stream_index) // 如果包属于目标流
+        return stats;
+    }
+    int64_t position = avio_tell(format_ctx_->pb);
+    for (unsigned int i = 0; i < format_ctx_->nb_streams; i++)
+    {
+        AVStream *stream = format_ctx_->streams[i];
+        if (stream->discard != AVDISCARD_ALL)
         {
-            return packet; // 返回读取到的包
+            continue;
         }
-        else // 如果包不属于目标流，释放包并继续读取下一个包
+        int count = avformat_index_get_entries_count(stream);
+        for (int j = 0; j < count; j++)
         {
-            av_packet_free(&packet);
+            const AVIndexEntry *entry = avformat_index_get_entry(stream, j);
+            if (entry && entry->pos < position)
+            {
+                stats.packets_avoided++;
+                stats.bytes_avoided += entry->size;
+            }
         }
     }
+    return stats;
+}
+
+// 清空所有类型的暂存队列，调用者需要持有mutex_
+void Demuxer::clearPending()
+{
+    for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+    {
+        clearPending(static_cast<MediaType>(i));
+    }
+}
+
+void Demuxer::clearPending(MediaType type)
+{
+    std::deque<AVPacket *> &queue = pending_[static_cast<int>(type)];
+    for (AVPacket *packet : queue)
+    {
+        releasePacket(&packet);
+    }
+    queue.clear();
+    pending_bytes_[static_cast<int>(type)] = 0;
 }
 
 //跳转到目标时间戳
 //flags：定位方式
+//landed_timestamp：不为空时返回实际落到的关键帧时间戳（微秒），没有关键帧索引可用时为AV_NOPTS_VALUE
 //成功返回true，失败返回false
-bool Demuxer::seek(int64_t timestamp,int flags)
+bool Demuxer::seek(int64_t timestamp,int flags,int64_t* landed_timestamp)
 {
+    if (landed_timestamp)
+    {
+        *landed_timestamp = AV_NOPTS_VALUE;
+    }
+    auto seek_start = DemuxMetrics::Clock::now();
+    // 正在阻塞读取的线程持有mutex_，先打断它
+    auto lock = lockInterrupting();
+    // 直接定位之后，之前挂起的定位请求已经没有意义
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        seek_pending_ = false;
+    }
+    return seekLocked(timestamp, flags, landed_timestamp, seek_start);
+}
+
+// 执行定位，调用者需要持有mutex_
+bool Demuxer::seekLocked(int64_t timestamp, int flags, int64_t *landed_timestamp, DemuxMetrics::Clock::time_point seek_start)
+{
+    if (landed_timestamp)
+    {
+        *landed_timestamp = AV_NOPTS_VALUE;
+    }
     // 确保上下文初始化
     if (!format_ctx_)
     {
@@ -165,13 +1385,27 @@ bool Demuxer::seek(int64_t timestamp,int flags)
         return false;
     }   
     //从微秒转换到流的时间基
-    int64_t seek_target = av_rescale_q(timestamp,AV_TIME_BASE_Q,stream->time_base);
+    int64_t seek_target = fromMicroseconds(timestamp, stream->time_base);
     
     LOG_INFO << "Seeking to " << timestamp << "us (stream timebase: "
               << stream->time_base.num << "/" << stream->time_base.den
               << ", target: " << seek_target << ")";
-    //在指定的媒体流上，跳转到目标时间戳，并根据flags参数控制定位方式
-    int ret = av_seek_frame(format_ctx_, stream_index, seek_target, flags);
+    //关键帧索引覆盖目标时间时，二分查找目标之前的关键帧直接跳过去
+    //否则在指定的媒体流上，跳转到目标时间戳，并根据flags参数控制定位方式
+    KeyframeEntry keyframe;
+    int ret = -1;
+    bool indexed = false;
+    armIODeadline();
+    if (findIndexedKeyframe(seek_target, flags, keyframe))
+    {
+        ret = seekToKeyframe(stream_index, keyframe);
+        indexed = ret >= 0;
+    }
+    if (!indexed)
+    {
+        ret = av_seek_frame(format_ctx_, stream_index, seek_target, flags);
+    }
+    disarmIODeadline();
     //失败处理
     if(ret<0)
     {
@@ -180,12 +1414,388 @@ bool Demuxer::seek(int64_t timestamp,int flags)
         LOG_ERROR << "Error seeking to " << timestamp << "us: " << errbuf;
         return false;
     }
+    //定位前读到的暂存包和预读队列中的包已经失效
+    clearPending();
+    if (read_ahead_running_)
+    {
+        read_ahead_queue_.flush();
+    }
+    read_error_ = 0;
+    last_status_ = DemuxStatus::OK;
     //定位成功重置eof标志
     eof_file_ = false;
+    if (indexed && landed_timestamp)
+    {
+        *landed_timestamp = toMicroseconds(keyframe.pts, stream->time_base);
+    }
+    //新位置的GOP要等读到关键帧之后才知道
+    gop_start_pts_ = AV_NOPTS_VALUE;
+    gop_max_pts_ = AV_NOPTS_VALUE;
+    indexed_keyframe_pts_ = AV_NOPTS_VALUE;
+    last_seek_time_ = std::chrono::steady_clock::now();
+    seek_serial_++;
+    metrics_.recordSeek(seek_start);
     LOG_INFO<< "Seeked to " << timestamp << "us successfully.";
     return true;
 }
 
+//记录定位请求，替换掉还没执行的旧请求
+void Demuxer::requestSeek(int64_t timestamp, int flags)
+{
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        seek_request_stats_.requested++;
+        if (seek_pending_)
+        {
+            seek_request_stats_.coalesced++;
+        }
+        pending_seek_timestamp_ = timestamp;
+        pending_seek_flags_ = flags;
+        pending_seek_id_++;
+        pending_seek_deferred_ = false;
+        seek_pending_ = true;
+    }
+    //预读队列中旧位置的包已经没用了，清空队列同时唤醒停在EOF处的预读线程，由它执行请求
+    if (read_ahead_running_)
+    {
+        read_ahead_queue_.flush();
+    }
+}
+
+SeekRequestStats Demuxer::getSeekRequestStats() const
+{
+    std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+    return seek_request_stats_;
+}
+
+//执行或跳过挂起的定位请求，调用者需要持有mutex_
+int64_t Demuxer::applyPendingSeek()
+{
+    if (!seek_pending_)
+    {
+        return 0;
+    }
+    int64_t timestamp;
+    int flags;
+    int64_t id;
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        if (!seek_pending_)
+        {
+            return 0;
+        }
+        timestamp = pending_seek_timestamp_;
+        flags = pending_seek_flags_;
+        id = pending_seek_id_;
+    }
+
+    //目标就在前面不远的同一个GOP里，继续往后读比重新定位更快，解码器也不需要清空
+    int stream_index = getStreamIndex();
+    if (seek_request_options_.skip_within_gop && !read_ahead_running_ && stream_index >= 0 &&
+        !(flags & (AVSEEK_FLAG_BYTE | AVSEEK_FLAG_FRAME)))
+    {
+        AVStream *stream = format_ctx_->streams[stream_index];
+        if (isAheadInCurrentGop(fromMicroseconds(timestamp, stream->time_base)))
+        {
+            std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+            if (pending_seek_id_ == id)
+            {
+                seek_request_stats_.skipped_in_gop++;
+                seek_pending_ = false;
+            }
+            return 0;
+        }
+    }
+
+    //限速：距离上一次容器定位太近时推迟
+    int64_t since_last = elapsedMicroseconds(last_seek_time_);
+    if (since_last < seek_request_options_.min_interval_us)
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        if (pending_seek_id_ == id && !pending_seek_deferred_)
+        {
+            pending_seek_deferred_ = true;
+            seek_request_stats_.deferred++;
+        }
+        return seek_request_options_.min_interval_us - since_last;
+    }
+
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        if (pending_seek_id_ != id)
+        {
+            return 0; // 刚被更新的请求替换，下一次读包时再执行新的请求
+        }
+        seek_pending_ = false;
+        seek_request_stats_.executed++;
+    }
+    seekLocked(timestamp, flags, nullptr, DemuxMetrics::Clock::now());
+    return 0;
+}
+
+//目标在当前GOP中已经读到的位置之后，并且在下一个关键帧之前
+//GOP的终点来自关键帧索引，索引中当前关键帧之后有空洞（之前定位跳过了那里）或者还没覆盖到下一个关键帧时，
+//索引中的下一项不一定是这个GOP的终点，无法判断，按需要定位处理
+bool Demuxer::isAheadInCurrentGop(int64_t target) const
+{
+    if (gop_start_pts_ == AV_NOPTS_VALUE || gop_max_pts_ == AV_NOPTS_VALUE || target <= gop_max_pts_)
+    {
+        return false;
+    }
+    int64_t gop_end;
+    return seek_index_.findGopEnd(gop_start_pts_, gop_end) && target < gop_end;
+}
+
+//在关键帧索引中查找目标之前的关键帧
+//读包时建立的索引在定位过的地方有空洞，只有确定目标之前的关键帧没有落在空洞里（或已扫描完整个文件）时才使用，
+//否则交给av_seek_frame；按字节、按帧或任意帧定位时不使用
+bool Demuxer::findIndexedKeyframe(int64_t seek_target, int flags, KeyframeEntry &keyframe) const
+{
+    if (flags & (AVSEEK_FLAG_BYTE | AVSEEK_FLAG_ANY | AVSEEK_FLAG_FRAME))
+    {
+        return false;
+    }
+    return seek_index_.findSeekPoint(seek_target, keyframe);
+}
+
+//跳到索引中的关键帧
+//MPEG-TS/PS这类可以从任意包重新同步、且本身没有索引的容器直接按字节偏移跳转
+//其他容器按关键帧的精确时间戳定位，落点就是这个关键帧
+int Demuxer::seekToKeyframe(int stream_index, const KeyframeEntry &keyframe)
+{
+    const AVInputFormat *format = format_ctx_->iformat;
+    bool byte_seekable = keyframe.pos >= 0 && !(format->flags & AVFMT_NO_BYTE_SEEK) &&
+                         (format->flags & (AVFMT_TS_DISCONT | AVFMT_GENERIC_INDEX));
+    if (byte_seekable)
+    {
+        int ret = av_seek_frame(format_ctx_, stream_index, keyframe.pos, AVSEEK_FLAG_BYTE);
+        if (ret >= 0)
+        {
+            return ret;
+        }
+        LOG_WARN << "Byte seek to " << keyframe.pos << " failed, seeking by timestamp.";
+    }
+    return av_seek_frame(format_ctx_, stream_index, keyframe.pts, AVSEEK_FLAG_BACKWARD);
+}
+
+//开始在后台线程中扫描整个文件，建立目标流的关键帧索引
+bool Demuxer::startIndexing()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Demuxer not initialized.";
+        return false;
+    }
+    int stream_index = getStreamIndex();
+    if (stream_index < 0)
+    {
+        LOG_ERROR << "No valid stream index found.";
+        return false;
+    }
+    if (index_thread_.joinable() || seek_index_.isComplete())
+    {
+        return true; // 正在扫描或已经扫描完成
+    }
+    index_abort_ = false;
+    index_thread_ = std::thread(&Demuxer::indexingThread, this, filename_, stream_index);
+    return true;
+}
+
+//停止后台扫描线程
+void Demuxer::stopIndexing()
+{
+    if (index_thread_.joinable())
+    {
+        index_abort_ = true;
+        index_thread_.join();
+    }
+}
+
+//后台扫描使用的中断回调，close()时让阻塞的读取尽快返回
+int Demuxer::indexInterruptCallback(void *opaque)
+{
+    Demuxer *demuxer = static_cast<Demuxer *>(opaque);
+    return demuxer->index_abort_.load() ? 1 : 0;
+}
+
+//先登记打断请求再等锁，持锁的读取线程在下一次检查中断时退出，拿到锁后撤销请求
+std::unique_lock<std::mutex> Demuxer::lockInterrupting()
+{
+    io_interrupt_.requests++;
+    std::unique_lock<std::mutex> lock(mutex_);
+    io_interrupt_.requests--;
+    return lock;
+}
+
+void Demuxer::armIODeadline()
+{
+    io_interrupt_.deadline_hit = false;
+    if (open_options_.io_timeout_us > 0)
+    {
+        io_interrupt_.deadline_ns = std::chrono::steady_clock::now().time_since_epoch().count() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                              std::chrono::microseconds(open_options_.io_timeout_us)).count();
+    }
+}
+
+DemuxStatus Demuxer::statusFromError(int error) const
+{
+    if (error >= 0)
+    {
+        return DemuxStatus::OK;
+    }
+    if (error == AVERROR_EOF)
+    {
+        return DemuxStatus::END_OF_FILE;
+    }
+    if (error == AVERROR_EXIT)
+    {
+        return io_interrupt_.deadline_hit ? DemuxStatus::TIMEOUT : DemuxStatus::ABORTED;
+    }
+    return DemuxStatus::ERROR;
+}
+
+//后台扫描线程：用独立的AVFormatContext顺序读完整个文件，只保留目标流并记录它的关键帧
+void Demuxer::indexingThread(std::string filename, int stream_index)
+{
+    LOG_INFO << "Indexing keyframes of stream " << stream_index << " in " << filename;
+    AVFormatContext *ctx = avformat_alloc_context();
+    if (!ctx)
+    {
+        LOG_ERROR << "Failed to allocate format context for indexing.";
+        return;
+    }
+    ctx->interrupt_callback.callback = &Demuxer::indexInterruptCallback;
+    ctx->interrupt_callback.opaque = this;
+    if (avformat_open_input(&ctx, filename.c_str(), nullptr, nullptr) < 0)
+    {
+        LOG_ERROR << "Failed to open file for indexing: " << filename;
+        return;
+    }
+    // 没有文件头的格式需要探测后才有流
+    if (static_cast<int>(ctx->nb_streams) <= stream_index && avformat_find_stream_info(ctx, nullptr) < 0)
+    {
+        LOG_ERROR << "Could not find stream information for indexing.";
+        avformat_close_input(&ctx);
+        return;
+    }
+    if (static_cast<int>(ctx->nb_streams) <= stream_index)
+    {
+        LOG_ERROR << "Stream " << stream_index << " not found while indexing.";
+        avformat_close_input(&ctx);
+        return;
+    }
+    for (unsigned int i = 0; i < ctx->nb_streams; i++)
+    {
+        ctx->streams[i]->discard = (static_cast<int>(i) == stream_index) ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+
+    AVPacket *packet = av_packet_alloc();
+    int ret = 0;
+    int64_t previous_pts = AV_NOPTS_VALUE;
+    while (packet && !index_abort_ && (ret = av_read_frame(ctx, packet)) >= 0)
+    {
+        if (packet->stream_index == stream_index)
+        {
+            recordKeyframe(packet, previous_pts);
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&ctx);
+
+    if (ret == AVERROR_EOF)
+    {
+        seek_index_.setComplete(true);
+        LOG_INFO << "Keyframe index complete: " << seek_index_.size() << " keyframes.";
+        // 保存下来，下次打开时直接映射
+        if (index_cache_enabled_)
+        {
+            saveSeekIndex();
+        }
+    }
+}
+
+//设置关键帧索引文件的保存位置
+void Demuxer::setSeekIndexCache(bool enabled, const std::string &directory)
+{
+    index_cache_enabled_ = enabled;
+    index_cache_dir_ = directory;
+}
+
+//返回当前文件的关键帧索引文件路径
+//没有指定目录时保存在媒体文件旁边，否则以媒体文件路径的哈希为文件名保存在指定目录中
+std::string Demuxer::seekIndexPath() const
+{
+    if (index_cache_dir_.empty())
+    {
+        return filename_ + ".ffidx";
+    }
+    // 64位FNV-1a哈希，同一路径在不同进程中得到相同的文件名
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : filename_)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ffidx", static_cast<unsigned long long>(hash));
+    return index_cache_dir_ + "/" + name;
+}
+
+//根据媒体文件的大小、修改时间和定位流生成索引文件的校验信息，不是本地文件时返回false
+bool Demuxer::makeSeekIndexKey(SeekIndexKey &key) const
+{
+    struct stat st;
+    if (filename_.empty() || index_stream_index_ < 0 || ::stat(filename_.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    const AVStream *stream = format_ctx_->streams[index_stream_index_];
+    key.file_size = static_cast<int64_t>(st.st_size);
+    key.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    key.stream_index = index_stream_index_;
+    key.time_base_num = stream->time_base.num;
+    key.time_base_den = stream->time_base.den;
+    return true;
+}
+
+//把完整的关键帧索引保存为索引文件
+bool Demuxer::saveSeekIndex()
+{
+    SeekIndexKey key;
+    if (!seek_index_.isComplete() || !makeSeekIndexKey(key))
+    {
+        return false;
+    }
+    return seek_index_.save(seekIndexPath(), key);
+}
+
+//如果包是目标流的关键帧，把它加入关键帧索引
+//previous_pts是这次连续读取中上一个加入索引的关键帧，用来标记索引中没有空洞的部分；
+//有关键帧因为没有位置或时间戳而加不进索引时，连续性在这里断开
+void Demuxer::recordKeyframe(const AVPacket *packet, int64_t &previous_pts)
+{
+    if (!(packet->flags & AV_PKT_FLAG_KEY))
+    {
+        return;
+    }
+    KeyframeEntry entry;
+    entry.pts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts : packet->dts;
+    entry.dts = packet->dts;
+    entry.pos = packet->pos;
+    entry.size = packet->size;
+    entry.flags = 0;
+    if (entry.pts == AV_NOPTS_VALUE || entry.pos < 0)
+    {
+        previous_pts = AV_NOPTS_VALUE;
+        return;
+    }
+    seek_index_.add(entry, previous_pts);
+    previous_pts = entry.pts;
+}
+
 // 获取媒体文件的总时长
 int64_t Demuxer::getDuration() const
 {
@@ -230,6 +1840,19 @@ int64_t Demuxer::getDuration() const
 void Demuxer::close()
 {
     LOG_INFO << "Closing Demuxer...";
+    // 先停止预读线程和后台扫描，它们会访问format_ctx_和seek_index_
+    stopReadAhead();
+    stopIndexing();
+    auto lock = lockInterrupting();
+    // 释放暂存的包
+    clearPending();
+    // 打开成功过的上下文放进缓存，下次打开同一个文件时复用
+    // 读取出错的上下文不缓存；filename_只在open()成功后设置，open()中途失败时直接关闭
+    if (format_ctx_ && demuxer_pool_ && !filename_.empty() && (read_error_ == 0 || read_error_ == AVERROR_EOF))
+    {
+        releaseToPool();
+        LOG_INFO << "Format context returned to pool.";
+    }
     // 如果format_ctx_不为空，释放它
     if (format_ctx_)
     {
@@ -238,11 +1861,36 @@ void Demuxer::close()
         format_ctx_ = nullptr; // 置空
         LOG_INFO << "Format context closed.";
     }
+    // 自定义IO和中断回调的opaque要在format_ctx_关闭之后才能释放
+    mmap_io_.reset();
+    uring_io_.reset();
+    io_link_.reset();
     // 重置所有成员变量
     video_stream_ = nullptr;
     audio_stream_ = nullptr;
     video_stream_index_ = -1;
     audio_stream_index_ = -1;
+    opened_video_stream_index_ = -1;
+    opened_audio_stream_index_ = -1;
+    subtitle_stream_ = nullptr;
+    data_stream_ = nullptr;
+    subtitle_stream_index_ = -1;
+    data_stream_index_ = -1;
     eof_file_ = false;
+    read_error_ = 0;
+    gop_start_pts_ = AV_NOPTS_VALUE;
+    gop_max_pts_ = AV_NOPTS_VALUE;
+    indexed_keyframe_pts_ = AV_NOPTS_VALUE;
+    {
+        std::lock_guard<std::mutex> request_lock(seek_request_mutex_);
+        seek_pending_ = false;
+        seek_request_stats_ = SeekRequestStats();
+    }
+    streams_discarded_ = 0;
+    std::atomic_store(&stream_timing_, std::shared_ptr<const StreamTiming>());
+    metrics_.reset();
+    filename_.clear();
+    index_stream_index_ = -1;
+    seek_index_.clear();
     LOG_INFO << "Demuxer closed successfully.";
 }
\ No newline at end of file
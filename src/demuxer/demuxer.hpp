@@ -7,45 +7,435 @@ extern "C"
 }
 
 #include <string>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <memory>
 #include "mediadefs.hpp"//多媒体类型的定义
+#include "packet.hpp"//AVPacket的RAII句柄
+#include "packet_info.hpp"//时间戳换算成微秒的包描述
+#include "probe_cache.hpp"//探测结果缓存
+#include "seek_index.hpp"//关键帧索引
+#include "packet_queue.hpp"//预读队列
+#include "mmap_io.hpp"//内存映射的本地文件IO
+#include "uring_io.hpp"//io_uring的本地文件IO
+#include "packet_pool.hpp"//包结构体缓冲池
+#include "demux_metrics.hpp"//热路径统计
+#include "io_interrupt.hpp"//打断阻塞IO的状态
+#include "demuxer_pool.hpp"//已打开上下文的缓存
+
+// 流丢弃的统计信息
+struct DiscardStats
+{
+    int streams_discarded = 0;     // open()中被标记为AVDISCARD_ALL的流数量
+    int64_t packets_avoided = 0;   // 根据容器索引估算的、libavformat已经跳过的包数
+    int64_t bytes_avoided = 0;     // 根据容器索引估算的、libavformat已经跳过的字节数
+    int64_t packets_filtered = 0;  // 仍然被读出、在readPacket中丢掉的包数（例如探测阶段缓存的包）
+    int64_t bytes_filtered = 0;    // 仍然被读出、在readPacket中丢掉的字节数
+};
+
+// open()的选项
+struct OpenOptions
+{
+    bool fast_open = false;            // 是否限制探测的字节数和时长
+    int64_t probe_size = 256 * 1024;   // 快速打开时最多探测的字节数，0表示使用FFmpeg默认值
+    int64_t analyze_duration = 500000; // 快速打开时最多分析的时长（微秒），0表示使用FFmpeg默认值
+    bool full_probe_fallback = true;   // 快速打开后编解码参数不完整时是否退回完整探测
+    bool use_mmap = false;             // 本地文件是否通过内存映射读取，映射失败时使用默认的文件IO
+    bool use_uring = false;            // 本地文件是否通过io_uring预读，内核不支持时退回pread，与use_mmap同时设置时优先使用mmap
+    int uring_queue_depth = 8;         // io_uring同时在途的读请求数
+    int uring_block_size = 256 * 1024; // io_uring每个读请求的字节数
+    int64_t io_timeout_us = 0;         // 单次打开、读包或定位的IO最长耗时（微秒），超时后该操作返回TIMEOUT，0表示不限制
+};
+
+// open()各阶段的耗时（微秒），发生退回时包含两次打开的累计耗时
+struct OpenTiming
+{
+    int64_t open_input_us = 0;       // avformat_open_input
+    int64_t find_stream_info_us = 0; // avformat_find_stream_info
+    int64_t select_streams_us = 0;   // av_find_best_stream选流
+    int64_t total_us = 0;            // open()总耗时
+    bool full_probe_fallback = false; // 是否退回了完整探测
+    bool probe_cache_hit = false;     // 是否命中探测缓存而跳过了avformat_find_stream_info
+    bool pool_hit = false;            // 是否直接使用了DemuxerPool中缓存的上下文，此时前面几项都为0
+};
+
+// 异步预读的队列上限，任意一项达到上限时预读线程暂停，0表示不限制该项
+struct ReadAheadOptions
+{
+    int max_packets = 256;                 // 最多缓冲的包数
+    int64_t max_bytes = 16 * 1024 * 1024;  // 最多缓冲的字节数
+    int64_t max_duration_us = 2000000;     // 最多缓冲的时长（微秒）
+};
+
+// 文件中的一条轨道（流）的描述
+struct TrackInfo
+{
+    int stream_index = -1;
+    AVMediaType codec_type = AVMEDIA_TYPE_UNKNOWN;
+    std::string codec_name;          // 编解码器名称，例如h264、aac
+    std::string language;            // 元数据中的language，通常是ISO 639-2代码，例如eng、chi，没有时为空
+    std::string title;               // 元数据中的title，没有时为空
+    bool is_default = false;         // 容器标记的默认轨道
+    bool is_attached_picture = false; // 封面图片，不能作为视频轨道
+    bool selected = false;           // 当前是否被选中输出
+    int width = 0;                   // 视频
+    int height = 0;
+    AVRational frame_rate = {0, 1};
+    int sample_rate = 0;             // 音频
+    int channels = 0;
+    int64_t bit_rate = 0;
+};
+
+// 多流模式下按类型读取时暂存队列的上限
+// 读一种类型时读到的其他类型的包都要暂存，等对应的消费者来取。某个消费者不再取包（例如音频线程暂停而视频线程继续读），
+// 或者要读的字幕之间隔了几十秒时，其他类型暂存的包达到上限就停止往后读，
+// readPacket返回false，getLastStatus()为AGAIN，等其他类型的消费者取走暂存的包之后再读
+struct PendingPacketOptions
+{
+    int max_pending_packets = 256;               // 为其他类型暂存的包数上限，0表示不限制
+    int64_t max_pending_bytes = 8 * 1024 * 1024; // 为其他类型暂存的字节数上限，0表示不限制
+};
+
+// 拖动进度条时的定位请求选项
+struct SeekRequestOptions
+{
+    int64_t min_interval_us = 50000; // 两次真正执行的容器定位之间的最小间隔（微秒）
+    bool skip_within_gop = true;     // 目标在正在读取的GOP中且还没有读到时不定位，继续往后读（预读模式下不生效）
+};
+
+// 定位请求的统计
+struct SeekRequestStats
+{
+    int64_t requested = 0;      // requestSeek()的调用次数
+    int64_t executed = 0;       // 真正执行的容器定位次数
+    int64_t coalesced = 0;      // 执行之前被更新的请求替换掉的请求数
+    int64_t skipped_in_gop = 0; // 目标就在当前GOP中、省掉容器定位的请求数
+    int64_t deferred = 0;       // 因为限速被推迟过的请求数
+};
 
 class Demuxer
 {
 public:
+    //单流模式，只输出type类型的流
     Demuxer(MediaType type);
+    //多流模式，一个AVFormatContext同时为视频和音频消费者提供数据
+    Demuxer();
     ~Demuxer();
 
     bool open(const std::string &filename);
     void close();
 
+    //设置open()的选项，在下一次open()时生效
+    void setOpenOptions(const OpenOptions &options) { open_options_ = options; }
+    const OpenOptions &getOpenOptions() const { return open_options_; }
+    //设置探测结果缓存，nullptr表示不使用，缓存对象由调用者持有并且需要比Demuxer活得更久
+    void setProbeCache(ProbeCache *cache) { probe_cache_ = cache; }
+    //设置已打开上下文的缓存，通常传入&DemuxerPool::instance()，nullptr表示不使用
+    //使用时close()把上下文回到文件开头后放进缓存，open()同一个路径时直接取出，缓存需要比Demuxer活得更久
+    void setDemuxerPool(DemuxerPool *pool) { demuxer_pool_ = pool; }
+    //设置包缓冲池，预读队列和多流模式的暂存队列从池中取包结构体，包数据交给消费者后结构体放回池中，nullptr表示不使用
+    //需要在open()之前设置；缓冲池由调用者持有，可以被多个Demuxer共用，需要比Demuxer活得更久
+    //返回给调用者的包不来自缓冲池，在缓冲池析构后仍然可以安全释放
+    void setPacketPool(PacketPool *pool) { packet_pool_ = pool; }
+    //返回最近一次open()各阶段的耗时
+    const OpenTiming &getOpenTiming() const { return open_timing_; }
+    //当前文件是否通过内存映射读取
+    bool isMemoryMapped() const { return mmap_io_ != nullptr; }
+    //当前文件是否通过io_uring读取，use_uring但内核不支持时为false
+    bool isUringIO() const { return uring_io_ && uring_io_->isUring(); }
+
+    //每次调用分配一个新的AVPacket，调用者负责用av_packet_free释放
+    //多流模式下按文件顺序返回视频或音频流的包
     AVPacket* readPacket();
+    //把目标流的下一个包读入调用者持有的packet中，packet可以反复复用，不会分配新的结构体
+    //成功返回true，EOF或出错返回false
+    bool readPacket(AVPacket* packet);
+    //与readPacket()相同，但返回自动释放的句柄
+    PacketPtr readPacketPtr();
+    //一次读取多个包填入调用者分配好的packets[0..max_count)，整批只加一次锁
+    //读满max_count个包、累计字节数达到max_bytes（0表示不限制）或者遇到EOF/错误时停止，返回读到的包数
+    //返回0且isEOF()为true表示文件结束；多流模式下按文件顺序返回视频和音频流的包
+    int readPackets(AVPacket** packets, int max_count, int64_t max_bytes = 0);
+
+    //启动异步预读：专门的线程把包读进有界队列，readPacket()和popPacket()从队列中取
+    //定位会清空队列，旧位置的包不会再被取到；EOF和错误按顺序放在队列中
+    //预读模式下不支持多流模式的按类型读取
+    bool startReadAhead(const ReadAheadOptions &options = ReadAheadOptions());
+    //停止预读线程，丢弃队列中剩余的包
+    void stopReadAhead();
+    //是否在异步预读
+    bool isReadAhead() const { return read_ahead_running_; }
+    //从预读队列中取一个包，最多等待timeout_ms毫秒，负数表示一直等待
+    DemuxStatus popPacket(AVPacket* packet, int timeout_ms);
+
+    //多流模式下读取指定类型的下一个包，读到的其他类型的包会暂存到对应类型的队列中
+    //可以在视频和音频线程中分别调用
+    //为其他类型暂存的包受PendingPacketOptions限制，达到上限时返回false，getLastStatus()为AGAIN，
+    //这时需要其他类型的消费者先取走暂存的包；字幕和数据是稀疏流，读它们时最容易达到上限
+    AVPacket* readPacket(MediaType type);
+    bool readPacket(MediaType type, AVPacket* packet);
+    //多流模式下一次读取多个指定类型的包，按该类型的时间顺序排列，参数和返回值与readPackets相同
+    int readPackets(MediaType type, AVPacket** packets, int max_count, int64_t max_bytes = 0);
+
+    //读包的同时填好包的精简描述，返回值与对应的readPacket相同
+    bool readPacket(AVPacket* packet, PacketInfo& info);
+    bool readPacket(MediaType type, AVPacket* packet, PacketInfo& info);
+    //把包的时间戳换算成微秒填入info，包不属于当前文件的流时返回false
+    //使用open()时复制出来的各流时间基，不加锁，也不访问AVStream，可以在消费者线程中调用
+    //时间基以不可变快照的形式原子替换，和open()/close()并发时看到的是旧文件或新文件的完整快照
+    bool describePacket(const AVPacket* packet, PacketInfo& info) const;
+    //批量描述packets[0..count)，遇到无效的包时停止，返回描述成功的包数
+    int describePackets(AVPacket* const* packets, int count, PacketInfo* infos) const;
 
     //timestamp为微秒
-    bool seek(int64_t timestamp,int flags = 0);
+    //多流模式下以视频流（没有视频时为音频流）为基准定位，并清空所有类型的暂存队列
+    //关键帧索引确定覆盖目标时间时直接跳到目标之前的关键帧，landed_timestamp返回该关键帧的时间戳（微秒）
+    //读包时建立的索引在定位跳过的地方有空洞，目标落在空洞中时按普通方式定位，landed_timestamp为AV_NOPTS_VALUE
+    bool seek(int64_t timestamp,int flags = 0,int64_t* landed_timestamp = nullptr);
+
+    //拖动进度条用的定位请求：只记录请求并立即返回，由之后的读包（或预读线程）执行，还没执行的旧请求被新请求替换
+    //两次真正的容器定位之间至少间隔min_interval_us，期间同步读取继续从原来的位置往后读
+    //目标落在正在读取的GOP中还没读到的部分时不定位，直接往后读就能到达目标
+    //每次真正执行定位后getSeekSerial()加一，消费者看到序号变化时需要清空解码器
+    void requestSeek(int64_t timestamp, int flags = 0);
+    //是否有还没执行的定位请求
+    bool hasPendingSeek() const { return seek_pending_; }
+    //已经执行的定位次数，包括seek()
+    int getSeekSerial() const { return seek_serial_; }
+    void setSeekRequestOptions(const SeekRequestOptions &options) { seek_request_options_ = options; }
+    void setPendingPacketOptions(const PendingPacketOptions &options) { pending_options_ = options; }
+    SeekRequestStats getSeekRequestStats() const;
+
+    //在后台线程中扫描整个文件，为定位流建立关键帧索引，读包时也会顺便记录遇到的关键帧
+    bool startIndexing();
+    //关键帧索引是否已经覆盖整个文件
+    bool isIndexComplete() const { return seek_index_.isComplete(); }
+    //返回关键帧索引，时间戳使用定位流的时间基
+    const SeekIndex &getSeekIndex() const { return seek_index_; }
+    //启用关键帧索引文件：open()时映射未过期的索引文件，后台扫描完成后自动保存
+    //directory为空时索引文件保存在媒体文件旁边（<文件名>.ffidx），否则保存在该目录中
+    void setSeekIndexCache(bool enabled, const std::string &directory = "");
+    //返回当前文件的关键帧索引文件路径
+    std::string seekIndexPath() const;
+    //把完整的关键帧索引保存为索引文件
+    bool saveSeekIndex();
 
     int64_t getDuration() const;
 
+    //列出文件中的所有轨道，包括没有被选中的
+    std::vector<TrackInfo> getTracks() const;
+    //查找指定类型、指定语言的第一条轨道，找不到返回-1
+    int findTrack(MediaType type, const std::string &language) const;
+    //在同一个AVFormatContext上切换轨道，不需要重新打开文件
+    //多流模式下字幕和数据流默认不输出，需要用这个函数选中；对字幕和数据类型传入-1表示不再输出
+    //旧轨道改为丢弃、新轨道取消丢弃；对mp4、mkv这类交错存放的容器，新轨道的包从当前读取位置接着输出
+    //reseek为true时定位回当前位置（定位流当前GOP中读到的最大时间戳），新轨道可以拿到当前位置之前交错存放的包，
+    //代价是定位流从关键帧开始重复输出，getSeekSerial()会加一
+    //切换定位流（有视频时为视频轨道）会清空关键帧索引；预读模式下不支持切换
+    bool selectTrack(MediaType type, int stream_index, bool reseek = false);
+
     //返回当前关注流的索引号
     int getStreamIndex() const
     {
-        return (type_ == MediaType::VIDEO) ? video_stream_index_ : audio_stream_index_;
+        return getStreamIndex(primaryType());
     }
     //返回当前关注流的AVStream指针
     AVStream* getAVStream() const
     {
-        return (type_ == MediaType::VIDEO) ? video_stream_ : audio_stream_;
+        return getAVStream(primaryType());
+    }
+    //返回指定类型的流的索引号
+    int getStreamIndex(MediaType type) const
+    {
+        switch (type)
+        {
+        case MediaType::VIDEO:
+            return video_stream_index_;
+        case MediaType::AUDIO:
+            return audio_stream_index_;
+        case MediaType::SUBTITLE:
+            return subtitle_stream_index_;
+        default:
+            return data_stream_index_;
+        }
+    }
+    //返回指定类型的流的AVStream指针
+    AVStream* getAVStream(MediaType type) const
+    {
+        switch (type)
+        {
+        case MediaType::VIDEO:
+            return video_stream_;
+        case MediaType::AUDIO:
+            return audio_stream_;
+        case MediaType::SUBTITLE:
+            return subtitle_stream_;
+        default:
+            return data_stream_;
+        }
     }
     AVFormatContext* getFormatContext() const { return format_ctx_; }
     
-    // 检查是否到达文件末尾
+    //返回流丢弃的统计信息
+    DiscardStats getDiscardStats() const;
+    //读取和定位的统计快照，不加锁，可以在其他线程中随时轮询；close()时清零
+    DemuxMetricsSnapshot getMetrics() const { return metrics_.snapshot(); }
+
+    // 检查是否到达文件末尾；预读模式下要等消费者取完队列中的包、取到EOF之后才为true
     bool isEOF() const { return eof_file_; }
+    //最近一次读包的结果，readPacket()返回false时用它区分EOF、错误、被打断（ABORTED）和IO超时（TIMEOUT）
+    DemuxStatus getLastStatus() const { return last_status_; }
+    // 是否为多流模式
+    bool isMultiStream() const { return multi_stream_; }
 private:
+    // 多流模式下作为定位基准的类型，优先视频
+    MediaType primaryType() const
+    {
+        return (multi_stream_ && video_stream_index_ < 0) ? MediaType::AUDIO : type_;
+    }
+    // 打开文件、探测流信息并选流，limit_probe为true时使用快速打开的探测预算
+    bool openContext(const std::string &filename, bool limit_probe);
+    //按open_options_为本地文件创建自定义IO并预先分配format_ctx_，不满足条件时什么都不做
+    void setupCustomIO(const std::string &filename);
+    // 从demuxer_pool_中取出filename的上下文并接管，没有可用的缓存时返回false
+    bool adoptPooledContext(const std::string &filename);
+    // 把format_ctx_连同自定义IO放回demuxer_pool_，不能缓存时由缓存直接关闭
+    void releaseToPool();
+    // 影响打开结果的选项（探测预算和自定义IO）拼成的键，只有键相同的Demuxer才能复用缓存的上下文
+    std::string poolOptionsKey() const;
+    // 检查缓存中的流索引是否有效且类型正确
+    int validStreamIndex(int stream_index, AVMediaType type) const;
+    // 单流模式下为字幕或数据类型选流；多流模式下字幕和数据流要通过selectTrack()选中
+    void selectSparseStreams();
+    // 是否有可以输出的流
+    bool hasOutputStream() const;
+    // 读取type时是否已经为其他类型暂存了太多的包
+    bool pendingFull(MediaType type) const;
+    // 需要输出的流的编解码参数是否完整
+    bool hasCompleteCodecParameters() const;
+    // 返回从start到现在经过的微秒数
+    static int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start);
+    // 包所属流是否为当前需要输出的流
+    bool isSelectedStream(int stream_index) const;
+    // 根据流索引找到对应的媒体类型，不是被选中的流返回false
+    bool mediaTypeOf(int stream_index, MediaType &type) const;
+    // 读取需要输出的流的下一个包
+    bool readSelectedPacket(AVPacket *packet);
+    // 多流模式下读取指定类型的下一个包，其他类型的包转入暂存队列
+    bool readTypedPacket(MediaType type, AVPacket *packet);
+    // 预读线程的入口
+    void readAheadThread();
+    // 读取一个包，处理EOF和错误日志
+    bool readFrame(AVPacket *packet);
+    // 清空所有类型的暂存队列
+    void clearPending();
+    // 清空一种类型的暂存队列
+    void clearPending(MediaType type);
+    // 持有mutex_时执行定位
+    bool seekLocked(int64_t timestamp, int flags, int64_t *landed_timestamp, DemuxMetrics::Clock::time_point start);
+    // 执行或跳过挂起的定位请求，调用者需要持有mutex_；请求因为限速被推迟时返回剩余的等待时间（微秒），否则返回0
+    int64_t applyPendingSeek();
+    // 目标（定位流的时间基）是否在正在读取的GOP中还没读到的部分
+    bool isAheadInCurrentGop(int64_t target) const;
+    // 在关键帧索引中查找目标之前的关键帧
+    bool findIndexedKeyframe(int64_t seek_target, int flags, KeyframeEntry &keyframe) const;
+    // 跳到索引中的关键帧
+    int seekToKeyframe(int stream_index, const KeyframeEntry &keyframe);
+    // 如果包是定位流的关键帧，把它加入索引；previous_pts是同一次连续读取中上一个加入索引的关键帧，会被更新
+    void recordKeyframe(const AVPacket *packet, int64_t &previous_pts);
+    // 后台扫描线程的入口
+    void indexingThread(std::string filename, int stream_index);
+    // 停止后台扫描线程
+    void stopIndexing();
+    // 生成索引文件的校验信息
+    bool makeSeekIndexKey(SeekIndexKey &key) const;
+    // 后台扫描的中断回调
+    static int indexInterruptCallback(void *opaque);
+    // 请求打断正在进行的读取，然后获取mutex_；只用于之后会重新定位或关闭上下文的操作
+    std::unique_lock<std::mutex> lockInterrupting();
+    // 为接下来的一次IO操作设置截止时间，io_timeout_us为0时不设置
+    void armIODeadline();
+    void disarmIODeadline() { io_interrupt_.deadline_ns = 0; }
+    // 把av_read_frame的错误码转换成读包的结果
+    DemuxStatus statusFromError(int error) const;
+    // 把没有被选中的流标记为丢弃，让libavformat直接跳过它们
+    void discardUnusedStreams();
+    // 丢掉一个不需要的包并计数
+    void dropPacket(AVPacket *packet);
+    // 为预读队列和暂存队列分配和释放包结构体，设置了缓冲池时从池中取、放回池中
+    AVPacket *acquirePacket();
+    void releasePacket(AVPacket **packet);
+    // 复制各流的时间基和类型，作为新的快照发布给describePacket使用
+    void captureStreamTiming();
+    // 各流的时间基和媒体类型，open()时复制，describePacket不需要访问AVStream
+    struct StreamTiming
+    {
+        std::vector<AVRational> time_bases;
+        std::vector<MediaType> types;
+    };
+    // 按timing快照描述一个包
+    static bool describePacket(const StreamTiming *timing, const AVPacket *packet, PacketInfo &info);
+
     MediaType type_; // 媒体类型
+    bool multi_stream_; // 是否同时输出视频和音频
     AVFormatContext *format_ctx_; // FFmpeg格式上下文，代表媒体文件
     AVStream* video_stream_; // 视频流
     AVStream* audio_stream_; // 音频流
     int video_stream_index_; // 视频流索引
     int audio_stream_index_; // 音频流索引
-    bool eof_file_; // 是否到达文件末尾
+    int opened_video_stream_index_; // open()选出的视频流，selectTrack()不修改它，放回缓存时使用
+    int opened_audio_stream_index_; // open()选出的音频流
+    std::string pool_options_key_; // open()时的选项对应的缓存键
+    AVStream* subtitle_stream_; // 字幕流
+    AVStream* data_stream_; // 数据流
+    int subtitle_stream_index_; // 字幕流索引
+    int data_stream_index_; // 数据流索引
+    std::atomic<bool> eof_file_; // 是否到达文件末尾，预读模式下由取到EOF的消费者设置
+    std::deque<AVPacket *> pending_[MEDIA_TYPE_COUNT]; // 多流模式下按类型暂存的包
+    int64_t pending_bytes_[MEDIA_TYPE_COUNT]; // 各类型暂存的字节数
+    OpenOptions open_options_; // open()的选项
+    OpenTiming open_timing_; // 最近一次open()的耗时
+    ProbeCache *probe_cache_; // 探测结果缓存，不持有
+    PacketPool *packet_pool_; // 包结构体的缓冲池，不持有
+    DemuxerPool *demuxer_pool_; // 已打开上下文的缓存，不持有
+    int streams_discarded_; // 被标记为丢弃的流数量
+    std::shared_ptr<const StreamTiming> stream_timing_; // 只通过std::atomic_load/atomic_store访问，快照创建后不再修改
+    DemuxMetrics metrics_; // 读取和定位的计数器与延迟直方图，在mutex_保护下写入，可以无锁读取
+    std::string filename_; // 当前打开的文件
+    SeekIndex seek_index_; // 定位流的关键帧索引
+    int index_stream_index_; // 关键帧索引对应的流
+    std::thread index_thread_; // 后台扫描线程
+    std::atomic<bool> index_abort_; // 通知后台扫描线程退出
+    bool index_cache_enabled_; // 是否读写关键帧索引文件
+    std::string index_cache_dir_; // 索引文件目录，为空时放在媒体文件旁边
+    int read_error_; // 最近一次av_read_frame的错误码
+    std::atomic<DemuxStatus> last_status_; // 最近一次读包的结果
+    IOInterrupt io_interrupt_; // 有操作在等待mutex_或者超过截止时间时打断format_ctx_上阻塞的IO
+    std::unique_ptr<IOInterruptLink> io_link_; // format_ctx_的中断回调指向它，随上下文一起放进DemuxerPool
+    PacketQueue read_ahead_queue_; // 预读队列，和Demuxer同生命周期，不加锁的消费者可以随时访问
+    std::thread read_ahead_thread_; // 预读线程
+    std::atomic<bool> read_ahead_abort_; // 通知预读线程退出
+    std::atomic<bool> read_ahead_running_; // 是否处于预读模式
+    std::mutex read_ahead_mutex_; // 串行化startReadAhead()和stopReadAhead()，停止时要在不持有mutex_的情况下等待预读线程
+    std::unique_ptr<MmapIO> mmap_io_; // use_mmap时format_ctx_使用的IO，在format_ctx_关闭后释放
+    std::unique_ptr<UringIO> uring_io_; // use_uring时format_ctx_使用的IO，在format_ctx_关闭后释放
+    PendingPacketOptions pending_options_; // 按类型读取时的暂存上限
+    SeekRequestOptions seek_request_options_; // 定位请求的限速和跳过规则
+    std::atomic<bool> seek_pending_; // 是否有挂起的定位请求，读包时先检查它，避免每次都加锁
+    int64_t pending_seek_timestamp_; // 挂起的定位目标（微秒），由seek_request_mutex_保护
+    int pending_seek_flags_; // 挂起的定位标志
+    int64_t pending_seek_id_; // 每次请求加一，执行时据此判断请求有没有被替换
+    bool pending_seek_deferred_; // 挂起的请求是否已经被限速推迟过
+    SeekRequestStats seek_request_stats_; // 定位请求的统计，由seek_request_mutex_保护
+    mutable std::mutex seek_request_mutex_; // 保护挂起的请求和统计，请求方不需要等待mutex_
+    std::chrono::steady_clock::time_point last_seek_time_; // 上一次执行容器定位的时间
+    std::atomic<int> seek_serial_; // 已经执行的定位次数
+    int64_t gop_start_pts_; // 正在读取的GOP的关键帧时间戳（定位流的时间基）
+    int64_t gop_max_pts_; // 当前GOP中已经读到的最大时间戳
+    int64_t indexed_keyframe_pts_; // 这次连续读取中最近加入索引的关键帧，定位后重置，用来标记索引中连续的部分
+    mutable std::mutex mutex_; // 保护format_ctx_的读取、定位以及暂存队列，多个消费者线程共用一个Demuxer
 };
-
@@ -0,0 +1,191 @@
+#include "demuxer_pool.hpp"
+
+#include "utils/logger.hpp"
+
+#include <sys/stat.h>
+
+PooledContext::~PooledContext()
+{
+    if (format_ctx)
+    {
+        avformat_close_input(&format_ctx);
+    }
+    // 自定义IO要在上下文关闭之后才能释放
+    mmap_io.reset();
+    uring_io.reset();
+}
+
+DemuxerPool::DemuxerPool(const DemuxerPoolOptions &options)
+    : options_(options)
+{
+}
+
+DemuxerPool::~DemuxerPool()
+{
+    clear();
+}
+
+DemuxerPool &DemuxerPool::instance()
+{
+    static DemuxerPool pool;
+    return pool;
+}
+
+void DemuxerPool::setOptions(const DemuxerPoolOptions &options)
+{
+    // 被淘汰的上下文在锁外面关闭
+    std::list<std::unique_ptr<PooledContext>> evicted;
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    evictLocked(evicted);
+}
+
+// 取最近放回的同路径、同选项的上下文，媒体文件的大小或修改时间变了就丢弃
+// 选项不同的上下文留在缓存中，给之后使用那组选项的Demuxer
+std::unique_ptr<PooledContext> DemuxerPool::acquire(const std::string &filename, const std::string &options_key)
+{
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+    bool identified = fileIdentity(filename, size, mtime_ns);
+    std::list<std::unique_ptr<PooledContext>> stale;
+    std::unique_ptr<PooledContext> context;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            if ((*it)->filename != filename || (*it)->options_key != options_key)
+            {
+                ++it;
+                continue;
+            }
+            bytes_ -= (*it)->bytes;
+            if (!identified || (*it)->file_size != size || (*it)->mtime_ns != mtime_ns)
+            {
+                stats_.stale++;
+                stale.push_back(std::move(*it));
+                it = entries_.erase(it);
+                continue;
+            }
+            context = std::move(*it);
+            entries_.erase(it);
+            break;
+        }
+        if (context)
+        {
+            stats_.hits++;
+        }
+        else
+        {
+            stats_.misses++;
+        }
+    }
+    return context;
+}
+
+void DemuxerPool::release(std::unique_ptr<PooledContext> context)
+{
+    if (!context || !context->format_ctx)
+    {
+        return;
+    }
+    AVFormatContext *ctx = context->format_ctx;
+    // 只缓存还能正常读取的本地文件
+    std::string path;
+    bool cacheable = MmapIO::isLocalPath(context->filename, path) && ctx->pb && !ctx->pb->error &&
+                     fileIdentity(context->filename, context->file_size, context->mtime_ns);
+    if (cacheable)
+    {
+        // 回到文件开头，下次取出后可以直接从头读取；seek同时清空libavformat内部缓冲的包
+        context->io_link->target = nullptr;
+        int64_t start = ctx->start_time != AV_NOPTS_VALUE ? ctx->start_time : 0;
+        int ret = avformat_seek_file(ctx, -1, INT64_MIN, start, start, 0);
+        if (ret < 0)
+        {
+            ret = av_seek_frame(ctx, -1, start, AVSEEK_FLAG_BACKWARD);
+        }
+        if (ret < 0)
+        {
+            LOG_WARN << "Could not rewind " << context->filename << ", closing it instead of pooling.";
+            cacheable = false;
+        }
+    }
+
+    std::list<std::unique_ptr<PooledContext>> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!cacheable)
+        {
+            stats_.rejected++;
+            evicted.push_back(std::move(context));
+        }
+        else
+        {
+            context->bytes = estimateBytes(ctx);
+            bytes_ += context->bytes;
+            stats_.released++;
+            entries_.push_front(std::move(context));
+            evictLocked(evicted);
+        }
+    }
+}
+
+void DemuxerPool::clear()
+{
+    std::list<std::unique_ptr<PooledContext>> closed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed.swap(entries_);
+        bytes_ = 0;
+    }
+}
+
+DemuxerPoolStats DemuxerPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    DemuxerPoolStats stats = stats_;
+    stats.entries = entries_.size();
+    stats.bytes = bytes_;
+    return stats;
+}
+
+// 从最旧的一端淘汰，直到数量和内存都不超过上限
+void DemuxerPool::evictLocked(std::list<std::unique_ptr<PooledContext>> &evicted)
+{
+    while (!entries_.empty() && (entries_.size() > options_.max_entries || (options_.max_bytes > 0 && bytes_ > options_.max_bytes)))
+    {
+        bytes_ -= entries_.back()->bytes;
+        evicted.push_back(std::move(entries_.back()));
+        entries_.pop_back();
+        stats_.evicted++;
+    }
+}
+
+bool DemuxerPool::fileIdentity(const std::string &filename, int64_t &size, int64_t &mtime_ns)
+{
+    std::string path;
+    struct stat st;
+    if (!MmapIO::isLocalPath(filename, path) || ::stat(path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    size = static_cast<int64_t>(st.st_size);
+    mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// AVFormatContext和AVStream本身的大小是固定的，主要的差别在IO缓冲区和mp4这类容器的索引
+int64_t DemuxerPool::estimateBytes(const AVFormatContext *format_ctx)
+{
+    int64_t bytes = 16 * 1024; // 上下文、私有数据和流结构体
+    if (format_ctx->pb)
+    {
+        bytes += format_ctx->pb->buffer_size;
+    }
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++)
+    {
+        const AVStream *stream = format_ctx->streams[i];
+        bytes += 1024 + stream->codecpar->extradata_size;
+        bytes += static_cast<int64_t>(avformat_index_get_entries_count(stream)) * sizeof(AVIndexEntry);
+    }
+    return bytes;
+}
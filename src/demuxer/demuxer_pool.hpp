@@ -0,0 +1,100 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "io_interrupt.hpp"
+#include "mmap_io.hpp"
+#include "uring_io.hpp"
+
+// 缓存的一个已经打开的上下文，连同它依赖的自定义IO和中断状态
+// 析构时关闭上下文，自定义IO在上下文之后释放
+struct PooledContext
+{
+    std::string filename;
+    std::string options_key;  // 打开时的探测和IO选项，只交给选项相同的Demuxer
+    AVFormatContext *format_ctx = nullptr;
+    std::unique_ptr<IOInterruptLink> io_link; // format_ctx的中断回调指向它，缓存期间不指向任何Demuxer
+    std::unique_ptr<MmapIO> mmap_io;
+    std::unique_ptr<UringIO> uring_io;
+    int video_stream_index = -1; // 打开时选出的流
+    int audio_stream_index = -1;
+    int64_t file_size = 0;       // 放回时媒体文件的大小和修改时间，取出时据此判断文件有没有被修改
+    int64_t mtime_ns = 0;
+    int64_t bytes = 0;           // 估算的内存占用
+
+    PooledContext() = default;
+    ~PooledContext();
+    PooledContext(const PooledContext &) = delete;
+    PooledContext &operator=(const PooledContext &) = delete;
+};
+
+// 缓存的数量和内存上限
+struct DemuxerPoolOptions
+{
+    size_t max_entries = 8;              // 最多缓存的上下文数
+    int64_t max_bytes = 64 * 1024 * 1024; // 所有缓存的上下文估算的内存总量上限
+};
+
+// 缓存的统计信息
+struct DemuxerPoolStats
+{
+    int64_t hits = 0;       // open()取到缓存的上下文的次数
+    int64_t misses = 0;     // 没有可用的缓存、需要重新打开的次数
+    int64_t stale = 0;      // 文件被修改过、缓存的上下文被丢弃的次数（同时计入misses）
+    int64_t released = 0;   // close()放回缓存的次数
+    int64_t rejected = 0;   // 无法回到文件开头等原因没有放回、直接关闭的次数
+    int64_t evicted = 0;    // 超过上限被淘汰的次数
+    size_t entries = 0;     // 当前缓存的上下文数
+    int64_t bytes = 0;      // 当前缓存估算的内存总量
+
+    double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+};
+
+// 进程内共用的已打开上下文缓存
+// Demuxer::close()不再关闭AVFormatContext，而是回到文件开头后放进缓存；下一次open()同一个路径时直接取出，
+// 省掉avformat_open_input和探测。只缓存本地文件，按最近最少使用淘汰
+// 同一个路径可以同时缓存多个上下文（例如A/B对比时同一个文件打开了两次），打开选项不同的上下文互不复用
+class DemuxerPool
+{
+public:
+    explicit DemuxerPool(const DemuxerPoolOptions &options = DemuxerPoolOptions());
+    ~DemuxerPool();
+
+    DemuxerPool(const DemuxerPool &) = delete;
+    DemuxerPool &operator=(const DemuxerPool &) = delete;
+
+    // 进程内共用的缓存
+    static DemuxerPool &instance();
+
+    // 修改上限，超出的条目立即淘汰
+    void setOptions(const DemuxerPoolOptions &options);
+    // 取出filename最近放回、打开选项为options_key的上下文，没有或者文件已经被修改时返回nullptr
+    std::unique_ptr<PooledContext> acquire(const std::string &filename, const std::string &options_key);
+    // 把上下文放回缓存，先回到文件开头；不能缓存的上下文直接关闭
+    void release(std::unique_ptr<PooledContext> context);
+    // 关闭所有缓存的上下文
+    void clear();
+    DemuxerPoolStats getStats() const;
+
+private:
+    // 读取媒体文件的大小和修改时间
+    static bool fileIdentity(const std::string &filename, int64_t &size, int64_t &mtime_ns);
+    // 估算上下文占用的内存：IO缓冲区、容器索引和编解码器额外数据
+    static int64_t estimateBytes(const AVFormatContext *format_ctx);
+    // 把超出上限的最旧条目移到evicted中，调用者需要持有mutex_
+    void evictLocked(std::list<std::unique_ptr<PooledContext>> &evicted);
+
+    DemuxerPoolOptions options_;
+    std::list<std::unique_ptr<PooledContext>> entries_; // 按放回的时间排列，最新的在前面
+    int64_t bytes_ = 0;
+    DemuxerPoolStats stats_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// 打断阻塞IO的状态，由Demuxer持有
+struct IOInterrupt
+{
+    std::atomic<int> requests{0};          // 正在等待锁、需要打断当前IO的操作数
+    std::atomic<int64_t> deadline_ns{0};   // 当前IO操作的截止时间（steady_clock纳秒），0表示没有
+    std::atomic<bool> deadline_hit{false}; // 当前IO操作是否因为超时被打断
+
+    // 有打断请求或者超过截止时间时返回true
+    bool shouldInterrupt()
+    {
+        if (requests.load(std::memory_order_relaxed) > 0)
+        {
+            return true;
+        }
+        int64_t deadline = deadline_ns.load(std::memory_order_relaxed);
+        if (deadline > 0 && std::chrono::steady_clock::now().time_since_epoch().count() > deadline)
+        {
+            deadline_hit = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+// AVFormatContext的中断回调的opaque，每个上下文一个，转发给当前使用这个上下文的Demuxer
+// libavformat打开文件时把中断回调按值复制到了底层的URLContext中，之后修改interrupt_callback不会影响已经打开的IO，
+// 所以上下文被DemuxerPool缓存后交给另一个Demuxer时，只能改这里的target
+struct IOInterruptLink
+{
+    std::atomic<IOInterrupt *> target; // 为空时不打断
+
+    explicit IOInterruptLink(IOInterrupt *state) : target(state) {}
+
+    // libavformat在阻塞的IO循环中定期调用，返回非0时当前操作以AVERROR_EXIT结束
+    // 网络协议大约每100毫秒检查一次；本地文件的单次read()不会被打断，但读完这一块就会返回
+    static int callback(void *opaque)
+    {
+        IOInterrupt *state = static_cast<IOInterruptLink *>(opaque)->target.load(std::memory_order_acquire);
+        return state && state->shouldInterrupt() ? 1 : 0;
+    }
+};
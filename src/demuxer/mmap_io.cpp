@@ -0,0 +1,282 @@
+#include "mmap_io.hpp"
+
+#include "utils/logger.hpp"
+
+extern "C"
+{
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // 交给AVIOContext的缓冲区大小，direct模式下只用于容器头部这类小读取，包数据不经过它
+    constexpr int AVIO_BUFFER_SIZE = 32 * 1024;
+    // 顺序读取时提前预读的窗口
+    constexpr int64_t PREFETCH_WINDOW = 8 * 1024 * 1024;
+    // 当前位置之后超过这个距离的页才会被释放，保留足够的空间给小范围的回退
+    constexpr int64_t RELEASE_LAG = 64 * 1024 * 1024;
+    // 向后跳转超过这个距离才当作随机访问（拖动进度条、倒放），容器回头重读盒子头这类小跳转不算
+    constexpr int64_t RANDOM_JUMP = 1024 * 1024;
+    // 随机访问提示只作用于跳转目标之后的这一段，文件其他部分保持顺序访问
+    constexpr int64_t RANDOM_REGION = 8 * 1024 * 1024;
+    // 跳转之后连续向前读了这么多字节，说明又开始正常播放，恢复顺序访问提示
+    constexpr int64_t SEQUENTIAL_RESUME = 2 * 1024 * 1024;
+
+    // 把偏移向下对齐到页边界，madvise要求起始地址按页对齐
+    int64_t pageFloor(int64_t offset)
+    {
+        static const int64_t page_size = sysconf(_SC_PAGESIZE);
+        return offset - offset % page_size;
+    }
+}
+
+MmapIO::MmapIO()
+    : fd_(-1), data_(nullptr), size_(0), pos_(0), avio_ctx_(nullptr), random_start_(0), random_end_(0),
+      prefetched_until_(0), released_until_(0), bytes_read_(0), seek_count_(0)
+{
+}
+
+MmapIO::~MmapIO()
+{
+    close();
+}
+
+// 判断是否是本地文件路径
+bool MmapIO::isLocalPath(const std::string &url, std::string &path)
+{
+    if (url.compare(0, 5, "file:") == 0)
+    {
+        path = url.substr(5);
+        return !path.empty();
+    }
+    if (url.find("://") != std::string::npos || url == "-" || url.compare(0, 5, "pipe:") == 0)
+    {
+        return false;
+    }
+    path = url;
+    return !path.empty();
+}
+
+// 映射文件并创建AVIOContext
+bool MmapIO::open(const std::string &path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        LOG_WARN << "Failed to mmap " << path << ": " << std::strerror(errno);
+        ::close(fd);
+        size_ = 0;
+        return false;
+    }
+    fd_ = fd;
+    data_ = static_cast<uint8_t *>(data);
+    madvise(data_, size_, MADV_SEQUENTIAL);
+
+    // AVIOContext的缓冲区必须用av_malloc分配，之后可能被libavformat替换，释放时以avio_ctx_->buffer为准
+    unsigned char *buffer = static_cast<unsigned char *>(av_malloc(AVIO_BUFFER_SIZE));
+    if (!buffer)
+    {
+        close();
+        return false;
+    }
+    avio_ctx_ = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, &MmapIO::readCallback, nullptr, &MmapIO::seekCallback);
+    if (!avio_ctx_)
+    {
+        av_free(buffer);
+        close();
+        return false;
+    }
+    // 读取包数据时跳过AVIOContext的缓冲区，从映射区直接拷贝到调用者的缓冲区
+    avio_ctx_->direct = 1;
+    LOG_INFO << "Mapped " << size_ << " bytes of " << path;
+    return true;
+}
+
+// 释放AVIOContext并解除映射
+void MmapIO::close()
+{
+    if (avio_ctx_)
+    {
+        av_freep(&avio_ctx_->buffer);
+        avio_context_free(&avio_ctx_);
+    }
+    if (data_)
+    {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    pos_ = 0;
+    random_start_ = 0;
+    random_end_ = 0;
+    prefetched_until_ = 0;
+    released_until_ = 0;
+    bytes_read_ = 0;
+    seek_count_ = 0;
+}
+
+// 文件被截短之后映射区结尾的页已经不存在，只能访问文件现在还有的部分；文件变长时仍然只使用映射的部分
+int64_t MmapIO::availableSize() const
+{
+    struct stat st;
+    if (fstat(fd_, &st) != 0)
+    {
+        return static_cast<int64_t>(size_);
+    }
+    return std::min<int64_t>(static_cast<int64_t>(size_), std::max<int64_t>(st.st_size, 0));
+}
+
+// 从映射区拷贝数据，拷贝之前按文件当前的大小截断；fstat的开销远小于一次拷贝
+int MmapIO::readCallback(void *opaque, uint8_t *buf, int buf_size)
+{
+    MmapIO *io = static_cast<MmapIO *>(opaque);
+    int64_t available = io->availableSize();
+    if (io->pos_ >= available)
+    {
+        return AVERROR_EOF;
+    }
+    int64_t remaining = available - io->pos_;
+    int size = static_cast<int>(std::min<int64_t>(buf_size, remaining));
+    std::memcpy(buf, io->data_ + io->pos_, size);
+    io->pos_ += size;
+    io->bytes_read_ += size;
+    io->adviseAfterRead();
+    return size;
+}
+
+// 跳转只修改位置，AVSEEK_SIZE返回文件当前的大小
+// 跳到文件被截短后的结尾之后是允许的，和lseek一样，之后的读取返回EOF
+int64_t MmapIO::seekCallback(void *opaque, int64_t offset, int whence)
+{
+    MmapIO *io = static_cast<MmapIO *>(opaque);
+    int64_t new_pos;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    case AVSEEK_SIZE:
+        return io->availableSize();
+    case SEEK_SET:
+        new_pos = offset;
+        break;
+    case SEEK_CUR:
+        new_pos = io->pos_ + offset;
+        break;
+    case SEEK_END:
+        new_pos = io->availableSize() + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (new_pos < 0 || new_pos > static_cast<int64_t>(io->size_))
+    {
+        return AVERROR(EINVAL);
+    }
+    int64_t old_pos = io->pos_;
+    io->pos_ = new_pos;
+    io->seek_count_++;
+    io->adviseAfterSeek(old_pos);
+    return new_pos;
+}
+
+// 顺序读取时每读过半个窗口就把下一个窗口标记为WILLNEED，并释放远在后方的页
+// 随机访问期间不预读也不释放，从跳转目标向前读够SEQUENTIAL_RESUME之后恢复
+void MmapIO::adviseAfterRead()
+{
+    if (isRandomAccess())
+    {
+        if (pos_ - random_start_ < SEQUENTIAL_RESUME)
+        {
+            return;
+        }
+        endRandomAccess();
+    }
+    int64_t size = static_cast<int64_t>(size_);
+    if (pos_ + PREFETCH_WINDOW / 2 > prefetched_until_ && prefetched_until_ < size)
+    {
+        int64_t start = pageFloor(std::max(pos_, prefetched_until_));
+        int64_t end = std::min(size, pos_ + PREFETCH_WINDOW);
+        if (end > start)
+        {
+            madvise(data_ + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+        }
+        prefetched_until_ = end;
+    }
+    int64_t release_end = pageFloor(pos_ - RELEASE_LAG);
+    if (release_end > released_until_)
+    {
+        madvise(data_ + released_until_, static_cast<size_t>(release_end - released_until_), MADV_DONTNEED);
+        released_until_ = release_end;
+    }
+}
+
+// 大幅向后跳转（倒放、拖动进度条）时把目标之后的一段改为随机访问，避免内核按顺序预读用不到的数据
+// 大幅向前跳转时恢复顺序访问提示，小范围的跳转不改变访问模式
+void MmapIO::adviseAfterSeek(int64_t old_pos)
+{
+    int64_t size = static_cast<int64_t>(size_);
+    bool random_jump = pos_ < old_pos - RANDOM_JUMP;
+    if (random_jump)
+    {
+        endRandomAccess();
+        random_start_ = pageFloor(pos_);
+        random_end_ = std::min(size, pos_ + RANDOM_REGION);
+        if (random_end_ > random_start_)
+        {
+            madvise(data_ + random_start_, static_cast<size_t>(random_end_ - random_start_), MADV_RANDOM);
+        }
+    }
+    else if (pos_ > old_pos + RANDOM_JUMP)
+    {
+        endRandomAccess();
+    }
+    released_until_ = std::min(released_until_, pageFloor(pos_));
+    // direct模式下容器跳过不需要的字节、回头重读都会调用seek，落在已经预读的窗口中时不需要新的提示
+    if (!random_jump && pos_ >= old_pos - RANDOM_JUMP && pos_ < prefetched_until_)
+    {
+        return;
+    }
+    // 新位置附近的数据马上就要读，提前提示
+    int64_t start = pageFloor(pos_);
+    int64_t end = std::min(size, pos_ + (random_jump ? PREFETCH_WINDOW / 8 : PREFETCH_WINDOW));
+    if (end > start)
+    {
+        madvise(data_ + start, static_cast<size_t>(end - start), MADV_WILLNEED);
+    }
+    prefetched_until_ = end;
+}
+
+// 把随机访问的那一段恢复成顺序访问
+void MmapIO::endRandomAccess()
+{
+    if (random_end_ > random_start_)
+    {
+        madvise(data_ + random_start_, static_cast<size_t>(random_end_ - random_start_), MADV_SEQUENTIAL);
+    }
+    random_start_ = 0;
+    random_end_ = 0;
+}
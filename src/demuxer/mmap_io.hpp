@@ -0,0 +1,68 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avio.h>
+}
+
+#include <cstdint>
+#include <string>
+
+// 基于内存映射的本地文件读取后端
+// 把整个文件映射到内存，AVIOContext的读取直接从映射区拷贝，不再经过read()系统调用
+// AVIOContext使用direct模式，包数据从映射区直接拷贝进AVPacket，不经过AVIOContext的缓冲区
+// 文件在播放时可能被截短或者覆盖写（例如ffmpeg -y输出到同一个路径），访问映射区中已经不存在的页会触发SIGBUS，
+// 所以每次读取和取大小前都重新fstat，按文件当前的大小截断，和默认的文件协议一样返回短读和EOF
+// （fstat和拷贝之间恰好被截短的极小窗口仍然无法排除）
+// 根据读取方向调整madvise提示：顺序向前时预读前方的窗口并释放远在后方的页，
+// 大幅向后跳转时把目标附近改为随机访问，之后向前读一段距离就恢复顺序访问
+class MmapIO
+{
+public:
+    MmapIO();
+    ~MmapIO();
+
+    MmapIO(const MmapIO &) = delete;
+    MmapIO &operator=(const MmapIO &) = delete;
+
+    // 映射文件并创建AVIOContext
+    bool open(const std::string &path);
+    void close();
+
+    // 交给AVFormatContext::pb使用，所有权仍属于MmapIO
+    AVIOContext *getAVIOContext() const { return avio_ctx_; }
+    int64_t size() const { return static_cast<int64_t>(size_); }
+    // 读取的总字节数和跳转次数
+    int64_t getBytesRead() const { return bytes_read_; }
+    int64_t getSeekCount() const { return seek_count_; }
+    // 最近一次大幅向后跳转的目标附近是否正在使用随机访问提示
+    bool isRandomAccess() const { return random_end_ > random_start_; }
+
+    // 判断是否是可以映射的本地文件路径，file:前缀会被去掉
+    static bool isLocalPath(const std::string &url, std::string &path);
+
+private:
+    // AVIOContext的回调
+    static int readCallback(void *opaque, uint8_t *buf, int buf_size);
+    static int64_t seekCallback(void *opaque, int64_t offset, int whence);
+
+    // 文件当前还能安全访问的大小：映射时的大小和文件现在的大小中较小的一个
+    int64_t availableSize() const;
+    // 根据当前位置和方向更新madvise提示
+    void adviseAfterRead();
+    void adviseAfterSeek(int64_t old_pos);
+    // 把随机访问的那一段恢复成顺序访问
+    void endRandomAccess();
+
+    int fd_; // 映射的文件，保持打开用来检查文件有没有被截短
+    uint8_t *data_; // 映射区
+    size_t size_; // 映射时的文件大小
+    int64_t pos_; // 当前读取位置
+    AVIOContext *avio_ctx_; // 交给libavformat的IO上下文
+    int64_t random_start_; // 使用随机访问提示的区间，没有时两者相等
+    int64_t random_end_;
+    int64_t prefetched_until_; // 已经提示预读到的位置
+    int64_t released_until_; // 已经释放到的位置
+    int64_t bytes_read_; // 读取的总字节数
+    int64_t seek_count_; // 跳转次数
+};
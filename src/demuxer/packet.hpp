@@ -0,0 +1,28 @@
+#pragma once
+
+extern "C"
+{
+//编解码器API，AVPacket定义在这里
+#include <libavcodec/avcodec.h>
+}
+
+#include <memory>
+
+// AVPacket的删除器，配合std::unique_ptr使用
+// av_packet_free会先unref包内的数据再释放结构体本身
+struct AVPacketDeleter
+{
+    void operator()(AVPacket *packet) const
+    {
+        av_packet_free(&packet);
+    }
+};
+
+// 只能移动不能拷贝的AVPacket句柄，离开作用域时自动释放
+using PacketPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
+
+// 分配一个新的AVPacket并交给PacketPtr管理，分配失败时返回空句柄
+inline PacketPtr makePacket()
+{
+    return PacketPtr(av_packet_alloc());
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+extern "C"
+{
+//AVPacket和av_rescale_q
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstdint>
+#include "mediadefs.hpp"
+
+// 流时间基下的时间戳换算成微秒，AV_NOPTS_VALUE保持不变
+inline int64_t toMicroseconds(int64_t timestamp, AVRational time_base)
+{
+    return timestamp != AV_NOPTS_VALUE ? av_rescale_q(timestamp, time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE;
+}
+
+// 微秒换算成流时间基下的时间戳，AV_NOPTS_VALUE保持不变
+inline int64_t fromMicroseconds(int64_t timestamp_us, AVRational time_base)
+{
+    return timestamp_us != AV_NOPTS_VALUE ? av_rescale_q(timestamp_us, AV_TIME_BASE_Q, time_base) : AV_NOPTS_VALUE;
+}
+
+// 包的精简描述，时间戳已经换算成微秒
+// 同步、排队、统计这类热循环只需要这些字段，不用再访问AVPacket和AVStream；32字节，一条缓存行放两个
+struct PacketInfo
+{
+    enum Flags : uint8_t
+    {
+        KEY = 1 << 0,     // 关键帧
+        CORRUPT = 1 << 1, // 容器标记为损坏
+        DISCARD = 1 << 2, // 解码后应该丢弃（例如编码器延迟产生的开头几帧）
+    };
+
+    int64_t pts_us = AV_NOPTS_VALUE;
+    int64_t dts_us = AV_NOPTS_VALUE;
+    int64_t duration_us = 0;
+    int32_t size = 0;
+    int16_t stream_index = -1;
+    MediaType type = MediaType::DATA;
+    uint8_t flags = 0;
+
+    bool isKeyframe() const { return (flags & KEY) != 0; }
+    bool isCorrupt() const { return (flags & CORRUPT) != 0; }
+    // 排队和计算缓冲时长用的时间戳：优先dts，没有时用pts
+    int64_t timestampUs() const { return dts_us != AV_NOPTS_VALUE ? dts_us : pts_us; }
+    // 显示结束的时间，没有pts时返回AV_NOPTS_VALUE
+    int64_t endUs() const { return pts_us != AV_NOPTS_VALUE ? pts_us + duration_us : AV_NOPTS_VALUE; }
+
+    // 按包所属流的时间基换算
+    static PacketInfo from(const AVPacket *packet, AVRational time_base, MediaType type)
+    {
+        PacketInfo info;
+        info.pts_us = toMicroseconds(packet->pts, time_base);
+        info.dts_us = toMicroseconds(packet->dts, time_base);
+        info.duration_us = packet->duration > 0 ? av_rescale_q(packet->duration, time_base, AV_TIME_BASE_Q) : 0;
+        info.size = packet->size;
+        info.stream_index = static_cast<int16_t>(packet->stream_index);
+        info.type = type;
+        info.flags = static_cast<uint8_t>(((packet->flags & AV_PKT_FLAG_KEY) ? KEY : 0) |
+                                          ((packet->flags & AV_PKT_FLAG_CORRUPT) ? CORRUPT : 0) |
+                                          ((packet->flags & AV_PKT_FLAG_DISCARD) ? DISCARD : 0));
+        return info;
+    }
+};
+
+static_assert(sizeof(PacketInfo) == 32, "PacketInfo should stay at 32 bytes");
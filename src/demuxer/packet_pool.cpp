@@ -0,0 +1,74 @@
+#include "packet_pool.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+
+PacketPool::PacketPool(int64_t max_bytes)
+    : max_bytes_(max_bytes), requests_(0), hits_(0), bypassed_(0), high_water_bytes_(0)
+{
+}
+
+PacketPool::~PacketPool()
+{
+    PacketPoolStats stats = getStats();
+    LOG_INFO << "Packet pool released: " << stats.requests << " requests, hit rate " << stats.hitRate()
+             << ", high water " << stats.high_water_bytes << " bytes";
+    for (AVPacket *packet : free_)
+    {
+        av_packet_free(&packet);
+    }
+}
+
+// 优先复用池中空闲的包
+AVPacket *PacketPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests_++;
+        if (!free_.empty())
+        {
+            AVPacket *packet = free_.back();
+            free_.pop_back();
+            hits_++;
+            return packet;
+        }
+    }
+    return av_packet_alloc();
+}
+
+// 包内的数据在锁外释放，它可能是最后一个引用，释放会走到分配器
+void PacketPool::release(AVPacket **packet)
+{
+    if (!packet || !*packet)
+    {
+        return;
+    }
+    av_packet_unref(*packet);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t resident = static_cast<int64_t>(free_.size() + 1) * static_cast<int64_t>(sizeof(AVPacket));
+        if (max_bytes_ <= 0 || resident <= max_bytes_)
+        {
+            free_.push_back(*packet);
+            *packet = nullptr;
+            high_water_bytes_ = std::max(high_water_bytes_, resident);
+            return;
+        }
+        bypassed_++;
+    }
+    av_packet_free(packet);
+}
+
+PacketPoolStats PacketPool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    PacketPoolStats stats;
+    stats.requests = requests_;
+    stats.hits = hits_;
+    stats.bypassed = bypassed_;
+    stats.bytes_resident = static_cast<int64_t>(free_.size()) * static_cast<int64_t>(sizeof(AVPacket));
+    stats.high_water_bytes = high_water_bytes_;
+    stats.max_bytes = max_bytes_;
+    return stats;
+}
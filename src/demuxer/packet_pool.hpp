@@ -0,0 +1,53 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 包缓冲池的统计信息
+struct PacketPoolStats
+{
+    int64_t requests = 0;         // 申请包的次数
+    int64_t hits = 0;             // 复用了池中空闲包的次数
+    int64_t bypassed = 0;         // 归还时超过内存上限，直接释放的次数
+    int64_t bytes_resident = 0;   // 池中空闲的包占用的字节数
+    int64_t high_water_bytes = 0; // bytes_resident的最大值
+    int64_t max_bytes = 0;        // 内存上限
+
+    double hitRate() const { return requests > 0 ? static_cast<double>(hits) / requests : 0.0; }
+};
+
+// Demuxer内部每个包都要用到的AVPacket结构体的缓冲池
+// 预读队列和多流模式的暂存队列为每个包分配一个AVPacket，包数据移交给消费者之后结构体放回池中，下一个包直接复用
+// 包数据由libavformat在av_read_frame内部分配，它没有提供指定分配器的接口，拷贝到池中的缓冲区只会多一次分配和拷贝，所以不经过这里
+// 池内部加锁，一个池可以被多个Demuxer和消费者线程共用
+class PacketPool
+{
+public:
+    // max_bytes为池中空闲的包总大小的上限，达到上限后归还的包直接释放
+    explicit PacketPool(int64_t max_bytes = 1024 * 1024);
+    ~PacketPool();
+
+    PacketPool(const PacketPool &) = delete;
+    PacketPool &operator=(const PacketPool &) = delete;
+
+    // 取一个空的包，池中没有空闲的包时新分配，分配失败返回nullptr
+    AVPacket *acquire();
+    // 释放包内的数据后把结构体放回池中，*packet被置为nullptr，用法和av_packet_free一样
+    void release(AVPacket **packet);
+    PacketPoolStats getStats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<AVPacket *> free_; // 空闲的包
+    int64_t max_bytes_;
+    int64_t requests_;
+    int64_t hits_;
+    int64_t bypassed_;
+    int64_t high_water_bytes_;
+};
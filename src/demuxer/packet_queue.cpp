@@ -0,0 +1,180 @@
+#include "packet_queue.hpp"
+#include "packet_pool.hpp"
+
+#include <chrono>
+
+PacketQueue::PacketQueue(int max_packets, int64_t max_bytes, int64_t max_duration_us)
+    : max_packets_(max_packets), max_bytes_(max_bytes), max_duration_us_(max_duration_us),
+      bytes_(0), serial_(0), aborted_(false), pool_(nullptr)
+{
+}
+
+PacketQueue::~PacketQueue()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearItems();
+}
+
+// 包数、字节数、缓冲时长任意一项达到上限即为满，限制为0或负数时不检查该项
+// 队列为空时永远不满，保证单个超大的包也能入队
+bool PacketQueue::isFull() const
+{
+    if (items_.empty())
+    {
+        return false;
+    }
+    if (max_packets_ > 0 && static_cast<int>(items_.size()) >= max_packets_)
+    {
+        return true;
+    }
+    if (max_bytes_ > 0 && bytes_ >= max_bytes_)
+    {
+        return true;
+    }
+    if (max_duration_us_ > 0)
+    {
+        int64_t first = items_.front().dts_us;
+        int64_t last = items_.back().dts_us;
+        if (first != AV_NOPTS_VALUE && last != AV_NOPTS_VALUE && last - first >= max_duration_us_)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 入队
+bool PacketQueue::push(PacketQueueItem item)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this, &item] { return aborted_ || item.serial != serial_ || !isFull(); });
+    if (aborted_ || item.serial != serial_)
+    {
+        // 定位之前读到的包已经没用了
+        releasePacket(&item.packet);
+        return false;
+    }
+    if (item.packet)
+    {
+        bytes_ += item.packet->size;
+    }
+    items_.push_back(item);
+    not_empty_.notify_one();
+    return true;
+}
+
+// 出队
+DemuxStatus PacketQueue::pop(AVPacket *packet, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto ready = [this] { return aborted_ || !items_.empty(); };
+    if (timeout_ms < 0)
+    {
+        not_empty_.wait(lock, ready);
+    }
+    else if (!not_empty_.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready))
+    {
+        return DemuxStatus::TIMEOUT;
+    }
+    if (items_.empty())
+    {
+        return DemuxStatus::ABORTED; // 队列被中止
+    }
+
+    PacketQueueItem item = items_.front();
+    items_.pop_front();
+    not_full_.notify_one();
+    if (item.status != DemuxStatus::OK)
+    {
+        // EOF和错误项留在队列头部，消费者重复读取时仍然得到同样的状态，直到发生定位
+        items_.push_front(item);
+        return item.status;
+    }
+    bytes_ -= item.packet->size;
+    av_packet_unref(packet);
+    av_packet_move_ref(packet, item.packet);
+    releasePacket(&item.packet);
+    return DemuxStatus::OK;
+}
+
+// 清空队列并递增序号
+int PacketQueue::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearItems();
+    serial_++;
+    not_full_.notify_all();
+    return serial_;
+}
+
+// 生产者到达EOF或出错后等待定位
+void PacketQueue::waitForSerialChange(int serial)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this, serial] { return aborted_ || serial_ != serial; });
+}
+
+// 中止队列
+void PacketQueue::abort()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    aborted_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+// 清空队列并重新开始使用，序号递增，停止之前残留的生产者的包入队时被丢弃
+void PacketQueue::start(int max_packets, int64_t max_bytes, int64_t max_duration_us, PacketPool *pool)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clearItems();
+    pool_ = pool;
+    max_packets_ = max_packets;
+    max_bytes_ = max_bytes;
+    max_duration_us_ = max_duration_us;
+    aborted_ = false;
+    serial_++;
+    not_full_.notify_all();
+}
+
+int PacketQueue::serial() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return serial_;
+}
+
+int PacketQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(items_.size());
+}
+
+int64_t PacketQueue::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+// 释放所有项
+void PacketQueue::clearItems()
+{
+    for (PacketQueueItem &item : items_)
+    {
+        releasePacket(&item.packet);
+    }
+    items_.clear();
+    bytes_ = 0;
+}
+
+// 释放一个包
+void PacketQueue::releasePacket(AVPacket **packet)
+{
+    if (pool_)
+    {
+        pool_->release(packet);
+    }
+    else
+    {
+        av_packet_free(packet);
+    }
+}
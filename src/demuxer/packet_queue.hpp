@@ -0,0 +1,84 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+class PacketPool;
+
+// 读包的结果
+enum class DemuxStatus
+{
+    OK,          // 读到一个包
+    TIMEOUT,     // 等待超时，队列里暂时没有包
+    END_OF_FILE, // 到达文件末尾
+    ERROR,       // 读取出错
+    ABORTED,     // 读取被seek()、close()或停止预读打断，不是错误，重试或者等定位完成即可
+    AGAIN,       // 多流模式下为其他类型暂存的包达到上限，需要其他类型的消费者先取走暂存的包再读
+};
+
+// 队列中的一项：一个包，或者按顺序排在包后面的EOF/错误
+struct PacketQueueItem
+{
+    AVPacket *packet = nullptr;             // status为OK时有效，队列持有它
+    DemuxStatus status = DemuxStatus::OK;
+    int serial = 0;                         // 入队时的序号，定位后旧序号的项全部作废
+    int64_t dts_us = AV_NOPTS_VALUE;        // 包的解码时间戳（微秒），用于计算缓冲的时长
+};
+
+// 有界的包队列，同时限制包数、字节数和缓冲的时长
+// 定位时flush()清空队列并递增序号，生产者手里旧序号的包入队时会被直接丢弃
+class PacketQueue
+{
+public:
+    PacketQueue(int max_packets, int64_t max_bytes, int64_t max_duration_us);
+    ~PacketQueue();
+
+    PacketQueue(const PacketQueue &) = delete;
+    PacketQueue &operator=(const PacketQueue &) = delete;
+
+    // 入队，队列满时阻塞等待；序号已过期或队列已中止时丢弃该项并返回false
+    bool push(PacketQueueItem item);
+    // 出队，最多等待timeout_ms毫秒，负数表示一直等待
+    // 成功时把包移动到调用者的packet中；EOF或错误项按它们在队列中的位置返回
+    DemuxStatus pop(AVPacket *packet, int timeout_ms);
+    // 清空队列并递增序号，返回新的序号
+    int flush();
+    // 生产者到达EOF或出错后调用，一直等到序号变化（发生定位）或队列中止
+    void waitForSerialChange(int serial);
+    // 中止队列，唤醒所有等待的线程
+    void abort();
+    // 清空队列，换成新的上限后重新开始使用
+    // pool不为空时，包数据移交给消费者或者被丢弃之后，空的结构体放回pool，pool需要比队列活得更久
+    void start(int max_packets, int64_t max_bytes, int64_t max_duration_us, PacketPool *pool = nullptr);
+
+    int serial() const;
+    int size() const;
+    int64_t bytes() const;
+
+private:
+    // 队列是否已经满了，调用者需要持有mutex_
+    bool isFull() const;
+    // 释放所有项，调用者需要持有mutex_
+    void clearItems();
+    // 释放一个包，有缓冲池时放回池中
+    void releasePacket(AVPacket **packet);
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_; // 有新的项或队列中止
+    std::condition_variable not_full_;  // 有空间、序号变化或队列中止
+    std::deque<PacketQueueItem> items_;
+    int max_packets_;        // 最大包数
+    int64_t max_bytes_;      // 最大字节数
+    int64_t max_duration_us_; // 最大缓冲时长（微秒）
+    int64_t bytes_;          // 当前缓冲的字节数
+    int serial_;             // 当前序号
+    bool aborted_;           // 是否已中止
+    PacketPool *pool_;       // 包结构体的缓冲池，不持有
+};
@@ -0,0 +1,221 @@
+#include "packet_tee.hpp"
+#include "demuxer.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+TeeSink::TeeSink(const std::string &name, const TeeSinkOptions &options)
+    : name_(name), options_(options), queue_(options.capacity)
+{
+}
+
+TeeSinkStats TeeSink::getStats() const
+{
+    TeeSinkStats stats;
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.dropped_bytes = dropped_bytes_.load(std::memory_order_relaxed);
+    stats.blocked_us = blocked_us_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+bool TeeSink::accepts(int stream_index) const
+{
+    return options_.streams.empty() ||
+           std::find(options_.streams.begin(), options_.streams.end(), stream_index) != options_.streams.end();
+}
+
+void TeeSink::recordDrop(const PacketInfo &info)
+{
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    dropped_bytes_.fetch_add(info.size, std::memory_order_relaxed);
+    if (options_.policy == TeeOverflowPolicy::DROP_UNTIL_KEYFRAME)
+    {
+        waiting_keyframe_[info.stream_index] = 1;
+    }
+}
+
+// 只增加包数据的引用计数，数据本身由Demuxer读出的包和所有接收端共用
+void TeeSink::offer(const AVPacket *packet, const PacketInfo &info, int serial)
+{
+    if (queue_.isClosed() || !accepts(packet->stream_index))
+    {
+        return;
+    }
+    if (waiting_keyframe_.size() <= static_cast<size_t>(packet->stream_index))
+    {
+        waiting_keyframe_.resize(packet->stream_index + 1, 0);
+    }
+    // 丢过包的流要等到关键帧才恢复，前面的包即使放得下也解不出来
+    if (waiting_keyframe_[packet->stream_index])
+    {
+        if (!info.isKeyframe())
+        {
+            recordDrop(info);
+            return;
+        }
+        waiting_keyframe_[packet->stream_index] = 0;
+    }
+    // 明知放不下时不用分配引用
+    if (options_.policy != TeeOverflowPolicy::BLOCK && queue_.full())
+    {
+        recordDrop(info);
+        return;
+    }
+
+    TeePacket item;
+    item.packet = makePacket();
+    if (!item.packet || av_packet_ref(item.packet.get(), packet) < 0)
+    {
+        LOG_ERROR << "Failed to reference packet for tee sink " << name_ << ".";
+        recordDrop(info);
+        return;
+    }
+    item.info = info;
+    item.serial = serial;
+    if (queue_.tryPush(std::move(item)))
+    {
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (options_.policy != TeeOverflowPolicy::BLOCK)
+    {
+        recordDrop(info);
+        return;
+    }
+    // 等接收端取走，接收端close()时放弃
+    auto wait_start = std::chrono::steady_clock::now();
+    bool pushed = queue_.push(std::move(item));
+    blocked_us_.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - wait_start).count(),
+                          std::memory_order_relaxed);
+    if (pushed)
+    {
+        delivered_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PacketTee::PacketTee(Demuxer &demuxer)
+    : demuxer_(demuxer)
+{
+}
+
+PacketTee::~PacketTee()
+{
+    stop();
+}
+
+std::shared_ptr<TeeSink> PacketTee::addSink(const std::string &name, const TeeSinkOptions &options)
+{
+    auto sink = std::make_shared<TeeSink>(name, options);
+    std::lock_guard<std::mutex> lock(mutex_);
+    sinks_.push_back(sink);
+    sinks_version_.fetch_add(1, std::memory_order_release);
+    LOG_INFO << "Tee sink added: " << name << " (capacity " << sink->queue_.capacity() << ")";
+    return sink;
+}
+
+void PacketTee::removeSink(const std::shared_ptr<TeeSink> &sink)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sinks_.erase(std::remove(sinks_.begin(), sinks_.end(), sink), sinks_.end());
+        sinks_version_.fetch_add(1, std::memory_order_release);
+    }
+    // 在锁外面关闭，分发线程可能正阻塞在这个接收端上
+    if (sink)
+    {
+        sink->close();
+    }
+}
+
+size_t PacketTee::getSinkCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sinks_.size();
+}
+
+bool PacketTee::readPacket(AVPacket *packet)
+{
+    PacketInfo info;
+    if (!demuxer_.readPacket(packet, info))
+    {
+        return false;
+    }
+    distribute(packet, info);
+    return true;
+}
+
+// 接收端列表很少变化，分发时只比较一次版本号，不加锁
+void PacketTee::distribute(const AVPacket *packet, const PacketInfo &info)
+{
+    uint64_t version = sinks_version_.load(std::memory_order_acquire);
+    if (version != active_version_)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_sinks_ = sinks_;
+        active_version_ = sinks_version_.load(std::memory_order_relaxed);
+    }
+    int serial = demuxer_.getSeekSerial();
+    for (const std::shared_ptr<TeeSink> &sink : active_sinks_)
+    {
+        sink->offer(packet, info, serial);
+    }
+}
+
+void PacketTee::finish()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const std::shared_ptr<TeeSink> &sink : sinks_)
+    {
+        sink->close();
+    }
+    LOG_INFO << "Tee finished, " << sinks_.size() << " sinks closed.";
+}
+
+bool PacketTee::start()
+{
+    if (pump_thread_.joinable())
+    {
+        LOG_WARN << "Tee is already running.";
+        return false;
+    }
+    pump_abort_ = false;
+    pump_thread_ = std::thread(&PacketTee::pumpThread, this);
+    return true;
+}
+
+void PacketTee::stop()
+{
+    if (!pump_thread_.joinable())
+    {
+        return;
+    }
+    pump_abort_ = true;
+    pump_thread_.join();
+}
+
+void PacketTee::pumpThread()
+{
+    PacketPtr packet = makePacket();
+    if (!packet)
+    {
+        LOG_ERROR << "Failed to allocate packet.";
+        return;
+    }
+    while (!pump_abort_)
+    {
+        if (readPacket(packet.get()))
+        {
+            continue;
+        }
+        // 被定位打断或单次IO超时时重试，文件结束和读取错误都结束分发
+        DemuxStatus status = demuxer_.getLastStatus();
+        if (status != DemuxStatus::ABORTED && status != DemuxStatus::TIMEOUT)
+        {
+            finish();
+            break;
+        }
+    }
+}
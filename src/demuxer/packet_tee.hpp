@@ -0,0 +1,137 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "packet.hpp"
+#include "packet_info.hpp"
+#include "utils/ring_queue.hpp"
+
+class Demuxer;
+
+// 接收端的队列满时的处理方式
+enum class TeeOverflowPolicy
+{
+    BLOCK,               // 等待接收端取走，不丢包；接收端慢时会拖慢读取和其他所有接收端，适合不能丢包的录制
+    DROP_NEWEST,         // 丢掉放不下的包，读取不受影响，适合统计分析
+    DROP_UNTIL_KEYFRAME  // 丢包后同一个流一直丢到下一个关键帧，接收端拿到的包总能从关键帧开始解码，适合转推和预览
+};
+
+// 接收端的选项
+struct TeeSinkOptions
+{
+    size_t capacity = 256;                                            // 队列容量（包数），会向上取整到2的幂
+    TeeOverflowPolicy policy = TeeOverflowPolicy::DROP_UNTIL_KEYFRAME;
+    std::vector<int> streams;                                         // 只接收这些流的包，为空时接收全部
+};
+
+// 接收端的统计
+struct TeeSinkStats
+{
+    int64_t delivered = 0;     // 放进队列的包数
+    int64_t dropped = 0;       // 丢掉的包数，包括等关键帧时丢掉的
+    int64_t dropped_bytes = 0;
+    int64_t blocked_us = 0;    // BLOCK策略下等待接收端的总时间（微秒）
+};
+
+// 分发给接收端的一项，包与Demuxer读出的包共用数据缓冲区
+struct TeePacket
+{
+    PacketPtr packet;
+    PacketInfo info; // 时间戳已经换算成微秒
+    int serial = 0;  // 读出时Demuxer的定位序号，变化时接收端需要清空自己的状态
+};
+
+// 一个接收端，由PacketTee创建，消费者在自己的线程中取包
+// 每个接收端有独立的单生产者单消费者队列，互相之间不会影响
+class TeeSink
+{
+public:
+    TeeSink(const std::string &name, const TeeSinkOptions &options);
+
+    // 取一个包，队列为空时等待；PacketTee::finish()之后取完剩余的包返回false
+    bool pop(TeePacket &item) { return queue_.pop(item); }
+    // 不等待，队列为空时返回false
+    bool tryPop(TeePacket &item) { return queue_.tryPop(item); }
+    // 接收端不再需要包时调用，之后PacketTee不再给它分发，阻塞在它上面的分发立即返回
+    void close() { queue_.close(); }
+    bool isClosed() const { return queue_.isClosed(); }
+
+    const std::string &getName() const { return name_; }
+    size_t size() const { return queue_.size(); }
+    TeeSinkStats getStats() const;
+
+private:
+    friend class PacketTee;
+
+    // 生产者一侧：按策略放入一个包的引用，只在PacketTee的分发线程中调用
+    void offer(const AVPacket *packet, const PacketInfo &info, int serial);
+    // 是否接收这个流的包
+    bool accepts(int stream_index) const;
+    void recordDrop(const PacketInfo &info);
+
+    std::string name_;
+    TeeSinkOptions options_;
+    utils::SpscQueue<TeePacket> queue_;
+    std::vector<uint8_t> waiting_keyframe_; // 按流索引记录是否在等关键帧，只由生产者访问
+    std::atomic<int64_t> delivered_{0};
+    std::atomic<int64_t> dropped_{0};
+    std::atomic<int64_t> dropped_bytes_{0};
+    std::atomic<int64_t> blocked_us_{0};
+};
+
+// 把一个Demuxer读出的包分发给多个接收端（播放的同时录制、分析或转推）
+// 每个接收端拿到的是av_packet_ref得到的引用，不复制包数据；各接收端有自己的有界队列和溢出策略，慢的接收端不会拖住播放
+// 两种用法：
+// 1. 播放线程调用readPacket()读包，读到的包照常交给播放，同时分发给接收端
+// 2. start()启动后台线程一直读到文件结束，所有消费者都作为接收端
+class PacketTee
+{
+public:
+    explicit PacketTee(Demuxer &demuxer);
+    ~PacketTee();
+
+    PacketTee(const PacketTee &) = delete;
+    PacketTee &operator=(const PacketTee &) = delete;
+
+    // 添加接收端，可以在分发过程中随时添加，新接收端从下一个包开始接收
+    std::shared_ptr<TeeSink> addSink(const std::string &name, const TeeSinkOptions &options = TeeSinkOptions());
+    // 移除接收端并关闭它的队列，队列中剩余的包仍然可以取出
+    void removeSink(const std::shared_ptr<TeeSink> &sink);
+    size_t getSinkCount() const;
+
+    // 从Demuxer读一个包到packet，同时分发给接收端；返回值与Demuxer::readPacket相同
+    bool readPacket(AVPacket *packet);
+    // 把调用者自己读到的包分发给接收端
+    void distribute(const AVPacket *packet, const PacketInfo &info);
+    // 文件读完后关闭所有接收端的队列，接收端取完剩余的包后pop()返回false
+    void finish();
+
+    // 启动后台分发线程，读到文件结束或出错后自动finish()
+    bool start();
+    // 停止后台分发线程，不关闭接收端；线程阻塞在不再取包的BLOCK接收端上时，需要先close()那个接收端
+    void stop();
+    bool isRunning() const { return pump_thread_.joinable(); }
+
+private:
+    void pumpThread();
+
+    Demuxer &demuxer_;
+    std::vector<std::shared_ptr<TeeSink>> sinks_; // 由mutex_保护
+    std::atomic<uint64_t> sinks_version_{0};      // sinks_每次修改加一
+    // 分发一侧使用的sinks_副本，版本变化时才重新复制；分发时不持有mutex_，BLOCK接收端等待时也能增删接收端
+    std::vector<std::shared_ptr<TeeSink>> active_sinks_;
+    uint64_t active_version_ = 0;
+    mutable std::mutex mutex_;
+    std::thread pump_thread_;
+    std::atomic<bool> pump_abort_{false};
+};
@@ -0,0 +1,719 @@
+#include "probe_cache.hpp"
+
+#include "utils/logger.hpp"
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+}
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace
+{
+    // 缓存文件的魔数和版本号，格式变化时需要增加版本号
+    constexpr char CACHE_MAGIC[4] = {'F', 'F', 'P', 'C'};
+    constexpr uint32_t CACHE_VERSION = 1;
+    // 文件头：魔数、版本、条目数、保留字段、访问计数
+    constexpr size_t HEADER_SIZE = 4 + 4 + 4 + 4 + 8;
+    // 文件头中访问计数的偏移
+    constexpr off_t HEADER_TICK_OFFSET = 16;
+    // 单个字段的长度上限，防止损坏的文件导致超大分配
+    constexpr uint32_t MAX_FIELD_SIZE = 16 * 1024 * 1024;
+
+    // 向缓冲区追加定长字段
+    class Writer
+    {
+    public:
+        template <typename T>
+        void put(const T &value)
+        {
+            const char *bytes = reinterpret_cast<const char *>(&value);
+            buffer_.append(bytes, sizeof(T));
+        }
+        void putBytes(const void *data, uint32_t size)
+        {
+            put(size);
+            buffer_.append(static_cast<const char *>(data), size);
+        }
+        void putRational(AVRational value)
+        {
+            put<int32_t>(value.num);
+            put<int32_t>(value.den);
+        }
+        std::string &buffer() { return buffer_; }
+
+    private:
+        std::string buffer_;
+    };
+
+    // 从缓冲区读取定长字段，越界后所有读取都失败
+    class Reader
+    {
+    public:
+        Reader(const char *data, size_t size) : data_(data), size_(size), offset_(0), ok_(true) {}
+
+        template <typename T>
+        bool get(T &value)
+        {
+            if (!ok_ || size_ - offset_ < sizeof(T))
+            {
+                ok_ = false;
+                return false;
+            }
+            std::memcpy(&value, data_ + offset_, sizeof(T));
+            offset_ += sizeof(T);
+            return true;
+        }
+        bool getBytes(std::string &out)
+        {
+            uint32_t size = 0;
+            if (!get(size) || size > MAX_FIELD_SIZE || size_ - offset_ < size)
+            {
+                ok_ = false;
+                return false;
+            }
+            out.assign(data_ + offset_, size);
+            offset_ += size;
+            return true;
+        }
+        bool getRational(AVRational &value)
+        {
+            int32_t num = 0;
+            int32_t den = 1;
+            get(num);
+            get(den);
+            value = AVRational{num, den};
+            return ok_;
+        }
+        bool skip(size_t size)
+        {
+            if (!ok_ || size_ - offset_ < size)
+            {
+                ok_ = false;
+                return false;
+            }
+            offset_ += size;
+            return true;
+        }
+        size_t offset() const { return offset_; }
+        bool ok() const { return ok_; }
+
+    private:
+        const char *data_;
+        size_t size_;
+        size_t offset_;
+        bool ok_;
+    };
+
+    // 持有文件锁，析构时解锁并关闭
+    class FileLock
+    {
+    public:
+        explicit FileLock(const std::string &path) : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))
+        {
+            if (fd_ >= 0 && flock(fd_, LOCK_EX) != 0)
+            {
+                ::close(fd_);
+                fd_ = -1;
+            }
+        }
+        ~FileLock()
+        {
+            if (fd_ >= 0)
+            {
+                flock(fd_, LOCK_UN);
+                ::close(fd_);
+            }
+        }
+        bool locked() const { return fd_ >= 0; }
+
+    private:
+        int fd_;
+    };
+
+    void writeStream(Writer &writer, const CachedStream &stream)
+    {
+        writer.put(stream.codec_type);
+        writer.put(stream.codec_id);
+        writer.put(stream.codec_tag);
+        writer.put(stream.format);
+        writer.put(stream.bit_rate);
+        writer.put(stream.bits_per_coded_sample);
+        writer.put(stream.bits_per_raw_sample);
+        writer.put(stream.profile);
+        writer.put(stream.level);
+        writer.put(stream.width);
+        writer.put(stream.height);
+        writer.putRational(stream.sample_aspect_ratio);
+        writer.putRational(stream.framerate);
+        writer.put(stream.field_order);
+        writer.put(stream.color_range);
+        writer.put(stream.color_primaries);
+        writer.put(stream.color_trc);
+        writer.put(stream.color_space);
+        writer.put(stream.chroma_location);
+        writer.put(stream.video_delay);
+        writer.put(stream.channel_order);
+        writer.put(stream.nb_channels);
+        writer.put(stream.channel_mask);
+        writer.put(stream.sample_rate);
+        writer.put(stream.block_align);
+        writer.put(stream.frame_size);
+        writer.put(stream.initial_padding);
+        writer.put(stream.trailing_padding);
+        writer.put(stream.seek_preroll);
+        writer.putRational(stream.avg_frame_rate);
+        writer.putRational(stream.r_frame_rate);
+        writer.put(stream.start_time);
+        writer.put(stream.duration);
+        writer.putBytes(stream.extradata.data(), static_cast<uint32_t>(stream.extradata.size()));
+    }
+
+    bool readStream(Reader &reader, CachedStream &stream)
+    {
+        reader.get(stream.codec_type);
+        reader.get(stream.codec_id);
+        reader.get(stream.codec_tag);
+        reader.get(stream.format);
+        reader.get(stream.bit_rate);
+        reader.get(stream.bits_per_coded_sample);
+        reader.get(stream.bits_per_raw_sample);
+        reader.get(stream.profile);
+        reader.get(stream.level);
+        reader.get(stream.width);
+        reader.get(stream.height);
+        reader.getRational(stream.sample_aspect_ratio);
+        reader.getRational(stream.framerate);
+        reader.get(stream.field_order);
+        reader.get(stream.color_range);
+        reader.get(stream.color_primaries);
+        reader.get(stream.color_trc);
+        reader.get(stream.color_space);
+        reader.get(stream.chroma_location);
+        reader.get(stream.video_delay);
+        reader.get(stream.channel_order);
+        reader.get(stream.nb_channels);
+        reader.get(stream.channel_mask);
+        reader.get(stream.sample_rate);
+        reader.get(stream.block_align);
+        reader.get(stream.frame_size);
+        reader.get(stream.initial_padding);
+        reader.get(stream.trailing_padding);
+        reader.get(stream.seek_preroll);
+        reader.getRational(stream.avg_frame_rate);
+        reader.getRational(stream.r_frame_rate);
+        reader.get(stream.start_time);
+        reader.get(stream.duration);
+        std::string extradata;
+        reader.getBytes(extradata);
+        stream.extradata.assign(extradata.begin(), extradata.end());
+        return reader.ok();
+    }
+
+    // 整个写入，处理被信号打断和部分写入
+    bool writeAll(int fd, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+ProbeCache::ProbeCache(const std::string &cache_path, size_t max_entries, size_t max_bytes)
+    : cache_path_(cache_path), lock_path_(cache_path + ".lock"), max_entries_(max_entries),
+      max_bytes_(max_bytes), hits_(0), misses_(0)
+{
+}
+
+// 读取媒体文件的大小和修改时间，用来判断缓存是否过期
+bool ProbeCache::statFile(const std::string &path, int64_t &size, int64_t &mtime_ns)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    size = static_cast<int64_t>(st.st_size);
+    mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+// 读取整个文件的内容
+bool ProbeCache::readFile(int fd, std::string &data)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        return false;
+    }
+    data.resize(static_cast<size_t>(st.st_size));
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t got = pread(fd, &data[offset], data.size() - offset, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            return false;
+        }
+        offset += static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// 解析缓存文件，格式不对或版本不同时返回false
+// 每条记录之前有记录长度，遇到截断或损坏的记录时丢弃它和之后的所有记录
+bool ProbeCache::parseEntries(const std::string &data, std::vector<Entry> &entries, uint64_t &tick)
+{
+    entries.clear();
+    tick = 0;
+    Reader reader(data.data(), data.size());
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint32_t count = 0;
+    uint32_t reserved = 0;
+    reader.get(magic);
+    reader.get(version);
+    reader.get(count);
+    reader.get(reserved);
+    reader.get(tick);
+    if (!reader.ok() || std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 || version != CACHE_VERSION)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t record_size = 0;
+        if (!reader.get(record_size) || record_size > data.size() - reader.offset())
+        {
+            break;
+        }
+        Entry entry;
+        entry.access_offset = reader.offset();
+        Reader record(data.data() + reader.offset(), record_size);
+        std::string path;
+        uint32_t nb_streams = 0;
+        record.get(entry.last_access);
+        record.get(entry.file_size);
+        record.get(entry.mtime_ns);
+        record.getBytes(path);
+        record.get(entry.result.video_stream_index);
+        record.get(entry.result.audio_stream_index);
+        record.get(entry.result.duration);
+        record.get(entry.result.start_time);
+        record.get(nb_streams);
+        if (!record.ok() || nb_streams > record_size)
+        {
+            break;
+        }
+        entry.path = std::move(path);
+        entry.result.streams.resize(nb_streams);
+        bool ok = true;
+        for (CachedStream &stream : entry.result.streams)
+        {
+            ok = ok && readStream(record, stream);
+        }
+        if (!ok)
+        {
+            break;
+        }
+        entries.push_back(std::move(entry));
+        // 跳到下一条记录
+        reader.skip(record_size);
+    }
+    return true;
+}
+
+// 序列化一条记录，不包括前面的记录长度
+std::string ProbeCache::serializeEntry(const Entry &entry)
+{
+    Writer writer;
+    writer.put(entry.last_access);
+    writer.put(entry.file_size);
+    writer.put(entry.mtime_ns);
+    writer.putBytes(entry.path.data(), static_cast<uint32_t>(entry.path.size()));
+    writer.put(entry.result.video_stream_index);
+    writer.put(entry.result.audio_stream_index);
+    writer.put(entry.result.duration);
+    writer.put(entry.result.start_time);
+    writer.put(static_cast<uint32_t>(entry.result.streams.size()));
+    for (const CachedStream &stream : entry.result.streams)
+    {
+        writeStream(writer, stream);
+    }
+    return std::move(writer.buffer());
+}
+
+// 把所有记录写入临时文件，再用rename原子地替换缓存文件
+// 其他进程要么看到旧文件，要么看到完整的新文件
+bool ProbeCache::writeEntries(const std::vector<Entry> &entries, uint64_t tick) const
+{
+    Writer writer;
+    writer.put(CACHE_MAGIC);
+    writer.put(CACHE_VERSION);
+    writer.put(static_cast<uint32_t>(entries.size()));
+    writer.put(static_cast<uint32_t>(0));
+    writer.put(tick);
+    for (const Entry &entry : entries)
+    {
+        std::string record = serializeEntry(entry);
+        writer.putBytes(record.data(), static_cast<uint32_t>(record.size()));
+    }
+
+    std::string temp_path = cache_path_ + ".tmp." + std::to_string(getpid());
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        LOG_WARN << "Failed to create probe cache file: " << temp_path;
+        return false;
+    }
+    const std::string &data = writer.buffer();
+    bool ok = writeAll(fd, data.data(), data.size()) && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temp_path.c_str(), cache_path_.c_str()) != 0)
+    {
+        LOG_WARN << "Failed to write probe cache file: " << cache_path_;
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// 查找媒体文件的探测结果
+// 命中时只在原文件上就地更新这条记录的访问计数，不重写整个缓存
+bool ProbeCache::lookup(const std::string &media_path, ProbeResult &result)
+{
+    int64_t size = 0;
+    int64_t mtime_ns = 0;
+    if (!statFile(media_path, size, mtime_ns))
+    {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    FileLock lock(lock_path_);
+    if (!lock.locked())
+    {
+        LOG_WARN << "Failed to lock probe cache: " << lock_path_;
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    int fd = ::open(cache_path_.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0)
+    {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::string data;
+    std::vector<Entry> entries;
+    uint64_t tick = 0;
+    if (!readFile(fd, data) || !parseEntries(data, entries, tick))
+    {
+        ::close(fd);
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    for (Entry &entry : entries)
+    {
+        if (entry.path != media_path || entry.file_size != size || entry.mtime_ns != mtime_ns)
+        {
+            continue;
+        }
+        // 就地更新文件头和这条记录的访问计数，用于LRU淘汰
+        tick++;
+        if (pwrite(fd, &tick, sizeof(tick), HEADER_TICK_OFFSET) != sizeof(tick) ||
+            pwrite(fd, &tick, sizeof(tick), static_cast<off_t>(entry.access_offset)) != sizeof(tick))
+        {
+            LOG_WARN << "Failed to update probe cache access time.";
+        }
+        ::close(fd);
+        result = std::move(entry.result);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    ::close(fd);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// 保存媒体文件的探测结果
+bool ProbeCache::store(const std::string &media_path, const ProbeResult &result)
+{
+    Entry entry;
+    entry.path = media_path;
+    entry.result = result;
+    if (!statFile(media_path, entry.file_size, entry.mtime_ns))
+    {
+        return false;
+    }
+
+    FileLock lock(lock_path_);
+    if (!lock.locked())
+    {
+        LOG_WARN << "Failed to lock probe cache: " << lock_path_;
+        return false;
+    }
+
+    // 读取现有记录，文件不存在或损坏时从空缓存开始
+    std::vector<Entry> entries;
+    uint64_t tick = 0;
+    int fd = ::open(cache_path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0)
+    {
+        std::string data;
+        if (!readFile(fd, data) || !parseEntries(data, entries, tick))
+        {
+            entries.clear();
+            tick = 0;
+        }
+        ::close(fd);
+    }
+
+    // 同一路径只保留最新的一条
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [&media_path](const Entry &old) { return old.path == media_path; }),
+                  entries.end());
+    entry.last_access = ++tick;
+    entries.push_back(std::move(entry));
+
+    // 按访问计数从新到旧排序，超出条目数或字节数上限的旧条目被淘汰
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.last_access > b.last_access; });
+    size_t total_bytes = HEADER_SIZE;
+    size_t kept = 0;
+    for (; kept < entries.size() && kept < max_entries_; kept++)
+    {
+        size_t record_bytes = sizeof(uint32_t) + serializeEntry(entries[kept]).size();
+        if (kept > 0 && total_bytes + record_bytes > max_bytes_)
+        {
+            break;
+        }
+        total_bytes += record_bytes;
+    }
+    if (kept < entries.size())
+    {
+        LOG_INFO << "Evicting " << (entries.size() - kept) << " probe cache entries.";
+        entries.resize(kept);
+    }
+    return writeEntries(entries, tick);
+}
+
+// 删除缓存文件
+void ProbeCache::clear()
+{
+    FileLock lock(lock_path_);
+    ::unlink(cache_path_.c_str());
+}
+
+// 从探测完成的AVFormatContext中提取需要缓存的结果
+ProbeResult ProbeCache::capture(const AVFormatContext *format_ctx, int video_stream_index, int audio_stream_index)
+{
+    ProbeResult result;
+    result.video_stream_index = video_stream_index;
+    result.audio_stream_index = audio_stream_index;
+    result.duration = format_ctx->duration;
+    result.start_time = format_ctx->start_time;
+    result.streams.resize(format_ctx->nb_streams);
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++)
+    {
+        const AVStream *st = format_ctx->streams[i];
+        const AVCodecParameters *par = st->codecpar;
+        CachedStream &stream = result.streams[i];
+        stream.codec_type = par->codec_type;
+        stream.codec_id = par->codec_id;
+        stream.codec_tag = par->codec_tag;
+        stream.format = par->format;
+        stream.bit_rate = par->bit_rate;
+        stream.bits_per_coded_sample = par->bits_per_coded_sample;
+        stream.bits_per_raw_sample = par->bits_per_raw_sample;
+        stream.profile = par->profile;
+        stream.level = par->level;
+        stream.width = par->width;
+        stream.height = par->height;
+        stream.sample_aspect_ratio = par->sample_aspect_ratio;
+        stream.framerate = par->framerate;
+        stream.field_order = par->field_order;
+        stream.color_range = par->color_range;
+        stream.color_primaries = par->color_primaries;
+        stream.color_trc = par->color_trc;
+        stream.color_space = par->color_space;
+        stream.chroma_location = par->chroma_location;
+        stream.video_delay = par->video_delay;
+        stream.channel_order = par->ch_layout.order;
+        stream.nb_channels = par->ch_layout.nb_channels;
+        stream.channel_mask = par->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ? par->ch_layout.u.mask : 0;
+        stream.sample_rate = par->sample_rate;
+        stream.block_align = par->block_align;
+        stream.frame_size = par->frame_size;
+        stream.initial_padding = par->initial_padding;
+        stream.trailing_padding = par->trailing_padding;
+        stream.seek_preroll = par->seek_preroll;
+        stream.avg_frame_rate = st->avg_frame_rate;
+        stream.r_frame_rate = st->r_frame_rate;
+        stream.start_time = st->start_time;
+        stream.duration = st->duration;
+        if (par->extradata && par->extradata_size > 0)
+        {
+            stream.extradata.assign(par->extradata, par->extradata + par->extradata_size);
+        }
+    }
+    return result;
+}
+
+// 把缓存的结果填回刚打开的AVFormatContext
+// 容器头部已经给出的字段保持不变，只补上原本需要avformat_find_stream_info解码才能得到的部分
+bool ProbeCache::apply(const ProbeResult &result, AVFormatContext *format_ctx)
+{
+    // 没有文件头的格式（如MPEG-TS）在读包时才创建流，流的数量对不上就不能使用缓存
+    if (format_ctx->nb_streams != result.streams.size())
+    {
+        return false;
+    }
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++)
+    {
+        if (format_ctx->streams[i]->codecpar->codec_type != result.streams[i].codec_type)
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++)
+    {
+        AVStream *st = format_ctx->streams[i];
+        AVCodecParameters *par = st->codecpar;
+        const CachedStream &stream = result.streams[i];
+        if (par->codec_id == AV_CODEC_ID_NONE)
+        {
+            par->codec_id = static_cast<AVCodecID>(stream.codec_id);
+        }
+        if (par->codec_tag == 0)
+        {
+            par->codec_tag = stream.codec_tag;
+        }
+        if (par->format < 0)
+        {
+            par->format = stream.format;
+        }
+        if (par->bit_rate <= 0)
+        {
+            par->bit_rate = stream.bit_rate;
+        }
+        if (par->bits_per_coded_sample <= 0)
+        {
+            par->bits_per_coded_sample = stream.bits_per_coded_sample;
+        }
+        if (par->bits_per_raw_sample <= 0)
+        {
+            par->bits_per_raw_sample = stream.bits_per_raw_sample;
+        }
+        par->profile = stream.profile;
+        par->level = stream.level;
+        if (par->width <= 0 || par->height <= 0)
+        {
+            par->width = stream.width;
+            par->height = stream.height;
+        }
+        if (par->sample_aspect_ratio.num == 0)
+        {
+            par->sample_aspect_ratio = stream.sample_aspect_ratio;
+        }
+        if (par->framerate.num == 0)
+        {
+            par->framerate = stream.framerate;
+        }
+        par->field_order = static_cast<AVFieldOrder>(stream.field_order);
+        par->color_range = static_cast<AVColorRange>(stream.color_range);
+        par->color_primaries = static_cast<AVColorPrimaries>(stream.color_primaries);
+        par->color_trc = static_cast<AVColorTransferCharacteristic>(stream.color_trc);
+        par->color_space = static_cast<AVColorSpace>(stream.color_space);
+        par->chroma_location = static_cast<AVChromaLocation>(stream.chroma_location);
+        par->video_delay = stream.video_delay;
+        if (par->ch_layout.nb_channels <= 0 && stream.nb_channels > 0)
+        {
+            av_channel_layout_uninit(&par->ch_layout);
+            if (stream.channel_order == AV_CHANNEL_ORDER_NATIVE && stream.channel_mask)
+            {
+                av_channel_layout_from_mask(&par->ch_layout, stream.channel_mask);
+            }
+            else
+            {
+                av_channel_layout_default(&par->ch_layout, stream.nb_channels);
+            }
+        }
+        if (par->sample_rate <= 0)
+        {
+            par->sample_rate = stream.sample_rate;
+        }
+        if (par->block_align <= 0)
+        {
+            par->block_align = stream.block_align;
+        }
+        if (par->frame_size <= 0)
+        {
+            par->frame_size = stream.frame_size;
+        }
+        par->initial_padding = stream.initial_padding;
+        par->trailing_padding = stream.trailing_padding;
+        par->seek_preroll = stream.seek_preroll;
+        if (st->avg_frame_rate.num == 0)
+        {
+            st->avg_frame_rate = stream.avg_frame_rate;
+        }
+        if (st->r_frame_rate.num == 0)
+        {
+            st->r_frame_rate = stream.r_frame_rate;
+        }
+        if (st->start_time == AV_NOPTS_VALUE)
+        {
+            st->start_time = stream.start_time;
+        }
+        if (st->duration == AV_NOPTS_VALUE)
+        {
+            st->duration = stream.duration;
+        }
+        // extradata需要用av_malloc分配并带上填充字节，由AVCodecParameters负责释放
+        if (!par->extradata && !stream.extradata.empty())
+        {
+            size_t size = stream.extradata.size();
+            par->extradata = static_cast<uint8_t *>(av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (par->extradata)
+            {
+                std::memcpy(par->extradata, stream.extradata.data(), size);
+                par->extradata_size = static_cast<int>(size);
+            }
+        }
+    }
+    if (format_ctx->duration == AV_NOPTS_VALUE)
+    {
+        format_ctx->duration = result.duration;
+    }
+    if (format_ctx->start_time == AV_NOPTS_VALUE)
+    {
+        format_ctx->start_time = result.start_time;
+    }
+    return true;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 缓存的单个流的探测结果，字段与AVCodecParameters以及AVStream中探测得到的部分一一对应
+struct CachedStream
+{
+    int32_t codec_type = AVMEDIA_TYPE_UNKNOWN;
+    int32_t codec_id = AV_CODEC_ID_NONE;
+    uint32_t codec_tag = 0;
+    int32_t format = -1;
+    int64_t bit_rate = 0;
+    int32_t bits_per_coded_sample = 0;
+    int32_t bits_per_raw_sample = 0;
+    int32_t profile = 0;
+    int32_t level = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    AVRational sample_aspect_ratio = {0, 1};
+    AVRational framerate = {0, 1};
+    int32_t field_order = 0;
+    int32_t color_range = 0;
+    int32_t color_primaries = 0;
+    int32_t color_trc = 0;
+    int32_t color_space = 0;
+    int32_t chroma_location = 0;
+    int32_t video_delay = 0;
+    int32_t channel_order = 0;
+    int32_t nb_channels = 0;
+    uint64_t channel_mask = 0;
+    int32_t sample_rate = 0;
+    int32_t block_align = 0;
+    int32_t frame_size = 0;
+    int32_t initial_padding = 0;
+    int32_t trailing_padding = 0;
+    int32_t seek_preroll = 0;
+    AVRational avg_frame_rate = {0, 1};
+    AVRational r_frame_rate = {0, 1};
+    int64_t start_time = AV_NOPTS_VALUE;
+    int64_t duration = AV_NOPTS_VALUE;
+    std::vector<uint8_t> extradata;
+};
+
+// 一个媒体文件的探测结果
+struct ProbeResult
+{
+    int32_t video_stream_index = -1;
+    int32_t audio_stream_index = -1;
+    int64_t duration = AV_NOPTS_VALUE; // 微秒
+    int64_t start_time = AV_NOPTS_VALUE; // 微秒
+    std::vector<CachedStream> streams;
+};
+
+// 持久化在磁盘上的探测结果缓存
+// 以文件路径、大小和修改时间为键，保存选中的流索引、编解码参数和时长，命中时open()可以跳过avformat_find_stream_info
+// 缓存文件是紧凑的二进制格式，条目数和总字节数都有上限，超出时按最近最少使用淘汰
+// 多个进程通过同目录下的.lock文件上的flock互斥，写入先写临时文件再rename，读者不会看到写了一半的文件
+class ProbeCache
+{
+public:
+    ProbeCache(const std::string &cache_path, size_t max_entries = 256, size_t max_bytes = 4 * 1024 * 1024);
+
+    // 查找媒体文件的探测结果，文件大小或修改时间变化后视为未命中
+    bool lookup(const std::string &media_path, ProbeResult &result);
+    // 保存媒体文件的探测结果，覆盖旧条目，必要时淘汰最久未使用的条目
+    bool store(const std::string &media_path, const ProbeResult &result);
+    // 删除缓存文件
+    void clear();
+
+    // 从探测完成的AVFormatContext中提取需要缓存的结果
+    static ProbeResult capture(const AVFormatContext *format_ctx, int video_stream_index, int audio_stream_index);
+    // 把缓存的结果填回刚打开（尚未探测）的AVFormatContext，流的数量或类型对不上时返回false
+    static bool apply(const ProbeResult &result, AVFormatContext *format_ctx);
+
+    const std::string &getPath() const { return cache_path_; }
+    int64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+    int64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    // 缓存中的一条记录
+    struct Entry
+    {
+        std::string path;
+        int64_t file_size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t last_access = 0;
+        size_t access_offset = 0; // 访问计数在缓存文件中的偏移，只在读取时填写
+        ProbeResult result;
+    };
+
+    // 读取媒体文件的大小和修改时间
+    static bool statFile(const std::string &path, int64_t &size, int64_t &mtime_ns);
+    // 读取整个文件的内容
+    static bool readFile(int fd, std::string &data);
+    // 解析缓存文件，格式或版本不对时返回false
+    static bool parseEntries(const std::string &data, std::vector<Entry> &entries, uint64_t &tick);
+    // 序列化一条记录
+    static std::string serializeEntry(const Entry &entry);
+    // 把条目写入临时文件后原子替换缓存文件
+    bool writeEntries(const std::vector<Entry> &entries, uint64_t tick) const;
+
+    std::string cache_path_; // 缓存文件路径
+    std::string lock_path_; // 跨进程互斥的锁文件路径
+    size_t max_entries_; // 最大条目数
+    size_t max_bytes_; // 缓存文件的最大字节数
+    // 多个Demuxer共用同一个缓存时会在不同线程中计数，文件锁只串行化进程之间的访问
+    std::atomic<int64_t> hits_; // 命中次数
+    std::atomic<int64_t> misses_; // 未命中次数
+};
@@ -0,0 +1,394 @@
+#include "seek_index.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // 索引文件布局：64字节文件头 + entry_count个32字节的KeyframeEntry + 16字节文件尾
+    // 文件尾重复魔数和条目数，被截断的文件无法通过长度和文件尾检查
+    constexpr char INDEX_MAGIC[8] = {'F', 'F', 'G', 'L', 'S', 'I', 'D', 'X'};
+    constexpr char INDEX_END_MAGIC[8] = {'F', 'F', 'G', 'L', 'S', 'E', 'N', 'D'};
+    constexpr uint32_t INDEX_VERSION = 1;
+    constexpr uint32_t INDEX_FLAG_COMPLETE = 1;
+
+    struct IndexFileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t header_size;
+        uint32_t entry_size;
+        uint32_t flags;
+        uint64_t entry_count;
+        int64_t file_size;
+        int64_t mtime_ns;
+        int32_t stream_index;
+        int32_t time_base_num;
+        int32_t time_base_den;
+        uint32_t checksum; // 文件头前60字节的FNV-1a校验
+    };
+    static_assert(sizeof(IndexFileHeader) == 64, "Index file header must be 64 bytes");
+
+    struct IndexFileTrailer
+    {
+        char magic[8];
+        uint64_t entry_count;
+    };
+    static_assert(sizeof(IndexFileTrailer) == 16, "Index file trailer must be 16 bytes");
+
+    // FNV-1a哈希
+    uint32_t fnv1a(const void *data, size_t size)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t headerChecksum(const IndexFileHeader &header)
+    {
+        return fnv1a(&header, offsetof(IndexFileHeader, checksum));
+    }
+
+    // 整个写入，处理被信号打断和部分写入
+    bool writeAll(int fd, const void *data, size_t size)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = ::write(fd, bytes, size);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    // 按pts比较，用于二分查找
+    bool ptsLess(const KeyframeEntry &entry, int64_t pts)
+    {
+        return entry.pts < pts;
+    }
+
+    bool ptsGreater(int64_t pts, const KeyframeEntry &entry)
+    {
+        return pts < entry.pts;
+    }
+}
+
+SeekIndex::SeekIndex()
+    : complete_(false), map_base_(nullptr), map_size_(0), mapped_entries_(nullptr), mapped_count_(0)
+{
+}
+
+SeekIndex::~SeekIndex()
+{
+    unmap();
+}
+
+// 使用内存映射的索引时直接返回映射区，否则返回内存中的表
+const KeyframeEntry *SeekIndex::data() const
+{
+    return mapped_entries_ ? mapped_entries_ : entries_.data();
+}
+
+size_t SeekIndex::count() const
+{
+    return mapped_entries_ ? mapped_count_ : entries_.size();
+}
+
+// 添加一个关键帧
+// 顺序读取时新关键帧总在末尾，直接追加；定位后回头读到的关键帧用二分插入
+// 已经索引过的关键帧再次被连续读到时补上标志，填平之前留下的空洞
+void SeekIndex::add(const KeyframeEntry &entry, int64_t previous_pts)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 映射的索引是完整且只读的，读到的关键帧都已经在里面
+    if (mapped_entries_)
+    {
+        return;
+    }
+    auto it = (entries_.empty() || entries_.back().pts < entry.pts)
+                  ? entries_.end()
+                  : std::lower_bound(entries_.begin(), entries_.end(), entry.pts, ptsLess);
+    bool follows = previous_pts != std::numeric_limits<int64_t>::min() && it != entries_.begin() &&
+                   (it - 1)->pts == previous_pts;
+    if (it != entries_.end() && it->pts == entry.pts)
+    {
+        if (follows)
+        {
+            it->flags |= KEYFRAME_FLAG_FOLLOWS_PREVIOUS;
+        }
+        return; // 已经索引过
+    }
+    KeyframeEntry added = entry;
+    added.flags = follows ? (entry.flags | KEYFRAME_FLAG_FOLLOWS_PREVIOUS) : (entry.flags & ~KEYFRAME_FLAG_FOLLOWS_PREVIOUS);
+    entries_.insert(it, added);
+}
+
+// 查找pts小于等于target的最后一个关键帧
+bool SeekIndex::findFloor(int64_t target, KeyframeEntry &entry) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const KeyframeEntry *begin = data();
+    const KeyframeEntry *it = std::upper_bound(begin, begin + count(), target, ptsGreater);
+    if (it == begin)
+    {
+        return false;
+    }
+    entry = *(it - 1);
+    return true;
+}
+
+// 查找pts大于target的第一个关键帧
+bool SeekIndex::findNext(int64_t target, KeyframeEntry &entry) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const KeyframeEntry *begin = data();
+    const KeyframeEntry *end = begin + count();
+    const KeyframeEntry *it = std::upper_bound(begin, end, target, ptsGreater);
+    if (it == end)
+    {
+        return false;
+    }
+    entry = *it;
+    return true;
+}
+
+// 下一项带有FOLLOWS_PREVIOUS标志，说明两者之间读取时是连续的，target不会落在漏掉的GOP中
+bool SeekIndex::findSeekPoint(int64_t target, KeyframeEntry &entry) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const KeyframeEntry *begin = data();
+    const KeyframeEntry *end = begin + count();
+    const KeyframeEntry *it = std::upper_bound(begin, end, target, ptsGreater);
+    if (it == begin)
+    {
+        return false;
+    }
+    if (!complete_ && (it == end || !(it->flags & KEYFRAME_FLAG_FOLLOWS_PREVIOUS)))
+    {
+        return false;
+    }
+    entry = *(it - 1);
+    return true;
+}
+
+bool SeekIndex::findGopEnd(int64_t keyframe_pts, int64_t &end_pts) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const KeyframeEntry *begin = data();
+    const KeyframeEntry *end = begin + count();
+    const KeyframeEntry *next = std::upper_bound(begin, end, keyframe_pts, ptsGreater);
+    if (complete_)
+    {
+        end_pts = next == end ? std::numeric_limits<int64_t>::max() : next->pts;
+        return true;
+    }
+    // 关键帧本身要在索引中，并且下一项是紧接着它读到的
+    if (next == begin || next == end || (next - 1)->pts != keyframe_pts || !(next->flags & KEYFRAME_FLAG_FOLLOWS_PREVIOUS))
+    {
+        return false;
+    }
+    end_pts = next->pts;
+    return true;
+}
+
+void SeekIndex::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmap();
+    entries_.clear();
+    complete_ = false;
+}
+
+bool SeekIndex::isComplete() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return complete_;
+}
+
+void SeekIndex::setComplete(bool complete)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    complete_ = complete;
+}
+
+size_t SeekIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count();
+}
+
+int64_t SeekIndex::lastPts() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = count();
+    return n == 0 ? std::numeric_limits<int64_t>::min() : data()[n - 1].pts;
+}
+
+std::vector<KeyframeEntry> SeekIndex::entries() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<KeyframeEntry>(data(), data() + count());
+}
+
+bool SeekIndex::isMapped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return mapped_entries_ != nullptr;
+}
+
+// 解除内存映射
+void SeekIndex::unmap()
+{
+    if (map_base_)
+    {
+        munmap(map_base_, map_size_);
+    }
+    map_base_ = nullptr;
+    map_size_ = 0;
+    mapped_entries_ = nullptr;
+    mapped_count_ = 0;
+}
+
+// 把完整的索引写入文件
+// 先写同目录下的临时文件并fsync，再rename覆盖，读者要么看到旧文件要么看到完整的新文件
+bool SeekIndex::save(const std::string &path, const SeekIndexKey &key) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!complete_)
+    {
+        LOG_WARN << "Refusing to save incomplete seek index.";
+        return false;
+    }
+
+    IndexFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.header_size = sizeof(IndexFileHeader);
+    header.entry_size = sizeof(KeyframeEntry);
+    header.flags = INDEX_FLAG_COMPLETE;
+    header.entry_count = count();
+    header.file_size = key.file_size;
+    header.mtime_ns = key.mtime_ns;
+    header.stream_index = key.stream_index;
+    header.time_base_num = key.time_base_num;
+    header.time_base_den = key.time_base_den;
+    header.checksum = headerChecksum(header);
+
+    IndexFileTrailer trailer;
+    std::memcpy(trailer.magic, INDEX_END_MAGIC, sizeof(trailer.magic));
+    trailer.entry_count = header.entry_count;
+
+    std::string temp_path = path + ".tmp." + std::to_string(getpid());
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        LOG_WARN << "Failed to create seek index file: " << temp_path;
+        return false;
+    }
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, data(), count() * sizeof(KeyframeEntry)) &&
+              writeAll(fd, &trailer, sizeof(trailer)) &&
+              fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        LOG_WARN << "Failed to write seek index file: " << path;
+        ::unlink(temp_path.c_str());
+        return false;
+    }
+    LOG_INFO << "Saved " << header.entry_count << " keyframes to " << path;
+    return true;
+}
+
+// 内存映射索引文件
+// 只检查文件头、文件长度和文件尾，关键帧数组本身不做任何解析，映射后立即可以二分查找
+bool SeekIndex::load(const std::string &path, const SeekIndexKey &key)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(IndexFileHeader) + sizeof(IndexFileTrailer)))
+    {
+        ::close(fd);
+        return false;
+    }
+    size_t map_size = static_cast<size_t>(st.st_size);
+    void *base = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后文件描述符可以关闭
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const IndexFileHeader *header = static_cast<const IndexFileHeader *>(base);
+    bool valid = std::memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) == 0 &&
+                 header->version == INDEX_VERSION &&
+                 header->header_size == sizeof(IndexFileHeader) &&
+                 header->entry_size == sizeof(KeyframeEntry) &&
+                 header->checksum == headerChecksum(*header) &&
+                 (header->flags & INDEX_FLAG_COMPLETE) &&
+                 header->file_size == key.file_size &&
+                 header->mtime_ns == key.mtime_ns &&
+                 header->stream_index == key.stream_index &&
+                 header->time_base_num == key.time_base_num &&
+                 header->time_base_den == key.time_base_den;
+    // 长度必须与条目数严格一致，文件尾必须完好
+    if (valid)
+    {
+        uint64_t max_entries = (map_size - sizeof(IndexFileHeader) - sizeof(IndexFileTrailer)) / sizeof(KeyframeEntry);
+        valid = header->entry_count <= max_entries &&
+                map_size == sizeof(IndexFileHeader) + header->entry_count * sizeof(KeyframeEntry) + sizeof(IndexFileTrailer);
+    }
+    if (valid)
+    {
+        const IndexFileTrailer *trailer = reinterpret_cast<const IndexFileTrailer *>(
+            static_cast<const char *>(base) + map_size - sizeof(IndexFileTrailer));
+        valid = std::memcmp(trailer->magic, INDEX_END_MAGIC, sizeof(trailer->magic)) == 0 &&
+                trailer->entry_count == header->entry_count;
+    }
+    if (!valid)
+    {
+        LOG_WARN << "Ignoring stale or damaged seek index file: " << path;
+        munmap(base, map_size);
+        return false;
+    }
+
+    // 映射区是按页对齐的，文件头之后的关键帧数组满足8字节对齐
+    std::lock_guard<std::mutex> lock(mutex_);
+    unmap();
+    entries_.clear();
+    map_base_ = base;
+    map_size_ = map_size;
+    mapped_entries_ = reinterpret_cast<const KeyframeEntry *>(static_cast<const char *>(base) + sizeof(IndexFileHeader));
+    mapped_count_ = static_cast<size_t>(header->entry_count);
+    complete_ = true;
+    LOG_INFO << "Mapped " << mapped_count_ << " keyframes from " << path;
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 关键帧索引中的一项，时间戳使用流的时间基
+// 布局固定为32字节，便于直接写入文件和内存映射
+struct KeyframeEntry
+{
+    int64_t pts;  // 显示时间戳，没有pts时用dts代替
+    int64_t dts;  // 解码时间戳
+    int64_t pos;  // 包在文件中的字节偏移
+    int32_t size; // 包的字节数
+    int32_t flags; // KEYFRAME_FLAG_*
+};
+static_assert(sizeof(KeyframeEntry) == 32, "KeyframeEntry layout is part of the index file format");
+
+// 与索引中的前一个关键帧是在同一次连续读取中先后读到的，两者之间没有漏掉的关键帧
+// 定位之后读到的关键帧不带这个标志，索引在那里可能有空洞
+constexpr int32_t KEYFRAME_FLAG_FOLLOWS_PREVIOUS = 1;
+
+// 索引文件对应的媒体文件和流，用于判断索引文件是否过期
+struct SeekIndexKey
+{
+    int64_t file_size = 0;    // 媒体文件大小
+    int64_t mtime_ns = 0;     // 媒体文件修改时间（纳秒）
+    int32_t stream_index = -1; // 被索引的流
+    int32_t time_base_num = 0; // 时间戳使用的时间基
+    int32_t time_base_den = 0;
+};
+
+// 按pts排序的关键帧表，支持二分查找
+// 可以在读包线程和后台扫描线程中同时添加
+// 完整的索引可以保存为定长布局的二进制文件，下次打开时直接内存映射使用，不需要解析
+class SeekIndex
+{
+public:
+    SeekIndex();
+    ~SeekIndex();
+
+    SeekIndex(const SeekIndex &) = delete;
+    SeekIndex &operator=(const SeekIndex &) = delete;
+
+    // 添加一个关键帧，保持按pts有序，相同pts的项只保留一个
+    // previous_pts是同一次连续读取中紧挨在它前面读到的关键帧，不知道时（定位后的第一个关键帧）传INT64_MIN
+    // 它正好是索引中的前一项时，给这一项加上KEYFRAME_FLAG_FOLLOWS_PREVIOUS
+    void add(const KeyframeEntry &entry, int64_t previous_pts = INT64_MIN);
+    // 查找pts小于等于target的最后一个关键帧
+    bool findFloor(int64_t target, KeyframeEntry &entry) const;
+    // 查找pts大于target的第一个关键帧
+    bool findNext(int64_t target, KeyframeEntry &entry) const;
+    // 与findFloor相同，但只在确定它就是文件中target之前的最后一个关键帧时返回true：
+    // 索引已经完整，或者下一项在target之后并且与它之间没有空洞
+    bool findSeekPoint(int64_t target, KeyframeEntry &entry) const;
+    // 查找pts为keyframe_pts的关键帧所在GOP的终点，即文件中的下一个关键帧，确定时返回true
+    // 完整的索引中它是最后一个关键帧时end_pts为INT64_MAX；下一项与它之间可能有空洞时返回false
+    bool findGopEnd(int64_t keyframe_pts, int64_t &end_pts) const;
+
+    // 清空索引，同时解除内存映射
+    void clear();
+    // 索引是否覆盖了整个文件
+    bool isComplete() const;
+    void setComplete(bool complete);
+    // 关键帧数量
+    size_t size() const;
+    // 已索引的最大pts，索引为空时返回INT64_MIN
+    int64_t lastPts() const;
+    // 复制一份当前的关键帧表
+    std::vector<KeyframeEntry> entries() const;
+
+    // 把完整的索引写入文件，先写临时文件再rename，不会留下写了一半的索引文件
+    bool save(const std::string &path, const SeekIndexKey &key) const;
+    // 内存映射索引文件并直接使用，文件损坏、被截断或与key不符时返回false
+    bool load(const std::string &path, const SeekIndexKey &key);
+    // 当前是否在使用内存映射的索引
+    bool isMapped() const;
+
+private:
+    // 当前可查找的关键帧数组，调用者需要持有mutex_
+    const KeyframeEntry *data() const;
+    size_t count() const;
+    // 解除内存映射，调用者需要持有mutex_
+    void unmap();
+
+    mutable std::mutex mutex_; // 读包线程和扫描线程会同时访问
+    std::vector<KeyframeEntry> entries_; // 按pts排序的关键帧
+    bool complete_; // 是否已经扫描完整个文件
+    void *map_base_; // 索引文件的映射地址
+    size_t map_size_; // 映射的字节数
+    const KeyframeEntry *mapped_entries_; // 映射区中的关键帧数组
+    size_t mapped_count_; // 映射区中的关键帧数量
+};
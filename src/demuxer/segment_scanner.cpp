@@ -0,0 +1,384 @@
+#include "segment_scanner.hpp"
+#include "demuxer.hpp"
+#include "mmap_io.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace
+{
+    int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 包的解码时间戳（微秒），没有dts时用pts代替
+    int64_t packetTimestamp(const AVPacket *packet, const AVStream *stream)
+    {
+        int64_t ts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        return ts != AV_NOPTS_VALUE ? av_rescale_q(ts, stream->time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE;
+    }
+}
+
+ScanSegmentResult::ScanSegmentResult()
+{
+    for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+    {
+        first_dts_us[i] = AV_NOPTS_VALUE;
+        last_dts_us[i] = AV_NOPTS_VALUE;
+    }
+}
+
+SegmentScanner::SegmentScanner(const ScanOptions &options)
+    : options_(options)
+{
+}
+
+bool SegmentScanner::scan(const std::string &filename, ScanResult &result, std::vector<ScanSegmentResult> *segments_out)
+{
+    result = ScanResult();
+    auto start = std::chrono::steady_clock::now();
+    int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, threads);
+    bool parallel = threads > 1 && shouldParallelize(filename);
+
+    // 顺序扫描只有一段，从文件开头读到结尾
+    std::vector<int64_t> starts(1, INT64_MIN);
+    if (parallel)
+    {
+        auto partition_start = std::chrono::steady_clock::now();
+        starts = partition(filename, threads * std::max(1, options_.segments_per_thread));
+        result.partition_us = elapsedMicroseconds(partition_start);
+        if (starts.empty())
+        {
+            return false;
+        }
+    }
+    else
+    {
+        threads = 1;
+    }
+
+    std::vector<ScanSegmentResult> segments(starts.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        segments[i].start_dts_us = starts[i];
+        segments[i].end_dts_us = i + 1 < starts.size() ? starts[i + 1] : INT64_MAX;
+    }
+    threads = std::min(threads, static_cast<int>(segments.size()));
+
+    next_segment_ = 0;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back(&SegmentScanner::runWorker, this, std::cref(filename), std::ref(segments));
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    // 所有工作线程都打不开文件时分段没有被领取
+    bool complete = next_segment_ >= static_cast<int>(segments.size());
+    for (const ScanSegmentResult &segment : segments)
+    {
+        complete = complete && segment.complete;
+    }
+    if (!complete)
+    {
+        LOG_ERROR << "Failed to scan " << filename << ".";
+        return false;
+    }
+
+    merge(segments, result);
+    result.parallel = parallel;
+    result.threads = threads;
+    result.segments = static_cast<int>(segments.size());
+    result.total_us = elapsedMicroseconds(start);
+    LOG_INFO << "Scanned " << result.packets << " packets of " << filename << " in " << result.total_us << "us ("
+             << result.segments << " segments on " << result.threads << " threads).";
+    if (segments_out)
+    {
+        *segments_out = std::move(segments);
+    }
+    return true;
+}
+
+// 等分时长得到目标时间，定位到目标之前的关键帧，用这个关键帧的解码时间戳作为分段的起点
+// GOP比分段长时几个目标会落在同一个关键帧上，这些分段合并成一个
+std::vector<int64_t> SegmentScanner::partition(const std::string &filename, int segment_count)
+{
+    std::vector<int64_t> starts;
+    OpenOptions open_options;
+    open_options.fast_open = options_.fast_open;
+    Demuxer demuxer;
+    demuxer.setOpenOptions(open_options);
+    if (!demuxer.open(filename))
+    {
+        return starts;
+    }
+    AVFormatContext *ctx = demuxer.getFormatContext();
+    int primary = demuxer.getStreamIndex();
+    int64_t start_time = ctx->start_time != AV_NOPTS_VALUE ? ctx->start_time : 0;
+    int64_t duration = demuxer.getDuration();
+    starts.push_back(INT64_MIN);
+    if (primary < 0 || duration <= 0)
+    {
+        // 不知道时长时无法切分
+        return starts;
+    }
+
+    AVPacket *packet = av_packet_alloc();
+    for (int k = 1; k < segment_count; k++)
+    {
+        int64_t target = start_time + duration * k / segment_count;
+        if (!demuxer.seek(target, AVSEEK_FLAG_BACKWARD))
+        {
+            continue;
+        }
+        while (demuxer.readPacket(packet))
+        {
+            if (packet->stream_index == primary && (packet->flags & AV_PKT_FLAG_KEY))
+            {
+                int64_t keyframe = packetTimestamp(packet, ctx->streams[primary]);
+                if (keyframe != AV_NOPTS_VALUE && keyframe > starts.back())
+                {
+                    starts.push_back(keyframe);
+                }
+                av_packet_unref(packet);
+                break;
+            }
+            av_packet_unref(packet);
+        }
+    }
+    av_packet_free(&packet);
+    return starts;
+}
+
+// 每段从起点之前interleave_margin_us的关键帧开始读，丢掉起点之前的包
+// 读到解码时间戳超过终点interleave_margin_us的包时停止，终点之后的包属于下一段
+void SegmentScanner::runWorker(const std::string &filename, std::vector<ScanSegmentResult> &segments)
+{
+    OpenOptions open_options;
+    open_options.fast_open = options_.fast_open;
+    Demuxer demuxer;
+    demuxer.setOpenOptions(open_options);
+    if (!demuxer.open(filename))
+    {
+        return;
+    }
+    AVFormatContext *ctx = demuxer.getFormatContext();
+    int primary = demuxer.getStreamIndex();
+    int64_t start_time = ctx->start_time != AV_NOPTS_VALUE ? ctx->start_time : 0;
+    int64_t bucket_us = std::max<int64_t>(1, options_.bitrate_bucket_us);
+    int64_t margin = std::max<int64_t>(0, options_.interleave_margin_us);
+    AVPacket *packet = av_packet_alloc();
+    bool used = false;
+
+    int index;
+    while ((index = next_segment_.fetch_add(1)) < static_cast<int>(segments.size()))
+    {
+        ScanSegmentResult &segment = segments[index];
+        auto segment_start = std::chrono::steady_clock::now();
+        segment.stream_index = primary;
+        bool from_start = segment.start_dts_us == INT64_MIN;
+        if (!from_start || used)
+        {
+            int64_t target = from_start ? start_time : std::max(start_time, segment.start_dts_us - margin);
+            if (!demuxer.seek(target, AVSEEK_FLAG_BACKWARD))
+            {
+                continue;
+            }
+        }
+        used = true;
+
+        bool inside = from_start;
+        bool finished = false;
+        while (demuxer.readPacket(packet))
+        {
+            AVStream *stream = ctx->streams[packet->stream_index];
+            int64_t ts = packetTimestamp(packet, stream);
+            if (ts != AV_NOPTS_VALUE)
+            {
+                if (segment.end_dts_us != INT64_MAX && ts >= segment.end_dts_us && ts - segment.end_dts_us >= margin)
+                {
+                    av_packet_unref(packet);
+                    finished = true;
+                    break;
+                }
+                inside = ts >= segment.start_dts_us && ts < segment.end_dts_us;
+            }
+            // 没有时间戳的包跟着前一个包归属
+            if (!inside)
+            {
+                av_packet_unref(packet);
+                continue;
+            }
+
+            segment.packets++;
+            segment.bytes += packet->size;
+            if (packet->flags & AV_PKT_FLAG_CORRUPT)
+            {
+                segment.corrupt_packets++;
+            }
+            if (ts != AV_NOPTS_VALUE)
+            {
+                int type = static_cast<int>(stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ? MediaType::VIDEO : MediaType::AUDIO);
+                if (segment.first_dts_us[type] == AV_NOPTS_VALUE)
+                {
+                    segment.first_dts_us[type] = ts;
+                }
+                else if (ts <= segment.last_dts_us[type])
+                {
+                    segment.dts_errors++;
+                }
+                segment.last_dts_us[type] = ts;
+
+                int64_t bucket = std::max<int64_t>(0, ts - start_time) / bucket_us;
+                if (segment.bucket_bytes.empty())
+                {
+                    segment.first_bucket = bucket;
+                }
+                else if (bucket < segment.first_bucket)
+                {
+                    // 交错存放的其他流可能比已经读到的包更早
+                    segment.bucket_bytes.insert(segment.bucket_bytes.begin(), segment.first_bucket - bucket, 0);
+                    segment.first_bucket = bucket;
+                }
+                size_t offset = static_cast<size_t>(bucket - segment.first_bucket);
+                if (offset >= segment.bucket_bytes.size())
+                {
+                    segment.bucket_bytes.resize(offset + 1, 0);
+                }
+                segment.bucket_bytes[offset] += packet->size;
+            }
+            if (packet->stream_index == primary && (packet->flags & AV_PKT_FLAG_KEY))
+            {
+                KeyframeEntry entry;
+                entry.pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                entry.dts = packet->dts;
+                entry.pos = packet->pos;
+                entry.size = packet->size;
+                entry.flags = 0;
+                segment.keyframes.push_back(entry);
+            }
+            if (visitor_)
+            {
+                visitor_(index, packet);
+            }
+            av_packet_unref(packet);
+        }
+        segment.complete = finished || demuxer.isEOF();
+        if (!segment.complete)
+        {
+            LOG_ERROR << "Read error while scanning segment " << index << ".";
+        }
+        segment.elapsed_us = elapsedMicroseconds(segment_start);
+    }
+    av_packet_free(&packet);
+}
+
+// 分段在解码时间上互不重叠，按顺序拼接关键帧，码率区间直接相加
+// 同一个流在前一段最后的时间戳和后一段最初的时间戳之间也要递增
+void SegmentScanner::merge(const std::vector<ScanSegmentResult> &segments, ScanResult &result) const
+{
+    int64_t previous_last[MEDIA_TYPE_COUNT];
+    for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+    {
+        previous_last[i] = AV_NOPTS_VALUE;
+    }
+    for (const ScanSegmentResult &segment : segments)
+    {
+        result.packets += segment.packets;
+        result.bytes += segment.bytes;
+        result.corrupt_packets += segment.corrupt_packets;
+        result.dts_errors += segment.dts_errors;
+        if (segment.stream_index >= 0)
+        {
+            result.stream_index = segment.stream_index;
+        }
+        result.keyframes.insert(result.keyframes.end(), segment.keyframes.begin(), segment.keyframes.end());
+        for (int i = 0; i < MEDIA_TYPE_COUNT; i++)
+        {
+            if (segment.first_dts_us[i] == AV_NOPTS_VALUE)
+            {
+                continue;
+            }
+            if (previous_last[i] != AV_NOPTS_VALUE && segment.first_dts_us[i] <= previous_last[i])
+            {
+                result.dts_errors++;
+            }
+            previous_last[i] = segment.last_dts_us[i];
+        }
+        if (!segment.bucket_bytes.empty())
+        {
+            size_t end = static_cast<size_t>(segment.first_bucket) + segment.bucket_bytes.size();
+            if (result.bitrate_bytes.size() < end)
+            {
+                result.bitrate_bytes.resize(end, 0);
+            }
+            for (size_t i = 0; i < segment.bucket_bytes.size(); i++)
+            {
+                result.bitrate_bytes[segment.first_bucket + i] += segment.bucket_bytes[i];
+            }
+        }
+    }
+}
+
+bool SegmentScanner::shouldParallelize(const std::string &filename) const
+{
+    if (options_.mode != ScanMode::AUTO)
+    {
+        return options_.mode == ScanMode::PARALLEL;
+    }
+    // 网络流多开连接未必更快，按顺序读
+    std::string path;
+    if (!MmapIO::isLocalPath(filename, path))
+    {
+        return false;
+    }
+    bool rotational = false;
+    if (isRotationalStorage(path, rotational) && rotational)
+    {
+        LOG_INFO << filename << " is on a rotational disk, scanning sequentially.";
+        return false;
+    }
+    return true;
+}
+
+// 通过/sys/dev/block/<major>:<minor>找到文件所在的块设备，分区的queue目录在上一级的整盘设备中
+// tmpfs、overlayfs这类没有块设备的文件系统无法判断
+bool SegmentScanner::isRotationalStorage(const std::string &path, bool &rotational)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+    std::string device = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    char resolved[PATH_MAX];
+    if (!realpath(device.c_str(), resolved))
+    {
+        return false;
+    }
+    const std::string candidates[] = {std::string(resolved) + "/queue/rotational",
+                                      std::string(resolved) + "/../queue/rotational"};
+    for (const std::string &candidate : candidates)
+    {
+        std::ifstream file(candidate);
+        int value;
+        if (file >> value)
+        {
+            rotational = value != 0;
+            return true;
+        }
+    }
+    return false;
+}
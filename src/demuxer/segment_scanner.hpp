@@ -0,0 +1,107 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "mediadefs.hpp"
+#include "seek_index.hpp"
+
+// 扫描方式
+enum class ScanMode
+{
+    AUTO,       // 本地文件且不在机械硬盘上时并行，否则顺序扫描
+    PARALLEL,   // 总是分段并行
+    SEQUENTIAL  // 一个线程从头读到尾
+};
+
+// 分段扫描的选项
+struct ScanOptions
+{
+    ScanMode mode = ScanMode::AUTO;
+    int threads = 0;                             // 工作线程数，0表示使用硬件线程数
+    int segments_per_thread = 4;                 // 每个线程平均分到的分段数，分段多一些可以平衡各段耗时的差异
+    int64_t interleave_margin_us = 2000000;      // 交错存放的流之间的最大时间差（微秒），每段多读这么长以免漏掉靠后存放的包
+    int64_t bitrate_bucket_us = 1000000;         // 码率曲线每个点覆盖的时长（微秒）
+    bool fast_open = true;                       // 工作线程的Demuxer是否快速打开
+};
+
+// 收到每个包时的回调，在工作线程中调用；segment是包所属的分段序号，同一分段的包按文件顺序送达
+// 不同分段的回调会同时发生，回调按segment分开保存状态就不需要加锁，最后按分段顺序合并
+using ScanVisitor = std::function<void(int segment, const AVPacket *packet)>;
+
+// 一个分段的扫描结果，分段按解码时间戳划分：[start_dts_us, end_dts_us)
+struct ScanSegmentResult
+{
+    int64_t start_dts_us = INT64_MIN;
+    int64_t end_dts_us = INT64_MAX;
+    int64_t packets = 0;
+    int64_t bytes = 0;
+    int64_t corrupt_packets = 0;                   // 带AV_PKT_FLAG_CORRUPT的包
+    int64_t dts_errors = 0;                        // 同一个流中解码时间戳没有递增的次数
+    int64_t first_dts_us[MEDIA_TYPE_COUNT];        // 各类型第一个包的解码时间戳，用于检查分段交界处
+    int64_t last_dts_us[MEDIA_TYPE_COUNT];         // 各类型最后一个包的解码时间戳
+    std::vector<KeyframeEntry> keyframes;          // 主流的关键帧，时间戳使用该流的时间基
+    std::vector<int64_t> bucket_bytes;             // 从first_bucket开始每个码率区间的字节数
+    int64_t first_bucket = 0;
+    int stream_index = -1;                         // 关键帧所属的主流
+    bool complete = false;                         // 是否读到了分段的终点或文件末尾
+    int64_t elapsed_us = 0;                        // 扫描这一段的耗时
+
+    ScanSegmentResult();
+};
+
+// 整个文件的扫描结果
+struct ScanResult
+{
+    bool parallel = false;
+    int threads = 0;
+    int segments = 0;
+    int64_t packets = 0;
+    int64_t bytes = 0;
+    int64_t corrupt_packets = 0;
+    int64_t dts_errors = 0;                // 包括分段交界处的检查
+    int stream_index = -1;                 // 关键帧所属的主流（有视频时为视频流）
+    std::vector<KeyframeEntry> keyframes;  // 主流的全部关键帧，按时间顺序排列，可以直接填入SeekIndex
+    std::vector<int64_t> bitrate_bytes;    // 每bitrate_bucket_us时长内所有流的字节数，从文件起始时间算起
+    int64_t total_us = 0;                  // 总耗时（微秒），包括划分分段
+    int64_t partition_us = 0;              // 定位关键帧、划分分段的耗时（微秒）
+};
+
+// 把一个文件按关键帧对齐的解码时间范围切成多段，在多个线程中各用自己的Demuxer读取，最后按分段顺序合并结果
+// 用于建立关键帧索引、码率曲线、完整性检查这类需要读遍整个文件的分析
+// 并行读取只对快速存储有好处，机械硬盘上多个读取位置会互相打断寻道，AUTO模式下自动退回顺序扫描
+class SegmentScanner
+{
+public:
+    explicit SegmentScanner(const ScanOptions &options = ScanOptions());
+
+    // 设置每个包的回调，需要在scan()之前设置
+    void setVisitor(ScanVisitor visitor) { visitor_ = std::move(visitor); }
+    // 扫描filename中的视频和音频流，文件打不开返回false
+    // segments返回各分段的结果，可以为nullptr
+    bool scan(const std::string &filename, ScanResult &result, std::vector<ScanSegmentResult> *segments = nullptr);
+
+    // 判断文件是否在机械硬盘上，无法判断时返回false并且不修改rotational
+    static bool isRotationalStorage(const std::string &path, bool &rotational);
+
+private:
+    // 按时长等分后对齐到关键帧，返回各分段起点的解码时间戳（微秒），第一段从文件开头读起
+    std::vector<int64_t> partition(const std::string &filename, int segment_count);
+    // 工作线程：依次领取分段并扫描
+    void runWorker(const std::string &filename, std::vector<ScanSegmentResult> &segments);
+    // 把分段的结果按顺序合并
+    void merge(const std::vector<ScanSegmentResult> &segments, ScanResult &result) const;
+    // 是否并行扫描
+    bool shouldParallelize(const std::string &filename) const;
+
+    ScanOptions options_;
+    ScanVisitor visitor_;
+    std::atomic<int> next_segment_{0}; // 下一个待领取的分段
+};
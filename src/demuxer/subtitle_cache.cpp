@@ -0,0 +1,262 @@
+#include "subtitle_cache.hpp"
+#include "demuxer.hpp"
+
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 时间戳换算成微秒，没有pts时用dts
+    int64_t packetStartUs(const AVPacket *packet, const AVStream *stream)
+    {
+        int64_t ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+        if (ts == AV_NOPTS_VALUE)
+        {
+            return AV_NOPTS_VALUE;
+        }
+        return av_rescale_q(ts, stream->time_base, AV_TIME_BASE_Q);
+    }
+}
+
+bool SubtitleCache::isTextCodec(AVCodecID codec_id)
+{
+    const AVCodecDescriptor *descriptor = avcodec_descriptor_get(codec_id);
+    return descriptor && descriptor->type == AVMEDIA_TYPE_SUBTITLE && (descriptor->props & AV_CODEC_PROP_TEXT_SUB);
+}
+
+// 大部分文本字幕的包就是文本本身，mov_text和ASS需要去掉前面的长度和字段
+std::string SubtitleCache::extractText(AVCodecID codec_id, const AVPacket *packet)
+{
+    if (!packet->data || packet->size <= 0)
+    {
+        return std::string();
+    }
+    const char *data = reinterpret_cast<const char *>(packet->data);
+    size_t size = static_cast<size_t>(packet->size);
+    if (codec_id == AV_CODEC_ID_MOV_TEXT)
+    {
+        // 前两个字节是大端的文本长度，后面可能跟着样式盒子
+        if (size < 2)
+        {
+            return std::string();
+        }
+        size_t length = (static_cast<size_t>(packet->data[0]) << 8) | packet->data[1];
+        data += 2;
+        size = std::min(length, size - 2);
+    }
+    else if (codec_id == AV_CODEC_ID_ASS)
+    {
+        // ReadOrder, Layer, Style, Name, MarginL, MarginR, MarginV, Effect, Text
+        int commas = 0;
+        size_t i = 0;
+        while (i < size && commas < 8)
+        {
+            if (data[i++] == ',')
+            {
+                commas++;
+            }
+        }
+        data += i;
+        size -= i;
+    }
+    // 去掉结尾的空字符和换行
+    while (size > 0 && (data[size - 1] == '\0' || data[size - 1] == '\n' || data[size - 1] == '\r'))
+    {
+        size--;
+    }
+    return std::string(data, size);
+}
+
+bool SubtitleCache::load(const std::string &filename, int stream_index)
+{
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    Demuxer demuxer(MediaType::SUBTITLE);
+    if (!demuxer.open(filename))
+    {
+        return false;
+    }
+    if (stream_index >= 0 && !demuxer.selectTrack(MediaType::SUBTITLE, stream_index))
+    {
+        return false;
+    }
+    AVStream *stream = demuxer.getAVStream();
+    if (!stream)
+    {
+        LOG_ERROR << "No subtitle stream in " << filename << ".";
+        return false;
+    }
+    AVCodecID codec_id = stream->codecpar->codec_id;
+    codec_name_ = avcodec_get_name(codec_id);
+    if (!isTextCodec(codec_id))
+    {
+        LOG_ERROR << "Subtitle codec " << codec_name_ << " is not a text format.";
+        return false;
+    }
+
+    PacketPtr packet = makePacket();
+    if (!packet)
+    {
+        LOG_ERROR << "Failed to allocate packet.";
+        return false;
+    }
+    while (demuxer.readPacket(packet.get()))
+    {
+        SubtitleCue cue;
+        cue.start_us = packetStartUs(packet.get(), stream);
+        if (cue.start_us == AV_NOPTS_VALUE)
+        {
+            continue;
+        }
+        cue.end_us = packet->duration > 0 ? cue.start_us + av_rescale_q(packet->duration, stream->time_base, AV_TIME_BASE_Q)
+                                          : AV_NOPTS_VALUE;
+        cue.text = extractText(codec_id, packet.get());
+        // mov_text和WebVTT用空包表示清屏
+        if (cue.text.empty())
+        {
+            continue;
+        }
+        cues_.push_back(std::move(cue));
+    }
+    if (demuxer.getLastStatus() != DemuxStatus::END_OF_FILE)
+    {
+        LOG_ERROR << "Failed to read subtitles from " << filename << ".";
+        clear();
+        return false;
+    }
+
+    // 容器中字幕包基本是有序的，稳定排序保持同一时刻字幕的原始顺序
+    std::stable_sort(cues_.begin(), cues_.end(),
+                     [](const SubtitleCue &a, const SubtitleCue &b) { return a.start_us < b.start_us; });
+    // 没有时长的字幕显示到下一条开始，最后一条一直显示
+    for (size_t i = 0; i < cues_.size(); i++)
+    {
+        if (cues_[i].end_us == AV_NOPTS_VALUE)
+        {
+            cues_[i].end_us = i + 1 < cues_.size() ? cues_[i + 1].start_us : INT64_MAX;
+        }
+    }
+    // 时长为0的字幕不会显示，不放进区间树
+    std::vector<size_t> indices;
+    indices.reserve(cues_.size());
+    for (size_t i = 0; i < cues_.size(); i++)
+    {
+        if (cues_[i].end_us > cues_[i].start_us)
+        {
+            indices.push_back(i);
+        }
+    }
+    root_ = buildTree(indices);
+    load_us_ = elapsedMicroseconds(start);
+    LOG_INFO << "Loaded " << cues_.size() << " " << codec_name_ << " subtitles from " << filename << " in " << load_us_ << "us.";
+    return true;
+}
+
+void SubtitleCache::clear()
+{
+    cues_.clear();
+    nodes_.clear();
+    by_start_.clear();
+    by_end_.clear();
+    root_ = -1;
+    codec_name_.clear();
+    load_us_ = 0;
+}
+
+// center取所有端点的下中位数，比它大的端点不超过一半，右子树最多有一半的字幕
+// 左子树的字幕两个端点都不超过center，它们不可能是全部：那样center只能是某条字幕的开始，而这条字幕在center之后结束
+int SubtitleCache::buildTree(const std::vector<size_t> &indices)
+{
+    if (indices.empty())
+    {
+        return -1;
+    }
+    std::vector<int64_t> endpoints;
+    endpoints.reserve(indices.size() * 2);
+    for (size_t i : indices)
+    {
+        endpoints.push_back(cues_[i].start_us);
+        endpoints.push_back(cues_[i].end_us);
+    }
+    auto median = endpoints.begin() + (endpoints.size() - 1) / 2;
+    std::nth_element(endpoints.begin(), median, endpoints.end());
+    int64_t center = *median;
+
+    // 按原来的顺序分组，每组仍然按开始时间升序
+    std::vector<size_t> left;
+    std::vector<size_t> right;
+    std::vector<size_t> overlapping;
+    for (size_t i : indices)
+    {
+        if (cues_[i].end_us <= center)
+        {
+            left.push_back(i);
+        }
+        else if (cues_[i].start_us > center)
+        {
+            right.push_back(i);
+        }
+        else
+        {
+            overlapping.push_back(i);
+        }
+    }
+
+    IntervalNode node;
+    node.center = center;
+    node.begin = by_start_.size();
+    node.end = node.begin + overlapping.size();
+    by_start_.insert(by_start_.end(), overlapping.begin(), overlapping.end());
+    std::stable_sort(overlapping.begin(), overlapping.end(),
+                     [this](size_t a, size_t b) { return cues_[a].end_us > cues_[b].end_us; });
+    by_end_.insert(by_end_.end(), overlapping.begin(), overlapping.end());
+    int index = static_cast<int>(nodes_.size());
+    nodes_.push_back(node);
+    // 建子树时nodes_会扩容，先建好再写回
+    int left_child = buildTree(left);
+    int right_child = buildTree(right);
+    nodes_[index].left = left_child;
+    nodes_[index].right = right_child;
+    return index;
+}
+
+size_t SubtitleCache::find(int64_t timestamp_us, std::vector<const SubtitleCue *> &cues) const
+{
+    cues.clear();
+    std::vector<size_t> active;
+    visitActive(timestamp_us, [&active](size_t i) { active.push_back(i); });
+    // 编号的顺序就是开始时间的顺序，同时开始的字幕保持原始顺序
+    std::sort(active.begin(), active.end());
+    for (size_t i : active)
+    {
+        cues.push_back(&cues_[i]);
+    }
+    return cues.size();
+}
+
+const SubtitleCue *SubtitleCache::at(int64_t timestamp_us) const
+{
+    // 编号最大的就是最晚开始的
+    size_t latest = cues_.size();
+    visitActive(timestamp_us, [&latest, this](size_t i) {
+        if (latest == cues_.size() || i > latest)
+        {
+            latest = i;
+        }
+    });
+    return latest < cues_.size() ? &cues_[latest] : nullptr;
+}
+
+const SubtitleCue *SubtitleCache::next(int64_t timestamp_us) const
+{
+    auto it = std::upper_bound(cues_.begin(), cues_.end(), timestamp_us,
+                               [](int64_t ts, const SubtitleCue &cue) { return ts < cue.start_us; });
+    return it != cues_.end() ? &*it : nullptr;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 一条字幕，时间为微秒，[start_us, end_us)期间显示
+struct SubtitleCue
+{
+    int64_t start_us = 0;
+    int64_t end_us = 0;
+    std::string text; // 字幕文本，ASS字幕只保留Text字段，样式标签原样保留
+};
+
+// 文本字幕的预加载缓存
+// load()一次读完整条字幕流（内嵌在容器中的字幕轨道，或者单独的srt、ass、vtt文件），按开始时间排好序，
+// 播放时按时间查找只需要查区间树，不用再访问文件；图形字幕（PGS、DVB等）不支持
+class SubtitleCache
+{
+public:
+    // 读取filename中编号为stream_index的字幕流，-1表示默认的字幕流；之前加载的内容会被替换
+    bool load(const std::string &filename, int stream_index = -1);
+    void clear();
+
+    // 把timestamp_us时刻应该显示的字幕按开始时间顺序放进cues，返回条数
+    // 在区间树中查找，只检查O(log n)个节点和真正覆盖这一时刻的字幕，有持续很久的字幕时也不会退化成线性扫描
+    size_t find(int64_t timestamp_us, std::vector<const SubtitleCue *> &cues) const;
+    // timestamp_us时刻显示的字幕中最晚开始的一条，没有时返回nullptr
+    const SubtitleCue *at(int64_t timestamp_us) const;
+    // timestamp_us之后第一条开始的字幕，没有时返回nullptr，用于计算下一次需要刷新字幕的时间
+    const SubtitleCue *next(int64_t timestamp_us) const;
+
+    const std::vector<SubtitleCue> &getCues() const { return cues_; }
+    size_t size() const { return cues_.size(); }
+    bool empty() const { return cues_.empty(); }
+    // 最近一次load()的耗时（微秒）
+    int64_t getLoadTimeUs() const { return load_us_; }
+    // 字幕流的编解码器名称
+    const std::string &getCodecName() const { return codec_name_; }
+
+    // 是否为文本字幕
+    static bool isTextCodec(AVCodecID codec_id);
+    // 从包中取出字幕文本
+    static std::string extractText(AVCodecID codec_id, const AVPacket *packet);
+
+private:
+    // 中心区间树的一个节点：覆盖center的字幕放在这个节点，完全在center之前和之后的字幕分别放在左右子树
+    struct IntervalNode
+    {
+        int64_t center = 0;
+        int left = -1;  // 子节点在nodes_中的下标，-1表示没有
+        int right = -1;
+        size_t begin = 0; // 这个节点的字幕在by_start_和by_end_中的范围
+        size_t end = 0;
+    };
+
+    // 用cues_中编号为indices（升序）的字幕建立子树，返回节点下标
+    int buildTree(const std::vector<size_t> &indices);
+    // 对timestamp_us时刻显示的每一条字幕调用visit(在cues_中的编号)，顺序不固定
+    template <typename Visit>
+    void visitActive(int64_t timestamp_us, Visit visit) const
+    {
+        int node = root_;
+        while (node >= 0)
+        {
+            const IntervalNode &n = nodes_[node];
+            if (timestamp_us < n.center)
+            {
+                // 节点中的字幕都在center之后结束，开始不晚于timestamp_us的就覆盖这一时刻
+                for (size_t i = n.begin; i < n.end && cues_[by_start_[i]].start_us <= timestamp_us; i++)
+                {
+                    visit(by_start_[i]);
+                }
+                node = n.left;
+            }
+            else
+            {
+                // 节点中的字幕都在center之前开始，结束晚于timestamp_us的就覆盖这一时刻
+                for (size_t i = n.begin; i < n.end && cues_[by_end_[i]].end_us > timestamp_us; i++)
+                {
+                    visit(by_end_[i]);
+                }
+                node = n.right;
+            }
+        }
+    }
+
+    std::vector<SubtitleCue> cues_; // 按开始时间排列
+    std::vector<IntervalNode> nodes_;
+    std::vector<size_t> by_start_; // 每个节点的字幕按开始时间升序排列
+    std::vector<size_t> by_end_;   // 每个节点的字幕按结束时间降序排列
+    int root_ = -1;
+    int64_t load_us_ = 0;
+    std::string codec_name_;
+};
@@ -0,0 +1,257 @@
+#include "thumbnail_engine.hpp"
+#include "demuxer.hpp"
+
+#include "utils/logger.hpp"
+
+extern "C"
+{
+#include <libswscale/swscale.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace
+{
+    int64_t elapsedMicroseconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+ThumbnailEngine::ThumbnailEngine(const ThumbnailOptions &options)
+    : options_(options)
+{
+}
+
+bool ThumbnailEngine::generate(const std::string &filename, SpriteSheet &sheet)
+{
+    last_stats_ = ThumbnailStats();
+    auto start = std::chrono::steady_clock::now();
+    if (options_.count <= 0 || options_.thumb_width <= 0 || options_.columns <= 0)
+    {
+        LOG_ERROR << "Invalid thumbnail options.";
+        return false;
+    }
+
+    // 先打开一次取得时长和画面尺寸，这个Demuxer之后交给第一个工作线程继续使用
+    OpenOptions open_options;
+    open_options.fast_open = options_.fast_open;
+    auto probe = std::make_unique<Demuxer>(MediaType::VIDEO);
+    probe->setOpenOptions(open_options);
+    auto open_start = std::chrono::steady_clock::now();
+    if (!probe->open(filename))
+    {
+        return false;
+    }
+    int64_t probe_open_us = elapsedMicroseconds(open_start);
+    AVStream *stream = probe->getAVStream();
+    int64_t duration = probe->getDuration();
+    if (!stream || stream->codecpar->width <= 0 || stream->codecpar->height <= 0 || duration <= 0)
+    {
+        LOG_ERROR << "No video stream with known size and duration in " << filename << ".";
+        return false;
+    }
+
+    // 按显示宽高比计算缩略图高度，取偶数
+    int thumb_height = options_.thumb_height;
+    if (thumb_height <= 0)
+    {
+        AVRational sar = stream->codecpar->sample_aspect_ratio;
+        double display_width = stream->codecpar->width * (sar.num > 0 && sar.den > 0 ? av_q2d(sar) : 1.0);
+        thumb_height = static_cast<int>(options_.thumb_width * stream->codecpar->height / display_width + 0.5) & ~1;
+        thumb_height = std::max(thumb_height, 2);
+    }
+    sheet.thumb_width = options_.thumb_width;
+    sheet.thumb_height = thumb_height;
+    sheet.columns = std::min(options_.columns, options_.count);
+    sheet.rows = (options_.count + sheet.columns - 1) / sheet.columns;
+    sheet.stride = sheet.columns * sheet.thumb_width * 4;
+    sheet.pixels.assign(static_cast<size_t>(sheet.rows) * sheet.thumb_height * sheet.stride, 0);
+    sheet.timestamps.assign(options_.count, AV_NOPTS_VALUE);
+
+    int threads = options_.threads > 0 ? options_.threads : static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(1, std::min(threads, options_.count));
+    last_stats_.threads = threads;
+
+    // 每个线程负责一段连续的序号，段内的定位都是向前的
+    std::vector<WorkerResult> results(threads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        int first = static_cast<int>(static_cast<int64_t>(options_.count) * i / threads);
+        int last = static_cast<int>(static_cast<int64_t>(options_.count) * (i + 1) / threads);
+        std::shared_ptr<Demuxer> demuxer;
+        if (i == 0)
+        {
+            demuxer = std::move(probe);
+            results[0].open_us = probe_open_us;
+        }
+        workers.emplace_back([this, &filename, duration, first, last, &sheet, &results, i, demuxer]() mutable
+                             { runWorker(filename, std::move(demuxer), duration, first, last, sheet, results[i]); });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (const WorkerResult &result : results)
+    {
+        last_stats_.extracted += result.extracted;
+        last_stats_.reused += result.reused;
+        last_stats_.failed += result.failed;
+        last_stats_.lowres = std::max(last_stats_.lowres, result.lowres);
+        last_stats_.open_us = std::max(last_stats_.open_us, result.open_us);
+    }
+    last_stats_.total_us = elapsedMicroseconds(start);
+    LOG_INFO << "Extracted " << options_.count << " thumbnails with " << threads << " threads in "
+             << last_stats_.total_us << "us (" << last_stats_.reused << " reused, " << last_stats_.failed << " failed).";
+    return true;
+}
+
+void ThumbnailEngine::runWorker(const std::string &filename, std::shared_ptr<Demuxer> demuxer, int64_t duration, int first, int last,
+                                SpriteSheet &sheet, WorkerResult &result) const
+{
+    if (!demuxer)
+    {
+        OpenOptions open_options;
+        open_options.fast_open = options_.fast_open;
+        demuxer = std::make_shared<Demuxer>(MediaType::VIDEO);
+        demuxer->setOpenOptions(open_options);
+        auto open_start = std::chrono::steady_clock::now();
+        if (!demuxer->open(filename))
+        {
+            result.failed += last - first;
+            return;
+        }
+        result.open_us = elapsedMicroseconds(open_start);
+    }
+    AVStream *stream = demuxer->getAVStream();
+    const AVCodec *codec = avcodec_find_decoder(stream->codecpar->codec_id);
+    AVCodecContext *codec_ctx = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!codec_ctx || avcodec_parameters_to_context(codec_ctx, stream->codecpar) < 0)
+    {
+        LOG_ERROR << "Failed to create decoder for thumbnails.";
+        avcodec_free_context(&codec_ctx);
+        result.failed += last - first;
+        return;
+    }
+    // 并行度来自多个工作线程，每个解码器只用一个线程
+    // 只解码互相独立的关键帧，跳过环路滤波不会把误差传给其他帧，缩略图上也看不出来
+    codec_ctx->thread_count = 1;
+    codec_ctx->pkt_timebase = stream->time_base;
+    codec_ctx->skip_loop_filter = AVDISCARD_ALL;
+    codec_ctx->flags2 |= AV_CODEC_FLAG2_FAST;
+    codec_ctx->lowres = chooseLowres(codec, stream->codecpar, sheet.thumb_width, sheet.thumb_height);
+    if (avcodec_open2(codec_ctx, codec, nullptr) < 0)
+    {
+        LOG_ERROR << "Failed to open decoder for thumbnails.";
+        avcodec_free_context(&codec_ctx);
+        result.failed += last - first;
+        return;
+    }
+    result.lowres = codec_ctx->lowres;
+
+    AVFormatContext *format_ctx = demuxer->getFormatContext();
+    int64_t start_time = format_ctx->start_time != AV_NOPTS_VALUE ? format_ctx->start_time : 0;
+    AVPacket *packet = av_packet_alloc();
+    AVFrame *frame = av_frame_alloc();
+    SwsContext *sws_ctx = nullptr;
+    int64_t previous_keyframe = AV_NOPTS_VALUE;
+    int previous_index = -1;
+    for (int index = first; index < last; index++)
+    {
+        // 每张缩略图取所在时间段的中点
+        int64_t target = start_time + duration * (2 * index + 1) / (2 * static_cast<int64_t>(sheet.timestamps.size()));
+        if (!demuxer->seek(target, AVSEEK_FLAG_BACKWARD))
+        {
+            result.failed++;
+            continue;
+        }
+        // 定位之后的第一个关键帧就是目标之前最近的关键帧
+        bool found = false;
+        while (demuxer->readPacket(packet))
+        {
+            if (packet->flags & AV_PKT_FLAG_KEY)
+            {
+                found = true;
+                break;
+            }
+            av_packet_unref(packet);
+        }
+        if (!found)
+        {
+            result.failed++;
+            continue;
+        }
+        int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+        int64_t keyframe = pts != AV_NOPTS_VALUE ? av_rescale_q(pts, stream->time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE;
+        // GOP比缩略图间隔长时，相邻几张会落在同一个关键帧上，直接复制上一张
+        if (keyframe != AV_NOPTS_VALUE && keyframe == previous_keyframe && previous_index >= 0)
+        {
+            av_packet_unref(packet);
+            for (int y = 0; y < sheet.thumb_height; y++)
+            {
+                std::memcpy(sheet.cell(index) + static_cast<size_t>(y) * sheet.stride,
+                            sheet.cell(previous_index) + static_cast<size_t>(y) * sheet.stride, sheet.thumb_width * 4);
+            }
+            sheet.timestamps[index] = keyframe;
+            result.reused++;
+            previous_index = index;
+            continue;
+        }
+
+        // 只送入这一个关键帧，然后取空解码器，不往后解码
+        avcodec_flush_buffers(codec_ctx);
+        int ret = avcodec_send_packet(codec_ctx, packet);
+        av_packet_unref(packet);
+        if (ret >= 0)
+        {
+            avcodec_send_packet(codec_ctx, nullptr);
+            ret = avcodec_receive_frame(codec_ctx, frame);
+        }
+        if (ret < 0)
+        {
+            result.failed++;
+            continue;
+        }
+        sws_ctx = sws_getCachedContext(sws_ctx, frame->width, frame->height, static_cast<AVPixelFormat>(frame->format),
+                                       sheet.thumb_width, sheet.thumb_height, AV_PIX_FMT_RGBA, SWS_AREA,
+                                       nullptr, nullptr, nullptr);
+        if (!sws_ctx)
+        {
+            av_frame_unref(frame);
+            result.failed++;
+            continue;
+        }
+        // 直接缩放到拼图中的位置，不经过中间缓冲区
+        uint8_t *dst[4] = {sheet.cell(index), nullptr, nullptr, nullptr};
+        int dst_stride[4] = {sheet.stride, 0, 0, 0};
+        sws_scale(sws_ctx, frame->data, frame->linesize, 0, frame->height, dst, dst_stride);
+        av_frame_unref(frame);
+        sheet.timestamps[index] = keyframe;
+        result.extracted++;
+        previous_keyframe = keyframe;
+        previous_index = index;
+    }
+
+    sws_freeContext(sws_ctx);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codec_ctx);
+}
+
+// 解码器支持缩小解码时（例如MJPEG），选择最大的、解码结果仍然不小于缩略图的级别
+int ThumbnailEngine::chooseLowres(const AVCodec *codec, const AVCodecParameters *par, int thumb_width, int thumb_height)
+{
+    int lowres = 0;
+    while (lowres < codec->max_lowres && (par->width >> (lowres + 1)) >= thumb_width &&
+           (par->height >> (lowres + 1)) >= thumb_height)
+    {
+        lowres++;
+    }
+    return lowres;
+}
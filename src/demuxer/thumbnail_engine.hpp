@@ -0,0 +1,92 @@
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Demuxer;
+
+// 缩略图提取的选项
+struct ThumbnailOptions
+{
+    int count = 100;         // 缩略图数量，在时长上均匀分布
+    int thumb_width = 160;   // 每张缩略图的宽度
+    int thumb_height = 0;    // 每张缩略图的高度，0表示按视频的宽高比计算
+    int columns = 10;        // 拼图每行的缩略图数
+    int threads = 0;         // 工作线程数，0表示使用硬件线程数
+    bool fast_open = true;   // 工作线程的Demuxer是否快速打开
+};
+
+// 预先分配的拼图（sprite sheet），RGBA格式，缩略图按时间顺序从左到右、从上到下排列
+struct SpriteSheet
+{
+    int thumb_width = 0;
+    int thumb_height = 0;
+    int columns = 0;
+    int rows = 0;
+    int stride = 0;                  // 每行像素的字节数
+    std::vector<uint8_t> pixels;     // rows * thumb_height行，每行stride字节
+    std::vector<int64_t> timestamps; // 每张缩略图实际使用的关键帧时间戳（微秒），提取失败为AV_NOPTS_VALUE
+
+    // 第index张缩略图左上角像素的地址
+    uint8_t *cell(int index)
+    {
+        return pixels.data() + static_cast<size_t>(index / columns) * thumb_height * stride +
+               static_cast<size_t>(index % columns) * thumb_width * 4;
+    }
+};
+
+// 一次提取的统计
+struct ThumbnailStats
+{
+    int threads = 0;          // 实际使用的工作线程数
+    int extracted = 0;        // 解码得到的缩略图数
+    int reused = 0;           // 与上一张落在同一个关键帧上、直接复制的缩略图数
+    int failed = 0;           // 提取失败的缩略图数
+    int lowres = 0;           // 解码器的缩小解码级别（按2的幂缩小），解码器不支持时为0
+    int64_t open_us = 0;      // 工作线程打开文件的最长耗时（微秒）
+    int64_t total_us = 0;     // 总耗时（微秒）
+};
+
+// 并行的缩略图提取
+// 把时长按缩略图序号切成连续的几段，每个工作线程用自己的Demuxer和解码器处理一段，段内的定位都是向前的
+// 每张缩略图只解码目标之前最近的关键帧，不往后解码；解码器只输出关键帧，并尽量使用缩小解码
+// 缩略图直接缩放到拼图中对应的位置，各线程写入的区域互不重叠，不需要加锁
+class ThumbnailEngine
+{
+public:
+    explicit ThumbnailEngine(const ThumbnailOptions &options = ThumbnailOptions());
+
+    // 提取filename的缩略图写入sheet，sheet会按选项重新分配
+    // 文件打不开或没有视频流时返回false；个别缩略图失败时返回true，对应位置保持黑色
+    bool generate(const std::string &filename, SpriteSheet &sheet);
+
+    const ThumbnailStats &getLastStats() const { return last_stats_; }
+
+private:
+    // 一个工作线程的结果
+    struct WorkerResult
+    {
+        int extracted = 0;
+        int reused = 0;
+        int failed = 0;
+        int lowres = 0;
+        int64_t open_us = 0;
+    };
+
+    // 工作线程：提取序号在[first, last)之间的缩略图，demuxer为空时自己打开文件
+    void runWorker(const std::string &filename, std::shared_ptr<Demuxer> demuxer, int64_t duration, int first, int last,
+                   SpriteSheet &sheet, WorkerResult &result) const;
+    // 选择缩小解码的级别，使解码出的图像仍然不小于缩略图
+    static int chooseLowres(const AVCodec *codec, const AVCodecParameters *par, int thumb_width, int thumb_height);
+
+    ThumbnailOptions options_;
+    ThumbnailStats last_stats_;
+};
@@ -0,0 +1,474 @@
+#include "uring_io.hpp"
+
+#include "utils/logger.hpp"
+
+extern "C"
+{
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// 只依赖内核头文件，通过系统调用直接使用io_uring，不需要liburing
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define FFGL_HAVE_IO_URING 1
+#endif
+#endif
+
+namespace
+{
+    // 交给AVIOContext的缓冲区大小
+    constexpr int AVIO_BUFFER_SIZE = 64 * 1024;
+    // 读缓冲区按页对齐
+    constexpr size_t BUFFER_ALIGNMENT = 4096;
+}
+
+#ifdef FFGL_HAVE_IO_URING
+// io_uring的提交队列、完成队列和提交项数组都映射在用户空间
+struct UringIO::Ring
+{
+    int fd = -1;
+    void *sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void *cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+    unsigned pending_submit = 0; // 已经写入提交队列、还没有通知内核的请求数
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED)
+        {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+        {
+            munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED)
+        {
+            munmap(sq_ptr, sq_size);
+        }
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    bool setup(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED)
+        {
+            return false;
+        }
+        cq_ptr = single_mmap ? sq_ptr : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED)
+        {
+            return false;
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        uint8_t *sq = static_cast<uint8_t *>(sq_ptr);
+        uint8_t *cq = static_cast<uint8_t *>(cq_ptr);
+        sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    // 把一个READV请求写入提交队列，真正提交在submit()中
+    bool queueRead(int file_fd, struct iovec *iov, int64_t offset, uint64_t user_data)
+    {
+        unsigned tail = *sq_tail;
+        if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) > *sq_mask)
+        {
+            return false; // 提交队列已满
+        }
+        unsigned index = tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = file_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(iov);
+        sqe->len = 1;
+        sqe->off = static_cast<uint64_t>(offset);
+        sqe->user_data = user_data;
+        sq_array[index] = index;
+        // 提交项写完之后才能移动尾指针
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        pending_submit++;
+        return true;
+    }
+
+    // 提交队列中的请求，min_complete大于0时同时等待完成事件
+    int enter(unsigned min_complete)
+    {
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do
+        {
+            ret = static_cast<int>(syscall(__NR_io_uring_enter, fd, pending_submit, min_complete, flags, nullptr, 0));
+        } while (ret < 0 && errno == EINTR);
+        if (ret >= 0)
+        {
+            pending_submit -= std::min<unsigned>(pending_submit, static_cast<unsigned>(ret));
+        }
+        return ret;
+    }
+};
+#else
+// 没有内核头文件时只有pread后端
+struct UringIO::Ring
+{
+};
+#endif
+
+UringIO::UringIO()
+    : fd_(-1), size_(0), pos_(0), block_size_(0), avio_ctx_(nullptr), bytes_read_(0), stall_count_(0)
+{
+}
+
+UringIO::~UringIO()
+{
+    close();
+}
+
+// 打开文件并创建AVIOContext
+bool UringIO::open(const std::string &path, int queue_depth, int block_size)
+{
+    close();
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close();
+        return false;
+    }
+    size_ = st.st_size;
+    // 块大小按页对齐，请求的偏移因此也是对齐的
+    block_size_ = std::max<int>(BUFFER_ALIGNMENT, block_size - block_size % static_cast<int>(BUFFER_ALIGNMENT));
+
+    if (!setupRing(std::max(1, queue_depth)))
+    {
+        LOG_WARN << "io_uring unavailable, falling back to pread for " << path;
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    unsigned char *buffer = static_cast<unsigned char *>(av_malloc(AVIO_BUFFER_SIZE));
+    if (!buffer)
+    {
+        close();
+        return false;
+    }
+    avio_ctx_ = avio_alloc_context(buffer, AVIO_BUFFER_SIZE, 0, this, &UringIO::readCallback, nullptr, &UringIO::seekCallback);
+    if (!avio_ctx_)
+    {
+        av_free(buffer);
+        close();
+        return false;
+    }
+    LOG_INFO << "Opened " << path << " with " << (isUring() ? "io_uring" : "pread") << " backend, queue depth "
+             << slots_.size() << ", block size " << block_size_;
+    return true;
+}
+
+// 创建io_uring并分配预读槽位
+bool UringIO::setupRing(int queue_depth)
+{
+#ifdef FFGL_HAVE_IO_URING
+    auto ring = std::make_unique<Ring>();
+    if (!ring->setup(static_cast<unsigned>(queue_depth)))
+    {
+        return false;
+    }
+    slots_.resize(queue_depth);
+    for (Slot &slot : slots_)
+    {
+        void *buffer = nullptr;
+        if (posix_memalign(&buffer, BUFFER_ALIGNMENT, block_size_) != 0)
+        {
+            // 已经分配的缓冲区要先释放，还没分配的槽位buffer为nullptr
+            for (Slot &allocated : slots_)
+            {
+                std::free(allocated.buffer);
+            }
+            slots_.clear();
+            return false;
+        }
+        slot.buffer = static_cast<uint8_t *>(buffer);
+        slot.iov.iov_base = slot.buffer;
+        slot.iov.iov_len = block_size_;
+    }
+    ring_ = std::move(ring);
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 等待在途的请求结束后释放所有资源
+void UringIO::close()
+{
+    if (ring_)
+    {
+        // 内核还在往缓冲区里写，必须等请求全部完成
+        while (std::any_of(slots_.begin(), slots_.end(), [](const Slot &slot) { return slot.in_flight; }))
+        {
+            if (!reap(true))
+            {
+                break;
+            }
+        }
+        ring_.reset();
+    }
+    for (Slot &slot : slots_)
+    {
+        std::free(slot.buffer);
+    }
+    slots_.clear();
+    if (avio_ctx_)
+    {
+        av_freep(&avio_ctx_->buffer);
+        avio_context_free(&avio_ctx_);
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+    pos_ = 0;
+    bytes_read_ = 0;
+    stall_count_ = 0;
+}
+
+int UringIO::readCallback(void *opaque, uint8_t *buf, int buf_size)
+{
+    UringIO *io = static_cast<UringIO *>(opaque);
+    if (io->pos_ >= io->size_)
+    {
+        return AVERROR_EOF;
+    }
+    int ret = io->ring_ ? io->readFromRing(buf, buf_size) : io->readFromFile(buf, buf_size);
+    if (ret > 0)
+    {
+        io->pos_ += ret;
+        io->bytes_read_ += ret;
+    }
+    return ret;
+}
+
+// 跳转只修改位置，下一次读取时按新位置重新预读
+int64_t UringIO::seekCallback(void *opaque, int64_t offset, int whence)
+{
+    UringIO *io = static_cast<UringIO *>(opaque);
+    int64_t new_pos;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    case AVSEEK_SIZE:
+        return io->size_;
+    case SEEK_SET:
+        new_pos = offset;
+        break;
+    case SEEK_CUR:
+        new_pos = io->pos_ + offset;
+        break;
+    case SEEK_END:
+        new_pos = io->size_ + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (new_pos < 0 || new_pos > io->size_)
+    {
+        return AVERROR(EINVAL);
+    }
+    io->pos_ = new_pos;
+    return new_pos;
+}
+
+// 同步读取，也用于io_uring请求出错后的补救
+int UringIO::readFromFile(uint8_t *buf, int buf_size)
+{
+    ssize_t ret;
+    do
+    {
+        ret = pread(fd_, buf, buf_size, pos_);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+    {
+        return AVERROR(errno);
+    }
+    return ret == 0 ? AVERROR_EOF : static_cast<int>(ret);
+}
+
+// 从预读的块中拷贝数据，每次最多返回到当前块的末尾
+int UringIO::readFromRing(uint8_t *buf, int buf_size)
+{
+    int64_t block = pos_ / block_size_;
+    prefetch(block);
+    Slot *slot = findSlot(block);
+    if (slot && slot->in_flight)
+    {
+        // 预读没有跟上，只能等这个块读完
+        stall_count_++;
+        while (slot->in_flight)
+        {
+            if (!reap(true))
+            {
+                return readFromFile(buf, buf_size);
+            }
+        }
+    }
+    int64_t block_start = block * block_size_;
+    int offset = static_cast<int>(pos_ - block_start);
+    if (!slot || slot->result <= offset)
+    {
+        // 请求失败或者读得不完整，同步读取这一段
+        return readFromFile(buf, buf_size);
+    }
+    int size = std::min(buf_size, slot->result - offset);
+    std::memcpy(buf, slot->buffer + offset, size);
+    // 读完这个块之后槽位可以立即复用
+    if (offset + size >= slot->result)
+    {
+        slot->block = -1;
+        prefetch(block + 1);
+    }
+    return size;
+}
+
+// 为当前块和之后的块提交读请求，复用已经不在预读窗口内的槽位
+void UringIO::prefetch(int64_t first_block)
+{
+#ifdef FFGL_HAVE_IO_URING
+    reap(false);
+    int64_t last_block = (size_ - 1) / block_size_;
+    int64_t window_end = std::min<int64_t>(first_block + static_cast<int64_t>(slots_.size()) - 1, last_block);
+    for (int64_t block = first_block; block <= window_end; block++)
+    {
+        if (findSlot(block))
+        {
+            continue;
+        }
+        // 找一个空闲的、已完成且不在窗口内的槽位
+        auto it = std::find_if(slots_.begin(), slots_.end(), [&](const Slot &slot) {
+            return !slot.in_flight && (slot.block < first_block || slot.block > window_end);
+        });
+        if (it == slots_.end())
+        {
+            break; // 所有槽位都在使用，等下一次读取时再提交
+        }
+        it->block = block;
+        it->result = 0;
+        it->iov.iov_len = static_cast<size_t>(block_size_);
+        if (!ring_->queueRead(fd_, &it->iov, block * block_size_, static_cast<uint64_t>(it - slots_.begin())))
+        {
+            it->block = -1;
+            break;
+        }
+        it->in_flight = true;
+    }
+    if (ring_->pending_submit > 0 && ring_->enter(0) < 0)
+    {
+        LOG_WARN << "io_uring submit failed: " << std::strerror(errno);
+    }
+#else
+    (void)first_block;
+#endif
+}
+
+// 处理完成队列中的事件
+bool UringIO::reap(bool wait)
+{
+#ifdef FFGL_HAVE_IO_URING
+    unsigned head = *ring_->cq_head;
+    if (wait && head == __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE))
+    {
+        if (ring_->enter(1) < 0)
+        {
+            LOG_ERROR << "io_uring wait failed: " << std::strerror(errno);
+            return false;
+        }
+    }
+    unsigned tail = __atomic_load_n(ring_->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++)
+    {
+        const io_uring_cqe &cqe = ring_->cqes[head & *ring_->cq_mask];
+        if (cqe.user_data < slots_.size())
+        {
+            Slot &slot = slots_[cqe.user_data];
+            slot.in_flight = false;
+            slot.result = cqe.res;
+        }
+    }
+    __atomic_store_n(ring_->cq_head, head, __ATOMIC_RELEASE);
+    return true;
+#else
+    (void)wait;
+    return false;
+#endif
+}
+
+UringIO::Slot *UringIO::findSlot(int64_t block)
+{
+    for (Slot &slot : slots_)
+    {
+        if (slot.block == block)
+        {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+extern "C"
+{
+#include <libavformat/avio.h>
+}
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+// 基于io_uring的本地文件读取后端
+// 把文件按块对齐切分，在当前读取位置之前保持queue_depth个读请求在内核中执行，
+// av_read_frame需要数据时通常已经读好，不必在每次read()上等待磁盘延迟
+// 内核不支持io_uring（或者被seccomp禁止）时退回到同步的pread
+class UringIO
+{
+public:
+    UringIO();
+    ~UringIO();
+
+    UringIO(const UringIO &) = delete;
+    UringIO &operator=(const UringIO &) = delete;
+
+    // 打开文件并创建AVIOContext，queue_depth为同时在途的读请求数，block_size为每个请求的字节数
+    bool open(const std::string &path, int queue_depth = 8, int block_size = 256 * 1024);
+    void close();
+
+    // 交给AVFormatContext::pb使用，所有权仍属于UringIO
+    AVIOContext *getAVIOContext() const { return avio_ctx_; }
+    int64_t size() const { return size_; }
+    // 是否真的在使用io_uring，false表示退回了pread
+    bool isUring() const { return ring_ != nullptr; }
+    // 读取的总字节数，以及读取时需要等待请求完成的次数（预读没有跟上）
+    int64_t getBytesRead() const { return bytes_read_; }
+    int64_t getStallCount() const { return stall_count_; }
+
+private:
+    struct Ring; // io_uring的共享内存和文件描述符，定义在源文件中
+
+    // 预读的一个块
+    struct Slot
+    {
+        uint8_t *buffer = nullptr; // 按页对齐的缓冲区
+        int64_t block = -1;        // 缓冲区对应的块号，-1表示空闲
+        bool in_flight = false;    // 读请求是否还在内核中执行
+        int result = 0;            // 请求完成后读到的字节数或者负的错误码
+        struct iovec iov = {};     // 提交READV时使用，必须在请求完成前保持有效
+    };
+
+    // AVIOContext的回调
+    static int readCallback(void *opaque, uint8_t *buf, int buf_size);
+    static int64_t seekCallback(void *opaque, int64_t offset, int whence);
+
+    bool setupRing(int queue_depth);
+    int readFromRing(uint8_t *buf, int buf_size);
+    int readFromFile(uint8_t *buf, int buf_size);
+    // 为[first_block, first_block + slots_.size())中还没有请求的块提交读请求
+    void prefetch(int64_t first_block);
+    // 等待并处理完成事件，wait为false时只处理已经完成的
+    bool reap(bool wait);
+    // 找到保存指定块的槽位，没有时返回nullptr
+    Slot *findSlot(int64_t block);
+
+    int fd_; // 文件描述符
+    int64_t size_; // 文件大小
+    int64_t pos_; // 当前读取位置
+    int block_size_; // 每个读请求的字节数
+    AVIOContext *avio_ctx_; // 交给libavformat的IO上下文
+    std::unique_ptr<Ring> ring_; // 为空时使用pread
+    std::vector<Slot> slots_; // 预读的槽位，数量等于队列深度
+    int64_t bytes_read_; // 读取的总字节数
+    int64_t stall_count_; // 需要等待读请求完成的次数
+};
@@ -1,8 +1,39 @@
 #pragma once
 
-// 多媒体类型定义
-enum class MediaType
+#include <cstdint>
+
+// 多媒体类型定义，用一个字节存放，方便放进PacketInfo这类紧凑的结构
+enum class MediaType : uint8_t
 {
     VIDEO,
     AUDIO,
-};
\ No newline at end of file
+    SUBTITLE, // 字幕，稀疏流
+    DATA,     // 定时元数据等数据流，稀疏流
+};
+
+// 媒体类型的数量，用于按类型索引的数组
+constexpr int MEDIA_TYPE_COUNT = 4;
+
+// 返回媒体类型的名称，用于日志输出
+inline const char *mediaTypeName(MediaType type)
+{
+    switch (type)
+    {
+    case MediaType::VIDEO:
+        return "VIDEO";
+    case MediaType::AUDIO:
+        return "AUDIO";
+    case MediaType::SUBTITLE:
+        return "SUBTITLE";
+    case MediaType::DATA:
+        return "DATA";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// 是否为稀疏流：包之间可能隔很长时间，读取时不能为了等它无限制地缓存其他类型的包
+inline bool isSparseMediaType(MediaType type)
+{
+    return type == MediaType::SUBTITLE || type == MediaType::DATA;
+}
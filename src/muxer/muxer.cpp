@@ -0,0 +1,354 @@
+#include "muxer.hpp"
+#include "demuxer/demuxer.hpp"
+
+#include "utils/logger.hpp"
+
+#include <memory>
+#include <sys/stat.h>
+
+Muxer::Muxer()
+    : format_ctx_(nullptr), header_written_(false)
+{
+}
+
+Muxer::~Muxer()
+{
+    close();
+}
+
+// 创建输出上下文并打开输出文件，流要在第一次写包之前添加
+bool Muxer::open(const std::string &filename, const MuxerOptions &options)
+{
+    LOG_INFO << "Opening muxer for file: " << filename;
+    if (filename.empty())
+    {
+        LOG_ERROR << "Filename is empty.";
+        return false;
+    }
+    if (format_ctx_)
+    {
+        LOG_WARN << "Muxer already opened. Closing previous output.";
+        close();
+    }
+
+    open_start_ = std::chrono::steady_clock::now();
+    stats_ = MuxerStats();
+    options_ = options;
+    // 格式名为空时libavformat根据扩展名猜测输出格式
+    int ret = avformat_alloc_output_context2(&format_ctx_, nullptr, options.format.empty() ? nullptr : options.format.c_str(),
+                                             filename.c_str());
+    if (ret < 0 || !format_ctx_)
+    {
+        logError("Could not create output context", ret);
+        format_ctx_ = nullptr;
+        return false;
+    }
+    // 有些格式（如图片序列）自己管理输出文件
+    if (!(format_ctx_->oformat->flags & AVFMT_NOFILE))
+    {
+        ret = avio_open(&format_ctx_->pb, filename.c_str(), AVIO_FLAG_WRITE);
+        if (ret < 0)
+        {
+            logError("Could not open output file", ret);
+            release();
+            return false;
+        }
+    }
+    filename_ = filename;
+    LOG_INFO << "Muxer opened with format " << format_ctx_->oformat->name;
+    return true;
+}
+
+// 只复制编解码参数，codec_tag清零交给输出格式重新选择，不同容器的tag不通用（例如MKV的H.264放进MP4）
+int Muxer::addStream(const AVStream *input_stream)
+{
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Muxer not opened.";
+        return -1;
+    }
+    if (!input_stream)
+    {
+        LOG_ERROR << "Input stream is null.";
+        return -1;
+    }
+    if (header_written_)
+    {
+        LOG_ERROR << "Streams must be added before the header is written.";
+        return -1;
+    }
+    int input_index = input_stream->index;
+    if (hasStream(input_index))
+    {
+        return mappings_[input_index].output_index;
+    }
+    const AVCodecParameters *input_par = input_stream->codecpar;
+    if (avformat_query_codec(format_ctx_->oformat, input_par->codec_id, FF_COMPLIANCE_NORMAL) == 0)
+    {
+        LOG_ERROR << "Codec " << avcodec_get_name(input_par->codec_id) << " is not supported by format "
+                  << format_ctx_->oformat->name << ".";
+        return -1;
+    }
+
+    AVStream *output_stream = avformat_new_stream(format_ctx_, nullptr);
+    if (!output_stream)
+    {
+        LOG_ERROR << "Failed to allocate output stream.";
+        return -1;
+    }
+    int ret = avcodec_parameters_copy(output_stream->codecpar, input_par);
+    if (ret < 0)
+    {
+        logError("Could not copy codec parameters", ret);
+        return -1;
+    }
+    output_stream->codecpar->codec_tag = 0;
+    // 时间基只是建议值，avformat_write_header可能会改成格式要求的时间基
+    output_stream->time_base = input_stream->time_base;
+    output_stream->avg_frame_rate = input_stream->avg_frame_rate;
+    output_stream->sample_aspect_ratio = input_stream->sample_aspect_ratio;
+    output_stream->disposition = input_stream->disposition;
+    av_dict_copy(&output_stream->metadata, input_stream->metadata, 0);
+
+    if (static_cast<int>(mappings_.size()) <= input_index)
+    {
+        mappings_.resize(input_index + 1);
+    }
+    mappings_[input_index].output_index = output_stream->index;
+    mappings_[input_index].input_time_base = input_stream->time_base;
+    LOG_INFO << "Mapped input stream " << input_index << " (" << avcodec_get_name(input_par->codec_id)
+             << ") to output stream " << output_stream->index;
+    return output_stream->index;
+}
+
+int Muxer::addStream(const Demuxer &demuxer, MediaType type)
+{
+    const AVStream *stream = demuxer.getAVStream(type);
+    if (!stream)
+    {
+        LOG_ERROR << "Demuxer has no " << mediaTypeName(type) << " stream.";
+        return -1;
+    }
+    return addStream(stream);
+}
+
+bool Muxer::writeHeader()
+{
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Muxer not opened.";
+        return false;
+    }
+    if (header_written_)
+    {
+        return true;
+    }
+    if (format_ctx_->nb_streams == 0)
+    {
+        LOG_ERROR << "No output streams added.";
+        return false;
+    }
+    AVDictionary *options = nullptr;
+    if (options_.faststart)
+    {
+        av_dict_set(&options, "movflags", "+faststart", 0);
+    }
+    int ret = avformat_write_header(format_ctx_, &options);
+    av_dict_free(&options); // 输出格式不认识的选项留在字典里，一并释放
+    if (ret < 0)
+    {
+        logError("Could not write header", ret);
+        return false;
+    }
+    header_written_ = true;
+    return true;
+}
+
+// 写入之前把时间戳换算到输出流的时间基，文件位置由输出格式重新计算
+bool Muxer::writePacket(AVPacket *packet)
+{
+    if (!format_ctx_)
+    {
+        LOG_ERROR << "Muxer not opened.";
+        return false;
+    }
+    if (!packet)
+    {
+        LOG_ERROR << "Packet is null.";
+        return false;
+    }
+    if (!hasStream(packet->stream_index))
+    {
+        stats_.dropped++;
+        av_packet_unref(packet);
+        return true;
+    }
+    if (!header_written_ && !writeHeader())
+    {
+        av_packet_unref(packet);
+        return false;
+    }
+
+    const StreamMapping &mapping = mappings_[packet->stream_index];
+    AVStream *output_stream = format_ctx_->streams[mapping.output_index];
+    av_packet_rescale_ts(packet, mapping.input_time_base, output_stream->time_base);
+    packet->stream_index = mapping.output_index;
+    packet->pos = -1;
+    int64_t size = packet->size;
+
+    auto write_start = std::chrono::steady_clock::now();
+    // av_interleaved_write_frame取走包的引用，av_write_frame不取走，两种情况之后都unref
+    int ret = options_.interleave ? av_interleaved_write_frame(format_ctx_, packet) : av_write_frame(format_ctx_, packet);
+    av_packet_unref(packet);
+    stats_.write_us += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - write_start).count();
+    if (ret < 0)
+    {
+        logError("Error writing packet", ret);
+        return false;
+    }
+    stats_.packets++;
+    stats_.bytes += size;
+    return true;
+}
+
+bool Muxer::hasStream(int input_stream_index) const
+{
+    return input_stream_index >= 0 && input_stream_index < static_cast<int>(mappings_.size()) &&
+           mappings_[input_stream_index].output_index >= 0;
+}
+
+// 写文件尾时交错缓冲中剩余的包会一起写出
+bool Muxer::close()
+{
+    if (!format_ctx_)
+    {
+        return true;
+    }
+    LOG_INFO << "Closing Muxer...";
+    bool ok = true;
+    if (header_written_)
+    {
+        int ret = av_write_trailer(format_ctx_);
+        if (ret < 0)
+        {
+            logError("Could not write trailer", ret);
+            ok = false;
+        }
+    }
+    release();
+    stats_.total_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - open_start_).count();
+    struct stat st;
+    if (::stat(filename_.c_str(), &st) == 0)
+    {
+        stats_.file_size = static_cast<int64_t>(st.st_size);
+    }
+    LOG_INFO << "Muxer closed: " << stats_.packets << " packets, " << stats_.bytes << " bytes in " << stats_.total_us << "us";
+    filename_.clear();
+    return ok;
+}
+
+void Muxer::release()
+{
+    if (format_ctx_)
+    {
+        if (format_ctx_->pb && !(format_ctx_->oformat->flags & AVFMT_NOFILE))
+        {
+            avio_closep(&format_ctx_->pb);
+        }
+        avformat_free_context(format_ctx_);
+        format_ctx_ = nullptr;
+    }
+    mappings_.clear();
+    header_written_ = false;
+}
+
+void Muxer::logError(const char *what, int error)
+{
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(error, errbuf, sizeof(errbuf));
+    LOG_ERROR << what << ": " << errbuf;
+}
+
+// 单一类型用单流模式的Demuxer，其他流的数据由libavformat直接跳过；多种类型用多流模式按文件顺序读
+bool Muxer::remux(const std::string &input, const std::string &output, const std::vector<MediaType> &types,
+                  const MuxerOptions &options, MuxerStats *stats)
+{
+    std::vector<MediaType> wanted = types.empty() ? std::vector<MediaType>{MediaType::VIDEO, MediaType::AUDIO} : types;
+    std::unique_ptr<Demuxer> demuxer = wanted.size() == 1 ? std::make_unique<Demuxer>(wanted[0]) : std::make_unique<Demuxer>();
+    if (!demuxer->open(input))
+    {
+        return false;
+    }
+    // 多流模式下字幕和数据流默认不输出，选中该类型的第一条轨道
+    if (demuxer->isMultiStream())
+    {
+        for (MediaType type : wanted)
+        {
+            if (!isSparseMediaType(type))
+            {
+                continue;
+            }
+            AVMediaType codec_type = type == MediaType::SUBTITLE ? AVMEDIA_TYPE_SUBTITLE : AVMEDIA_TYPE_DATA;
+            for (const TrackInfo &track : demuxer->getTracks())
+            {
+                if (track.codec_type == codec_type)
+                {
+                    demuxer->selectTrack(type, track.stream_index);
+                    break;
+                }
+            }
+        }
+    }
+
+    Muxer muxer;
+    if (!muxer.open(output, options))
+    {
+        return false;
+    }
+    for (MediaType type : wanted)
+    {
+        if (demuxer->getStreamIndex(type) < 0)
+        {
+            LOG_WARN << "No " << mediaTypeName(type) << " stream in " << input << ", skipping it.";
+            continue;
+        }
+        if (muxer.addStream(*demuxer, type) < 0)
+        {
+            return false;
+        }
+    }
+    if (muxer.getStreamCount() == 0)
+    {
+        LOG_ERROR << "Nothing to remux from " << input << ".";
+        return false;
+    }
+    if (!muxer.writeHeader())
+    {
+        return false;
+    }
+
+    PacketPtr packet = makePacket();
+    if (!packet)
+    {
+        LOG_ERROR << "Failed to allocate packet.";
+        return false;
+    }
+    while (demuxer->readPacket(packet.get()))
+    {
+        if (!muxer.writePacket(packet.get()))
+        {
+            return false;
+        }
+    }
+    if (demuxer->getLastStatus() != DemuxStatus::END_OF_FILE)
+    {
+        LOG_ERROR << "Failed to read " << input << " to the end.";
+        return false;
+    }
+    bool ok = muxer.close();
+    if (stats)
+    {
+        *stats = muxer.getStats();
+    }
+    return ok;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+extern "C"
+{
+//多媒体封装和解封装API
+#include <libavformat/avformat.h>
+}
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mediadefs.hpp"//多媒体类型的定义
+
+class Demuxer;
+
+// open()的选项
+struct MuxerOptions
+{
+    std::string format;     // 输出容器格式名（如mp4、matroska），为空时按文件扩展名推断
+    bool interleave = true; // 用av_interleaved_write_frame按时间交错写入；为false时按调用顺序直接写，调用者需要保证各流的dts递增
+    bool faststart = false; // mp4/mov把moov放到文件开头，方便边下边播，结束时要把整个文件再搬一遍
+};
+
+// 写入的统计信息
+struct MuxerStats
+{
+    int64_t packets = 0;       // 写入的包数
+    int64_t bytes = 0;         // 写入的包数据字节数
+    int64_t dropped = 0;       // 不属于任何输出流而被丢掉的包数
+    int64_t write_us = 0;      // 花在写包上的时间（微秒），包括交错缓冲和IO
+    int64_t total_us = 0;      // 从open()到close()的总耗时（微秒）
+    int64_t file_size = 0;     // close()之后输出文件的大小
+};
+
+// 流复制的封装器，与Demuxer对应：打开输出文件、按输入流的编解码参数添加流、写包时换算时间戳并交错
+// 不解码也不编码，可以在磁盘速度下把MKV转成MP4，或者从文件中提取单独的一条轨道
+class Muxer
+{
+public:
+    Muxer();
+    ~Muxer();
+
+    Muxer(const Muxer &) = delete;
+    Muxer &operator=(const Muxer &) = delete;
+
+    bool open(const std::string &filename, const MuxerOptions &options = MuxerOptions());
+    //写入文件尾并关闭输出文件，已经写过文件头时才写文件尾；返回文件尾是否写入成功
+    bool close();
+
+    //按输入流的编解码参数、时间基和元数据添加一条输出流，返回输出流的索引，失败返回-1
+    //写包时packet的stream_index使用输入流的索引，由Muxer映射到输出流
+    //输出格式不支持该编解码器时失败（例如MP4中的SRT字幕需要先转换成mov_text）
+    int addStream(const AVStream *input_stream);
+    //添加Demuxer当前选中的某一类型的流，该类型没有流时返回-1
+    int addStream(const Demuxer &demuxer, MediaType type);
+    //写文件头，第一次writePacket()时会自动调用
+    bool writeHeader();
+    //写一个包：时间戳从输入流的时间基换算到输出流的时间基，packet的数据被取走，调用后packet为空
+    //不属于任何输出流的包被丢掉并返回true
+    bool writePacket(AVPacket *packet);
+
+    //输入流是否已经映射到输出流
+    bool hasStream(int input_stream_index) const;
+    int getStreamCount() const { return format_ctx_ ? static_cast<int>(format_ctx_->nb_streams) : 0; }
+    AVFormatContext *getFormatContext() const { return format_ctx_; }
+    const MuxerStats &getStats() const { return stats_; }
+    bool isOpen() const { return format_ctx_ != nullptr; }
+
+    //把input中选中的流原样复制到output
+    //types为空时复制Demuxer默认选中的视频和音频；包含SUBTITLE或DATA时取该类型的第一条轨道
+    //stats不为空时返回写入的统计信息
+    static bool remux(const std::string &input, const std::string &output, const std::vector<MediaType> &types = {},
+                      const MuxerOptions &options = MuxerOptions(), MuxerStats *stats = nullptr);
+
+private:
+    // 输入流到输出流的映射
+    struct StreamMapping
+    {
+        int output_index = -1;
+        AVRational input_time_base = {0, 1};
+    };
+
+    // 释放format_ctx_和输出IO
+    void release();
+    // 记录FFmpeg返回的错误
+    static void logError(const char *what, int error);
+
+    AVFormatContext *format_ctx_; // 输出格式上下文
+    std::string filename_; // 输出文件
+    MuxerOptions options_; // open()的选项
+    std::vector<StreamMapping> mappings_; // 按输入流索引存放
+    bool header_written_; // 是否已经写了文件头
+    MuxerStats stats_; // 写入统计
+    std::chrono::steady_clock::time_point open_start_; // open()的时间，用于计算总耗时
+};
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace utils
+{
+
+    // 按缓存行对齐，避免生产者和消费者的索引落在同一个缓存行上互相干扰（伪共享）
+    constexpr size_t CACHE_LINE_SIZE = 64;
+
+    namespace detail
+    {
+        // 把容量向上取整到2的幂，下标可以用位与代替取模
+        inline size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // 队列空或满时的阻塞等待
+        // 先自旋一小段时间，仍然不满足条件再在条件变量上睡眠；没有线程睡眠时唤醒方不会加锁
+        class Waiter
+        {
+        public:
+            template <typename Ready>
+            void wait(Ready ready)
+            {
+                for (int i = 0; i < SPIN_COUNT; ++i)
+                {
+                    if (ready())
+                    {
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                sleepers_.fetch_add(1, std::memory_order_relaxed);
+                // 与notify()中的栅栏配对：要么唤醒方看到sleepers_，要么这里看到对方写入的数据
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                cond_.wait(lock, ready);
+                sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            void notify()
+            {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (sleepers_.load(std::memory_order_relaxed) > 0)
+                {
+                    // 加锁保证等待方不会在检查条件和睡眠之间错过通知
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    cond_.notify_all();
+                }
+            }
+
+        private:
+            static constexpr int SPIN_COUNT = 64;
+
+            std::mutex mutex_;
+            std::condition_variable cond_;
+            std::atomic<int> sleepers_{0};
+        };
+    }
+
+    // 单生产者单消费者的有界环形队列
+    // 元素可以是AVPacket*、AVFrame*这样的指针，也可以是unique_ptr等只能移动的句柄
+    // tryPush/tryPop不加锁，push/pop只在队列满或空时阻塞
+    template <typename T>
+    class SpscQueue
+    {
+    public:
+        // 容量会向上取整到2的幂
+        explicit SpscQueue(size_t capacity)
+            : capacity_(detail::roundUpToPowerOfTwo(capacity < 1 ? 1 : capacity)), mask_(capacity_ - 1),
+              slots_(new Slot[capacity_])
+        {
+        }
+
+        ~SpscQueue()
+        {
+            // 销毁没有被取走的元素
+            for (size_t i = head_.load(std::memory_order_relaxed); i != tail_.load(std::memory_order_relaxed); ++i)
+            {
+                slots_[i & mask_].get()->~T();
+            }
+        }
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // 队列满时返回false，item保持不变
+        bool tryPush(T &&item)
+        {
+            size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_cache_ >= capacity_)
+            {
+                // 缓存的消费位置过期了才重新读取，减少跨核的缓存行同步
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if (tail - head_cache_ >= capacity_)
+                {
+                    return false;
+                }
+            }
+            new (slots_[tail & mask_].storage) T(std::move(item));
+            tail_.store(tail + 1, std::memory_order_release);
+            not_empty_.notify();
+            return true;
+        }
+
+        bool tryPush(const T &item)
+        {
+            T copy(item);
+            return tryPush(std::move(copy));
+        }
+
+        // 队列空时返回false
+        bool tryPop(T &item)
+        {
+            size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_cache_)
+            {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (head == tail_cache_)
+                {
+                    return false;
+                }
+            }
+            T *slot = slots_[head & mask_].get();
+            item = std::move(*slot);
+            slot->~T();
+            head_.store(head + 1, std::memory_order_release);
+            not_full_.notify();
+            return true;
+        }
+
+        // 队列满时阻塞，队列已关闭时返回false
+        bool push(T &&item)
+        {
+            while (!closed_.load(std::memory_order_acquire))
+            {
+                if (tryPush(std::move(item)))
+                {
+                    return true;
+                }
+                not_full_.wait([this] { return !full() || closed_.load(std::memory_order_acquire); });
+            }
+            return false;
+        }
+
+        bool push(const T &item)
+        {
+            T copy(item);
+            return push(std::move(copy));
+        }
+
+        // 队列空时阻塞，队列已关闭且取空后返回false
+        bool pop(T &item)
+        {
+            while (true)
+            {
+                if (tryPop(item))
+                {
+                    return true;
+                }
+                if (closed_.load(std::memory_order_acquire))
+                {
+                    return tryPop(item);
+                }
+                not_empty_.wait([this] { return !empty() || closed_.load(std::memory_order_acquire); });
+            }
+        }
+
+        // 关闭队列，唤醒所有等待的线程；关闭后不能再放入，剩余的元素仍然可以取出
+        void close()
+        {
+            closed_.store(true, std::memory_order_release);
+            not_empty_.notify();
+            not_full_.notify();
+        }
+
+        bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+        size_t capacity() const { return capacity_; }
+        // 其他线程同时读写时只是近似值
+        size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+        bool empty() const { return size() == 0; }
+        bool full() const { return size() >= capacity_; }
+
+    private:
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+            T *get() { return std::launder(reinterpret_cast<T *>(storage)); }
+        };
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Slot[]> slots_;
+
+        // 消费者写head_，生产者写tail_，各自连同缓存的对方位置放在独立的缓存行上
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+        size_t tail_cache_ = 0; // 消费者缓存的tail_
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+        size_t head_cache_ = 0; // 生产者缓存的head_
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> closed_{false};
+        detail::Waiter not_empty_;
+        detail::Waiter not_full_;
+    };
+
+    // 多生产者单消费者的有界环形队列
+    // 每个槽位带一个序号，生产者通过CAS抢占写入位置，写完后发布序号，消费者按序号判断槽位是否可读
+    template <typename T>
+    class MpscQueue
+    {
+    public:
+        // 容量会向上取整到2的幂
+        explicit MpscQueue(size_t capacity)
+            : capacity_(detail::roundUpToPowerOfTwo(capacity < 1 ? 1 : capacity)), mask_(capacity_ - 1),
+              cells_(new Cell[capacity_])
+        {
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~MpscQueue()
+        {
+            // 销毁没有被取走的元素，此时不应再有生产者在写入
+            for (size_t pos = head_.load(std::memory_order_relaxed);
+                 cells_[pos & mask_].sequence.load(std::memory_order_relaxed) == pos + 1; ++pos)
+            {
+                cells_[pos & mask_].get()->~T();
+            }
+        }
+
+        MpscQueue(const MpscQueue &) = delete;
+        MpscQueue &operator=(const MpscQueue &) = delete;
+
+        // 队列满时返回false，item保持不变
+        bool tryPush(T &&item)
+        {
+            size_t pos = tail_.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Cell &cell = cells_[pos & mask_];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+                if (diff == 0)
+                {
+                    // 槽位空闲，抢占这个写入位置
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        new (cell.storage) T(std::move(item));
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        not_empty_.notify();
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false; // 槽位上一轮的数据还没有被取走，队列已满
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed); // 被其他生产者抢先了
+                }
+            }
+        }
+
+        bool tryPush(const T &item)
+        {
+            T copy(item);
+            return tryPush(std::move(copy));
+        }
+
+        // 队列空时返回false，只能在一个消费者线程中调用
+        bool tryPop(T &item)
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            Cell &cell = cells_[pos & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+                return false; // 空，或者抢到这个位置的生产者还没写完
+            }
+            T *slot = cell.get();
+            item = std::move(*slot);
+            slot->~T();
+            // 槽位留给下一轮的生产者
+            cell.sequence.store(pos + capacity_, std::memory_order_release);
+            head_.store(pos + 1, std::memory_order_release);
+            not_full_.notify();
+            return true;
+        }
+
+        // 队列满时阻塞，队列已关闭时返回false
+        bool push(T &&item)
+        {
+            while (!closed_.load(std::memory_order_acquire))
+            {
+                if (tryPush(std::move(item)))
+                {
+                    return true;
+                }
+                not_full_.wait([this] { return !full() || closed_.load(std::memory_order_acquire); });
+            }
+            return false;
+        }
+
+        bool push(const T &item)
+        {
+            T copy(item);
+            return push(std::move(copy));
+        }
+
+        // 队列空时阻塞，队列已关闭且取空后返回false
+        bool pop(T &item)
+        {
+            while (true)
+            {
+                if (tryPop(item))
+                {
+                    return true;
+                }
+                if (closed_.load(std::memory_order_acquire) && empty())
+                {
+                    return tryPop(item);
+                }
+                not_empty_.wait([this] { return readable() || (closed_.load(std::memory_order_acquire) && empty()); });
+            }
+        }
+
+        // 关闭队列，唤醒所有等待的线程；关闭后不能再放入，剩余的元素仍然可以取出
+        void close()
+        {
+            closed_.store(true, std::memory_order_release);
+            not_empty_.notify();
+            not_full_.notify();
+        }
+
+        bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+        size_t capacity() const { return capacity_; }
+        // 包括已经抢到位置但还没写完的元素，其他线程同时读写时只是近似值
+        size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+        bool empty() const { return size() == 0; }
+        bool full() const { return size() >= capacity_; }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+            T *get() { return std::launder(reinterpret_cast<T *>(storage)); }
+        };
+
+        // 队头的槽位是否已经写完，可以取出
+        bool readable() const
+        {
+            size_t pos = head_.load(std::memory_order_relaxed);
+            return cells_[pos & mask_].sequence.load(std::memory_order_acquire) == pos + 1;
+        }
+
+        const size_t capacity_;
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> closed_{false};
+        detail::Waiter not_empty_;
+        detail::Waiter not_full_;
+    };
+
+}
@@ -4,8 +4,27 @@
 #include <vector>
 #include <memory>
 #include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sys/resource.h>
+#include <random>
+#include <tuple>
 
 #include "demuxer/demuxer.hpp"
+#include "demuxer/accurate_seeker.hpp"
+#include "demuxer/thumbnail_engine.hpp"
+#include "demuxer/segment_scanner.hpp"
+#include "demuxer/subtitle_cache.hpp"
+#include "demuxer/packet_tee.hpp"
 #include "utils/logger.hpp"
 
 // 简单的测试框架宏
@@ -330,6 +349,2331 @@ bool testMultipleOpenClose() {
     return true;
 }
 
+// 测试11: 复用调用者持有的packet读包
+bool testReadPacketReuse() {
+    const std::string test_file = "test_reuse.mp4";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    bool result = demuxer.open(test_file);
+    TEST_ASSERT(result, "Should open test file for packet reuse test");
+    
+    // 同一个packet反复读取
+    PacketPtr packet = makePacket();
+    TEST_ASSERT(packet != nullptr, "Should allocate reusable packet");
+    int packet_count = 0;
+    while (demuxer.readPacket(packet.get()) && packet_count < 10) {
+        TEST_ASSERT(packet->stream_index == demuxer.getStreamIndex(),
+                   "Reused packet should belong to correct stream");
+        packet_count++;
+    }
+    TEST_ASSERT(packet_count > 0, "Should read packets into reused packet");
+    
+    // RAII句柄版本
+    PacketPtr owned = demuxer.readPacketPtr();
+    TEST_ASSERT(owned != nullptr, "Should read packet into RAII handle");
+    TEST_ASSERT(owned->stream_index == demuxer.getStreamIndex(),
+               "Handle packet should belong to correct stream");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    
+    return true;
+}
+
+// 测试12: 多流模式同时服务视频和音频消费者
+bool testMultiStreamDemuxer() {
+    const std::string test_file = "test_multi_stream.mp4";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 单流模式下分别统计视频和音频包数，作为对照
+    int expected_video = 0;
+    int expected_audio = 0;
+    {
+        Demuxer video_demuxer(MediaType::VIDEO);
+        TEST_ASSERT(video_demuxer.open(test_file), "Should open file in video mode");
+        PacketPtr packet = makePacket();
+        while (video_demuxer.readPacket(packet.get())) {
+            expected_video++;
+        }
+        Demuxer audio_demuxer(MediaType::AUDIO);
+        TEST_ASSERT(audio_demuxer.open(test_file), "Should open file in audio mode");
+        while (audio_demuxer.readPacket(packet.get())) {
+            expected_audio++;
+        }
+    }
+    
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.isMultiStream(), "Default constructor should create multi-stream demuxer");
+    TEST_ASSERT(demuxer.open(test_file), "Should open file in multi-stream mode");
+    TEST_ASSERT(demuxer.getStreamIndex(MediaType::VIDEO) >= 0, "Should find video stream");
+    TEST_ASSERT(demuxer.getStreamIndex(MediaType::AUDIO) >= 0, "Should find audio stream");
+    
+    // 视频和音频消费者各自在线程中读包
+    int video_count = 0;
+    int audio_count = 0;
+    bool video_ok = true;
+    bool audio_ok = true;
+    auto consume = [&demuxer](MediaType type, int &count, bool &ok) {
+        PacketPtr packet = makePacket();
+        while (true) {
+            if (!demuxer.readPacket(type, packet.get())) {
+                // 另一个消费者落后太多时暂存队列满了，等它取走之后再读
+                if (demuxer.isEOF()) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            if (packet->stream_index != demuxer.getStreamIndex(type)) {
+                ok = false;
+            }
+            count++;
+        }
+    };
+    std::thread video_thread(consume, MediaType::VIDEO, std::ref(video_count), std::ref(video_ok));
+    std::thread audio_thread(consume, MediaType::AUDIO, std::ref(audio_count), std::ref(audio_ok));
+    video_thread.join();
+    audio_thread.join();
+    
+    TEST_ASSERT(video_ok && audio_ok, "Packets should be routed to the right consumer");
+    TEST_ASSERT(video_count == expected_video, "Video consumer should get every video packet");
+    TEST_ASSERT(audio_count == expected_audio, "Audio consumer should get every audio packet");
+    
+    // 定位后两个消费者都从新位置继续
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek multi-stream demuxer");
+    PacketPtr audio_packet(demuxer.readPacket(MediaType::AUDIO));
+    TEST_ASSERT(audio_packet != nullptr, "Should read audio after seek");
+    PacketPtr video_packet(demuxer.readPacket(MediaType::VIDEO));
+    TEST_ASSERT(video_packet != nullptr, "Should read video after seek");
+    
+    // 音频消费者暂停时，视频继续读到暂存上限就停下，而不是把整个文件的音频都暂存起来
+    PendingPacketOptions pending_options;
+    pending_options.max_pending_packets = 64;
+    demuxer.setPendingPacketOptions(pending_options);
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+    PacketPtr packet = makePacket();
+    int video_read = 0;
+    while (demuxer.readPacket(MediaType::VIDEO, packet.get())) {
+        video_read++;
+    }
+    TEST_ASSERT(demuxer.getLastStatus() == DemuxStatus::AGAIN, "Video read should stop with AGAIN while audio is paused");
+    TEST_ASSERT(!demuxer.isEOF(), "Stopping at the pending limit is not EOF");
+    TEST_ASSERT(video_read > 0 && video_read < expected_video, "Video should stop before the end of the file");
+    int audio_drained = 0;
+    while (audio_drained < 64 && demuxer.readPacket(MediaType::AUDIO, packet.get())) {
+        audio_drained++;
+    }
+    TEST_ASSERT(audio_drained == 64, "Paused audio should find its pending packets");
+    TEST_ASSERT(demuxer.readPacket(MediaType::VIDEO, packet.get()), "Video should continue after audio caught up");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    
+    return true;
+}
+
+// 测试13: open()把不需要的流标记为丢弃
+bool testDiscardUnusedStreams() {
+    const std::string test_file = "test_discard.mp4";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open test file for discard test");
+    
+    // 单流模式下音频流不需要，应该被丢弃
+    int audio_index = demuxer.getStreamIndex(MediaType::AUDIO);
+    TEST_ASSERT(audio_index >= 0, "Should still report audio stream index");
+    AVFormatContext* ctx = demuxer.getFormatContext();
+    TEST_ASSERT(ctx->streams[audio_index]->discard == AVDISCARD_ALL, "Audio stream should be discarded");
+    TEST_ASSERT(ctx->streams[demuxer.getStreamIndex()]->discard != AVDISCARD_ALL, "Video stream should not be discarded");
+    
+    PacketPtr packet = makePacket();
+    while (demuxer.readPacket(packet.get())) {
+    }
+    
+    DiscardStats stats = demuxer.getDiscardStats();
+    std::cout << "streams discarded: " << stats.streams_discarded
+              << ", packets avoided: " << stats.packets_avoided
+              << ", bytes avoided: " << stats.bytes_avoided
+              << ", packets filtered: " << stats.packets_filtered << std::endl;
+    TEST_ASSERT(stats.streams_discarded == 1, "Should discard exactly the audio stream");
+    TEST_ASSERT(stats.packets_avoided > 0, "MP4 index should show skipped audio packets");
+    
+    // 多流模式下视频和音频都不丢弃
+    Demuxer multi_demuxer;
+    TEST_ASSERT(multi_demuxer.open(test_file), "Should open test file in multi-stream mode");
+    TEST_ASSERT(multi_demuxer.getDiscardStats().streams_discarded == 0, "Multi-stream mode should keep both streams");
+    
+    demuxer.close();
+    multi_demuxer.close();
+    std::remove(test_file.c_str());
+    
+    return true;
+}
+
+// 测试14: 快速打开模式和打开耗时统计
+bool testFastOpen() {
+    const std::string test_file = "test_fast_open.mp4";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 默认完整探测
+    Demuxer full_demuxer(MediaType::VIDEO);
+    TEST_ASSERT(full_demuxer.open(test_file), "Should open file with full probe");
+    OpenTiming full_timing = full_demuxer.getOpenTiming();
+    TEST_ASSERT(full_timing.total_us > 0, "Should record total open time");
+    TEST_ASSERT(full_timing.total_us >= full_timing.open_input_us + full_timing.find_stream_info_us,
+               "Total open time should cover the measured stages");
+    TEST_ASSERT(!full_timing.full_probe_fallback, "Full probe should not fall back");
+    
+    // 极小的探测预算，参数不完整时应该自动退回完整探测
+    Demuxer fast_demuxer(MediaType::VIDEO);
+    OpenOptions options;
+    options.fast_open = true;
+    options.probe_size = 32;
+    options.analyze_duration = 1;
+    fast_demuxer.setOpenOptions(options);
+    TEST_ASSERT(fast_demuxer.open(test_file), "Should open file with fast probe");
+    OpenTiming fast_timing = fast_demuxer.getOpenTiming();
+    std::cout << "full open: " << full_timing.total_us << "us, fast open: " << fast_timing.total_us
+              << "us, fallback: " << fast_timing.full_probe_fallback << std::endl;
+    
+    AVStream* stream = fast_demuxer.getAVStream();
+    TEST_ASSERT(stream != nullptr, "Fast open should find video stream");
+    TEST_ASSERT(stream->codecpar->width == 320 && stream->codecpar->height == 240,
+               "Fast open should report complete video parameters");
+    PacketPtr packet = fast_demuxer.readPacketPtr();
+    TEST_ASSERT(packet != nullptr, "Should read packet after fast open");
+    
+    full_demuxer.close();
+    fast_demuxer.close();
+    std::remove(test_file.c_str());
+    
+    return true;
+}
+
+// 测试15: 关键帧索引定位
+bool testKeyframeIndexSeek() {
+    // MPEG-TS走按字节偏移跳转，MP4走按关键帧时间戳跳转
+    const std::string test_files[] = {"test_index_seek.ts", "test_index_seek.mp4"};
+    for (const std::string& test_file : test_files) {
+        if (!createTestVideoFile(test_file)) {
+            std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+            return true;
+        }
+        
+        Demuxer demuxer(MediaType::VIDEO);
+        TEST_ASSERT(demuxer.open(test_file), "Should open " + test_file + " for index test");
+        TEST_ASSERT(demuxer.startIndexing(), "Should start background indexing");
+        
+        // 等待后台扫描完成
+        for (int i = 0; i < 500 && !demuxer.isIndexComplete(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        TEST_ASSERT(demuxer.isIndexComplete(), "Background indexing should complete");
+        TEST_ASSERT(demuxer.getSeekIndex().size() > 0, "Index should contain keyframes");
+        std::cout << test_file << ": " << demuxer.getSeekIndex().size() << " keyframes indexed" << std::endl;
+        
+        // 定位到中间，落点应该是目标之前的关键帧
+        int64_t target = demuxer.getDuration() / 2;
+        int64_t landed = AV_NOPTS_VALUE;
+        TEST_ASSERT(demuxer.seek(target, 0, &landed), "Indexed seek should succeed");
+        TEST_ASSERT(landed != AV_NOPTS_VALUE, "Indexed seek should report landing timestamp");
+        TEST_ASSERT(landed <= target, "Landing keyframe should not be after the target");
+        
+        // 定位后读到的第一个关键帧就是落点
+        PacketPtr packet = makePacket();
+        bool found_keyframe = false;
+        for (int i = 0; i < 10 && demuxer.readPacket(packet.get()); i++) {
+            if (packet->flags & AV_PKT_FLAG_KEY) {
+                found_keyframe = true;
+                break;
+            }
+        }
+        TEST_ASSERT(found_keyframe, "Should read a keyframe right after indexed seek");
+        AVStream* stream = demuxer.getAVStream();
+        int64_t packet_us = av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q);
+        TEST_ASSERT(packet_us == landed, "First keyframe after seek should match reported landing");
+        
+        demuxer.close();
+        std::remove(test_file.c_str());
+    }
+    
+    return true;
+}
+
+// 测试16: 关键帧表的插入和二分查找
+bool testSeekIndexLookup() {
+    SeekIndex index;
+    // 乱序插入，包括重复项
+    const int64_t pts_values[] = {3000, 1000, 2000, 5000, 2000, 4000};
+    for (int64_t pts : pts_values) {
+        KeyframeEntry entry = {pts, pts, pts * 10, 100, 0};
+        index.add(entry);
+    }
+    TEST_ASSERT(index.size() == 5, "Duplicate keyframes should be ignored");
+    TEST_ASSERT(index.lastPts() == 5000, "Last pts should be the largest");
+    
+    KeyframeEntry entry;
+    TEST_ASSERT(!index.findFloor(999, entry), "No keyframe before the first one");
+    TEST_ASSERT(index.findFloor(1000, entry) && entry.pts == 1000, "Exact match should be found");
+    TEST_ASSERT(index.findFloor(3999, entry) && entry.pts == 3000 && entry.pos == 30000, "Floor should be previous keyframe");
+    TEST_ASSERT(index.findNext(3000, entry) && entry.pts == 4000, "Next keyframe should be strictly after");
+    TEST_ASSERT(!index.findNext(5000, entry), "No keyframe after the last one");
+    TEST_ASSERT(!index.findSeekPoint(3999, entry), "Keyframes added without a previous one may have gaps between them");
+    
+    // 0-2000连续读到，定位后5000-6000连续读到，中间是空洞
+    SeekIndex gapped;
+    int64_t previous = INT64_MIN;
+    for (int64_t pts : {0, 1000, 2000}) {
+        KeyframeEntry keyframe = {pts, pts, pts * 10, 100, 0};
+        gapped.add(keyframe, previous);
+        previous = pts;
+    }
+    previous = INT64_MIN;
+    for (int64_t pts : {5000, 6000}) {
+        KeyframeEntry keyframe = {pts, pts, pts * 10, 100, 0};
+        gapped.add(keyframe, previous);
+        previous = pts;
+    }
+    TEST_ASSERT(gapped.findSeekPoint(1500, entry) && entry.pts == 1000, "Target inside the contiguous range should use the index");
+    TEST_ASSERT(gapped.findSeekPoint(5500, entry) && entry.pts == 5000, "Target inside the later range should use the index");
+    TEST_ASSERT(gapped.findFloor(3500, entry) && entry.pts == 2000, "Floor ignores the gap");
+    TEST_ASSERT(!gapped.findSeekPoint(3500, entry), "Target inside the gap should not use the index");
+    TEST_ASSERT(!gapped.findSeekPoint(6500, entry), "Target after the last keyframe should not use an incomplete index");
+    // 从2000连续读到5000，空洞被填平
+    previous = 2000;
+    for (int64_t pts : {3000, 4000, 5000}) {
+        KeyframeEntry keyframe = {pts, pts, pts * 10, 100, 0};
+        gapped.add(keyframe, previous);
+        previous = pts;
+    }
+    TEST_ASSERT(gapped.findSeekPoint(4500, entry) && entry.pts == 4000, "Filled gap should use the index");
+    TEST_ASSERT(gapped.findSeekPoint(3500, entry) && entry.pts == 3000, "Filled gap should link to the earlier range");
+    gapped.setComplete(true);
+    TEST_ASSERT(gapped.findSeekPoint(6500, entry) && entry.pts == 6000, "Complete index covers the end of the file");
+    
+    index.clear();
+    TEST_ASSERT(index.size() == 0 && !index.isComplete(), "Clear should reset the index");
+    return true;
+}
+
+// 测试17: 关键帧索引文件的保存和内存映射
+bool testSeekIndexFile() {
+    const std::string index_file = "test_seek_index.ffidx";
+    SeekIndexKey key;
+    key.file_size = 123456;
+    key.mtime_ns = 42;
+    key.stream_index = 0;
+    key.time_base_num = 1;
+    key.time_base_den = 90000;
+    
+    SeekIndex index;
+    for (int64_t i = 0; i < 100; i++) {
+        KeyframeEntry entry = {i * 90000, i * 90000, i * 1000, 500, 0};
+        index.add(entry);
+    }
+    TEST_ASSERT(!index.save(index_file, key), "Incomplete index should not be saved");
+    index.setComplete(true);
+    TEST_ASSERT(index.save(index_file, key), "Complete index should be saved");
+    
+    SeekIndex mapped;
+    TEST_ASSERT(mapped.load(index_file, key), "Should map saved index");
+    TEST_ASSERT(mapped.isMapped() && mapped.isComplete(), "Mapped index should be complete");
+    TEST_ASSERT(mapped.size() == 100, "Mapped index should contain every keyframe");
+    KeyframeEntry entry;
+    TEST_ASSERT(mapped.findFloor(50 * 90000 + 1, entry) && entry.pos == 50000, "Mapped index should support lookups");
+    
+    // 媒体文件变化后索引失效
+    SeekIndexKey stale_key = key;
+    stale_key.mtime_ns = 43;
+    SeekIndex stale;
+    TEST_ASSERT(!stale.load(index_file, stale_key), "Stale index should be rejected");
+    
+    // 截断的索引文件
+    std::ifstream in(index_file, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    {
+        std::ofstream out(index_file, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size() - 20));
+    }
+    SeekIndex truncated;
+    TEST_ASSERT(!truncated.load(index_file, key), "Truncated index should be rejected");
+    
+    // 文件尾损坏
+    {
+        std::string damaged = data;
+        damaged[damaged.size() - 16] = 'X';
+        std::ofstream out(index_file, std::ios::binary | std::ios::trunc);
+        out.write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+    }
+    SeekIndex damaged;
+    TEST_ASSERT(!damaged.load(index_file, key), "Index with damaged trailer should be rejected");
+    
+    std::remove(index_file.c_str());
+    return true;
+}
+
+// 测试18: Demuxer重新打开时使用保存的关键帧索引
+bool testSeekIndexReopen() {
+    const std::string test_file = "test_index_reopen.ts";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    std::string index_file;
+    {
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setSeekIndexCache(true);
+        TEST_ASSERT(demuxer.open(test_file), "Should open file for index build");
+        TEST_ASSERT(!demuxer.isIndexComplete(), "First open should have no index");
+        TEST_ASSERT(demuxer.startIndexing(), "Should start background indexing");
+        for (int i = 0; i < 500 && !demuxer.isIndexComplete(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        TEST_ASSERT(demuxer.isIndexComplete(), "Background indexing should complete");
+        index_file = demuxer.seekIndexPath();
+        demuxer.close();
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    demuxer.setSeekIndexCache(true);
+    TEST_ASSERT(demuxer.open(test_file), "Should reopen file");
+    TEST_ASSERT(demuxer.isIndexComplete(), "Reopen should load the saved index");
+    TEST_ASSERT(demuxer.getSeekIndex().isMapped(), "Saved index should be memory-mapped");
+    int64_t landed = AV_NOPTS_VALUE;
+    TEST_ASSERT(demuxer.seek(demuxer.getDuration() / 2, 0, &landed), "Should seek with mapped index");
+    TEST_ASSERT(landed != AV_NOPTS_VALUE, "Mapped index seek should report landing");
+    demuxer.close();
+    
+    std::remove(index_file.c_str());
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试19: 异步预读
+bool testReadAhead() {
+    const std::string test_file = "test_read_ahead.mp4";
+    
+    // 创建测试文件
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 同步读取的包数作为对照
+    int expected = 0;
+    {
+        Demuxer demuxer(MediaType::VIDEO);
+        TEST_ASSERT(demuxer.open(test_file), "Should open file for sync reading");
+        PacketPtr packet = makePacket();
+        while (demuxer.readPacket(packet.get())) {
+            expected++;
+        }
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for read-ahead");
+    ReadAheadOptions options;
+    options.max_packets = 8; // 很小的队列，让预读线程经常被阻塞
+    TEST_ASSERT(demuxer.startReadAhead(options), "Should start read-ahead");
+    TEST_ASSERT(demuxer.isReadAhead(), "Demuxer should be in read-ahead mode");
+    
+    PacketPtr packet = makePacket();
+    int count = 0;
+    int64_t last_dts = AV_NOPTS_VALUE;
+    bool ordered = true;
+    DemuxStatus status;
+    while ((status = demuxer.popPacket(packet.get(), 1000)) == DemuxStatus::OK) {
+        if (last_dts != AV_NOPTS_VALUE && packet->dts != AV_NOPTS_VALUE && packet->dts < last_dts) {
+            ordered = false;
+        }
+        last_dts = packet->dts;
+        count++;
+    }
+    TEST_ASSERT(status == DemuxStatus::END_OF_FILE, "Read-ahead should end with EOF");
+    TEST_ASSERT(count == expected, "Read-ahead should deliver every packet");
+    TEST_ASSERT(ordered, "Read-ahead should keep packet order");
+    TEST_ASSERT(demuxer.popPacket(packet.get(), 10) == DemuxStatus::END_OF_FILE, "EOF should stay until seek");
+    TEST_ASSERT(demuxer.isEOF(), "isEOF should be true after the EOF item was popped");
+    
+    // 定位后从头开始重新预读
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek while reading ahead");
+    TEST_ASSERT(demuxer.popPacket(packet.get(), 1000) == DemuxStatus::OK, "Should get packets after seek");
+    TEST_ASSERT(packet->flags & AV_PKT_FLAG_KEY, "First packet after seek should be a keyframe");
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "readPacket should pop from the read-ahead queue");
+    
+    demuxer.stopReadAhead();
+    TEST_ASSERT(!demuxer.isReadAhead(), "Read-ahead should stop");
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Sync reading should resume after read-ahead stops");
+    
+    // 预读线程读到文件末尾时队列里还有包，消费者取完之前不算EOF
+    ReadAheadOptions unbounded;
+    unbounded.max_packets = 0;
+    unbounded.max_bytes = 0;
+    unbounded.max_duration_us = 0;
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+    TEST_ASSERT(demuxer.startReadAhead(unbounded), "Should restart read-ahead");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    TEST_ASSERT(!demuxer.isEOF(), "isEOF should stay false while packets are still queued");
+    int drained = 0;
+    bool eof_while_draining = false;
+    while (demuxer.readPacket(packet.get())) {
+        eof_while_draining = eof_while_draining || demuxer.isEOF();
+        drained++;
+    }
+    TEST_ASSERT(!eof_while_draining, "isEOF should stay false while draining");
+    TEST_ASSERT(drained == expected && demuxer.isEOF(), "isEOF should turn true once the queue is drained");
+    demuxer.stopReadAhead();
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 读取/proc/self/io中的read系统调用次数，不可用时返回-1
+static int64_t readSyscallCount() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    int64_t value;
+    while (io >> key >> value) {
+        if (key == "syscr:") {
+            return value;
+        }
+    }
+    return -1;
+}
+
+// 顺序读完整个文件，返回包数和总字节数
+static bool readAllPackets(Demuxer& demuxer, int& count, int64_t& bytes) {
+    PacketPtr packet = makePacket();
+    count = 0;
+    bytes = 0;
+    while (demuxer.readPacket(packet.get())) {
+        count++;
+        bytes += packet->size;
+    }
+    return demuxer.isEOF();
+}
+
+// 测试20: 内存映射IO
+bool testMmapIO() {
+    const std::string test_file = "test_mmap_io.mp4";
+    
+    // 4K高码率的测试文件，让IO的开销明显一些
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=3:size=3840x2160:rate=30 "
+                     "-c:v mpeg4 -q:v 1 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    OpenOptions mmap_options;
+    mmap_options.use_mmap = true;
+    
+    // 两种IO各读一遍，记录耗时、read系统调用次数和缺页次数
+    int counts[2] = {0, 0};
+    int64_t bytes[2] = {0, 0};
+    for (int use_mmap = 0; use_mmap < 2; use_mmap++) {
+        Demuxer demuxer(MediaType::VIDEO);
+        if (use_mmap) {
+            demuxer.setOpenOptions(mmap_options);
+        }
+        TEST_ASSERT(demuxer.open(test_file), "Should open high bitrate file");
+        TEST_ASSERT(demuxer.isMemoryMapped() == (use_mmap == 1), "Memory mapping should follow the open option");
+        
+        int64_t syscalls_before = readSyscallCount();
+        struct rusage usage_before, usage_after;
+        getrusage(RUSAGE_SELF, &usage_before);
+        auto start = std::chrono::high_resolution_clock::now();
+        TEST_ASSERT(readAllPackets(demuxer, counts[use_mmap], bytes[use_mmap]), "Should read to EOF");
+        auto end = std::chrono::high_resolution_clock::now();
+        getrusage(RUSAGE_SELF, &usage_after);
+        int64_t syscalls = readSyscallCount() - syscalls_before;
+        
+        double seconds = std::chrono::duration<double>(end - start).count();
+        std::cout << (use_mmap ? "mmap IO: " : "default IO: ") << bytes[use_mmap] / (1024.0 * 1024.0) / seconds
+                  << " MB/s, read syscalls: " << syscalls
+                  << ", minor faults: " << usage_after.ru_minflt - usage_before.ru_minflt
+                  << ", major faults: " << usage_after.ru_majflt - usage_before.ru_majflt << std::endl;
+    }
+    TEST_ASSERT(counts[0] == counts[1] && bytes[0] == bytes[1], "Both IO paths should deliver the same packets");
+    
+    // 向后定位之后仍然可以继续读取
+    Demuxer demuxer(MediaType::VIDEO);
+    demuxer.setOpenOptions(mmap_options);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file with mmap IO");
+    int count;
+    int64_t total;
+    TEST_ASSERT(readAllPackets(demuxer, count, total), "Should read to EOF with mmap IO");
+    TEST_ASSERT(demuxer.seek(2000000, AVSEEK_FLAG_BACKWARD), "Should seek backward with mmap IO");
+    PacketPtr packet = makePacket();
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read after backward seek");
+    
+    demuxer.close();
+    TEST_ASSERT(!demuxer.isMemoryMapped(), "Mapping should be released on close");
+    
+    // 访问模式：小范围回退不改变，大幅向后跳转只是暂时改为随机访问
+    MmapIO io;
+    TEST_ASSERT(io.open(test_file), "Should map the test file directly");
+    if (io.size() > 24 * 1024 * 1024) {
+        AVIOContext* avio = io.getAVIOContext();
+        std::vector<unsigned char> buffer(1024 * 1024);
+        auto read_forward = [&](int64_t bytes) {
+            for (int64_t done = 0; done < bytes; done += static_cast<int64_t>(buffer.size())) {
+                avio_read(avio, buffer.data(), static_cast<int>(buffer.size()));
+            }
+        };
+        read_forward(16 * 1024 * 1024);
+        TEST_ASSERT(!io.isRandomAccess(), "Sequential reading should use sequential hints");
+        // 回退超过AVIOContext的缓冲区，但仍然很小
+        TEST_ASSERT(avio_seek(avio, avio_tell(avio) - 512 * 1024, SEEK_SET) >= 0, "Should seek back a little");
+        read_forward(1024 * 1024);
+        TEST_ASSERT(!io.isRandomAccess(), "Small backward seek should not switch to random access");
+        TEST_ASSERT(avio_seek(avio, 2 * 1024 * 1024, SEEK_SET) >= 0, "Should jump far back");
+        TEST_ASSERT(io.isRandomAccess(), "Large backward jump should switch to random access");
+        read_forward(4 * 1024 * 1024);
+        TEST_ASSERT(!io.isRandomAccess(), "Reading forward after the jump should restore sequential hints");
+    } else {
+        std::cout << "WARNING: Test file too small for the access pattern check" << std::endl;
+    }
+    io.close();
+    
+    // 读取过程中文件被截短（例如ffmpeg -y覆盖同一个路径），读到新的结尾返回EOF而不是访问已经不存在的页
+    TEST_ASSERT(io.open(test_file), "Should map the test file again");
+    {
+        AVIOContext* avio = io.getAVIOContext();
+        std::vector<unsigned char> chunk(64 * 1024);
+        int64_t total_read = avio_read(avio, chunk.data(), static_cast<int>(chunk.size()));
+        TEST_ASSERT(total_read == static_cast<int64_t>(chunk.size()), "Should read before truncation");
+        int64_t cut = io.size() / 2;
+        TEST_ASSERT(truncate(test_file.c_str(), cut) == 0, "Should truncate the mapped file");
+        int ret;
+        while ((ret = avio_read(avio, chunk.data(), static_cast<int>(chunk.size()))) > 0) {
+            total_read += ret;
+        }
+        TEST_ASSERT(total_read == cut, "Reading should stop at the truncated size");
+        TEST_ASSERT(avio_size(avio) == cut, "Size should follow the truncated file");
+    }
+    io.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试21: io_uring预读IO，与默认文件协议对比不同队列深度下的吞吐量
+bool testUringIO() {
+    const std::string test_file = "test_uring_io.mp4";
+    
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=5:size=1920x1080:rate=30 "
+                     "-c:v mpeg4 -q:v 1 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 默认文件协议作为对照
+    int expected_count;
+    int64_t expected_bytes;
+    {
+        Demuxer demuxer(MediaType::VIDEO);
+        TEST_ASSERT(demuxer.open(test_file), "Should open file with default IO");
+        auto start = std::chrono::high_resolution_clock::now();
+        TEST_ASSERT(readAllPackets(demuxer, expected_count, expected_bytes), "Should read to EOF with default IO");
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "default IO: " << expected_bytes / (1024.0 * 1024.0) / seconds << " MB/s" << std::endl;
+    }
+    
+    for (int depth = 1; depth <= 64; depth *= 2) {
+        Demuxer demuxer(MediaType::VIDEO);
+        OpenOptions options;
+        options.use_uring = true;
+        options.uring_queue_depth = depth;
+        demuxer.setOpenOptions(options);
+        TEST_ASSERT(demuxer.open(test_file), "Should open file with io_uring IO");
+        
+        int count;
+        int64_t bytes;
+        int64_t syscalls_before = readSyscallCount();
+        auto start = std::chrono::high_resolution_clock::now();
+        TEST_ASSERT(readAllPackets(demuxer, count, bytes), "Should read to EOF with io_uring IO");
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        TEST_ASSERT(count == expected_count && bytes == expected_bytes, "io_uring IO should deliver the same packets");
+        std::cout << (demuxer.isUringIO() ? "io_uring" : "pread fallback") << " depth " << depth << ": "
+                  << bytes / (1024.0 * 1024.0) / seconds << " MB/s, read syscalls: "
+                  << readSyscallCount() - syscalls_before << std::endl;
+        
+        // 定位之后旧位置的预读请求作废，仍然能读到正确的数据
+        TEST_ASSERT(demuxer.seek(1000000, AVSEEK_FLAG_BACKWARD), "Should seek with io_uring IO");
+        PacketPtr packet = makePacket();
+        TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read after seek with io_uring IO");
+    }
+    
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试22: 包结构体缓冲池
+bool testPacketPool() {
+    const std::string test_file = "test_packet_pool.mp4";
+    
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    auto checksum = [](const AVPacket *packet) {
+        uint32_t sum = 0;
+        for (int i = 0; i < packet->size; i++) {
+            sum = sum * 31 + packet->data[i];
+        }
+        return sum;
+    };
+    
+    // 不使用缓冲池读出的数据作为对照
+    std::vector<uint32_t> expected;
+    {
+        Demuxer demuxer;
+        TEST_ASSERT(demuxer.open(test_file), "Should open file without pool");
+        PacketPtr packet = makePacket();
+        while (demuxer.readPacket(packet.get())) {
+            expected.push_back(checksum(packet.get()));
+        }
+    }
+    
+    // 预读队列从池中取结构体，第二遍读取时全部复用第一遍放回的结构体
+    PacketPool pool;
+    Demuxer demuxer;
+    demuxer.setPacketPool(&pool);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file with pool");
+    PacketPtr packet = makePacket();
+    for (int pass = 0; pass < 2; pass++) {
+        TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+        TEST_ASSERT(demuxer.startReadAhead(), "Should start read-ahead with pool");
+        size_t index = 0;
+        bool same = true;
+        while (demuxer.readPacket(packet.get())) {
+            same = same && index < expected.size() && expected[index] == checksum(packet.get());
+            index++;
+        }
+        demuxer.stopReadAhead();
+        TEST_ASSERT(same && index == expected.size(), "Packets read through the pool should carry the same data");
+    }
+    PacketPoolStats stats = pool.getStats();
+    std::cout << "pool: " << stats.requests << " requests, hit rate " << stats.hitRate() << ", resident "
+              << stats.bytes_resident << " bytes, high water " << stats.high_water_bytes << " bytes" << std::endl;
+    TEST_ASSERT(stats.requests >= static_cast<int64_t>(expected.size()) * 2, "Every queued packet should come from the pool");
+    TEST_ASSERT(stats.hitRate() > 0.5, "Released packets should be reused");
+    TEST_ASSERT(stats.bytes_resident > 0 && stats.bytes_resident <= stats.high_water_bytes, "Idle packets should stay in the pool");
+    
+    // 多流模式按类型读取时，暂存队列也从池中取结构体
+    PacketPoolStats before = pool.getStats();
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start for typed reads");
+    int typed = 0;
+    while (demuxer.readPacket(MediaType::VIDEO, packet.get())) {
+        typed++;
+    }
+    PacketPoolStats after = pool.getStats();
+    TEST_ASSERT(typed > 0, "Should read video packets with pool");
+    TEST_ASSERT(after.hits > before.hits, "Pending packets should reuse pooled packets");
+    demuxer.close();
+    
+    // 内存上限很小时，放不下的结构体直接释放
+    const int64_t cap = 16 * static_cast<int64_t>(sizeof(AVPacket));
+    PacketPool small_pool(cap);
+    {
+        Demuxer capped_demuxer;
+        capped_demuxer.setPacketPool(&small_pool);
+        TEST_ASSERT(capped_demuxer.open(test_file), "Should open file with capped pool");
+        TEST_ASSERT(capped_demuxer.startReadAhead(), "Should start read-ahead with capped pool");
+        while (capped_demuxer.readPacket(packet.get())) {
+        }
+        capped_demuxer.close();
+    }
+    PacketPoolStats capped = small_pool.getStats();
+    TEST_ASSERT(capped.bytes_resident <= cap && capped.high_water_bytes <= cap, "Pool should respect its memory cap");
+    TEST_ASSERT(capped.bypassed > 0, "Packets beyond the cap should be freed");
+    
+    // 返回给调用者的包不来自缓冲池，可以比缓冲池和Demuxer活得更久
+    {
+        PacketPool short_pool;
+        Demuxer short_demuxer;
+        short_demuxer.setPacketPool(&short_pool);
+        TEST_ASSERT(short_demuxer.open(test_file), "Should open file with short-lived pool");
+        TEST_ASSERT(short_demuxer.startReadAhead(), "Should start read-ahead with short-lived pool");
+        packet = short_demuxer.readPacketPtr();
+        TEST_ASSERT(packet != nullptr, "Should read packet from short-lived pool");
+    }
+    packet.reset();
+    
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试23: 批量读取
+bool testReadPackets() {
+    const std::string test_file = "test_read_packets.mp4";
+    
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 逐个读取的结果作为对照
+    std::vector<int64_t> expected;
+    {
+        Demuxer demuxer;
+        TEST_ASSERT(demuxer.open(test_file), "Should open file for single reads");
+        PacketPtr packet = makePacket();
+        while (demuxer.readPacket(packet.get())) {
+            expected.push_back(static_cast<int64_t>(packet->stream_index) << 48 | (packet->dts & 0xffffffffffff));
+        }
+    }
+    
+    const int max_batch = 128;
+    std::vector<PacketPtr> holders;
+    std::vector<AVPacket*> packets;
+    for (int i = 0; i < max_batch; i++) {
+        holders.push_back(makePacket());
+        packets.push_back(holders.back().get());
+    }
+    
+    // 批量读取得到同样的包序列
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for batched reads");
+    std::vector<int64_t> batched;
+    int count;
+    while ((count = demuxer.readPackets(packets.data(), 8)) > 0) {
+        TEST_ASSERT(count <= 8, "Batch should not exceed max_count");
+        for (int i = 0; i < count; i++) {
+            batched.push_back(static_cast<int64_t>(packets[i]->stream_index) << 48 | (packets[i]->dts & 0xffffffffffff));
+        }
+    }
+    TEST_ASSERT(demuxer.isEOF(), "Empty batch should mean EOF");
+    TEST_ASSERT(batched == expected, "Batched reads should return the same packets in order");
+    
+    // 字节上限：至少返回一个包，超过上限后停止
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+    count = demuxer.readPackets(packets.data(), max_batch, 1);
+    TEST_ASSERT(count == 1, "Byte limit should stop the batch after the first packet");
+    
+    // 按类型的批量读取，每种类型内部按时间顺序
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+    int video_count = demuxer.readPackets(MediaType::VIDEO, packets.data(), 32);
+    TEST_ASSERT(video_count == 32, "Should read a full video batch");
+    bool video_only = true;
+    for (int i = 0; i < video_count; i++) {
+        video_only = video_only && packets[i]->stream_index == demuxer.getStreamIndex(MediaType::VIDEO);
+    }
+    TEST_ASSERT(video_only, "Typed batch should only contain video packets");
+    int audio_count = demuxer.readPackets(MediaType::AUDIO, packets.data(), 32);
+    TEST_ASSERT(audio_count > 0, "Audio packets read alongside video should be served from the pending queue");
+    bool ordered = true;
+    for (int i = 1; i < audio_count; i++) {
+        ordered = ordered && packets[i]->dts > packets[i - 1]->dts;
+    }
+    TEST_ASSERT(ordered, "Typed batch should keep timestamp order");
+    
+    // 不同批量大小下每个包的平均开销
+    for (int batch : {1, 8, 32, 128}) {
+        const int rounds = 5;
+        int64_t total = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+            while ((count = demuxer.readPackets(packets.data(), batch)) > 0) {
+                total += count;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        std::cout << "batch " << batch << ": " << total << " packets, " << ns / std::max<int64_t>(total, 1)
+                  << " ns/packet" << std::endl;
+    }
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试24: 热路径统计
+bool testDemuxMetrics() {
+    const std::string test_file = "test_metrics.mp4";
+    
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for metrics");
+    
+    // 另一个线程一直无锁地轮询快照
+    std::atomic<bool> done(false);
+    std::atomic<bool> monotonic(true);
+    std::thread poller([&]() {
+        int64_t last = 0;
+        while (!done) {
+            DemuxMetricsSnapshot snapshot = demuxer.getMetrics();
+            if (snapshot.packets_read < last) {
+                monotonic = false;
+            }
+            last = snapshot.packets_read;
+        }
+    });
+    
+    PacketPtr packet = makePacket();
+    int count = 0;
+    while (demuxer.readPacket(packet.get())) {
+        count++;
+    }
+    TEST_ASSERT(demuxer.seek(1000000, AVSEEK_FLAG_BACKWARD), "Should seek");
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek again");
+    done = true;
+    poller.join();
+    TEST_ASSERT(monotonic, "Counters polled from another thread should only grow");
+    
+    DemuxMetricsSnapshot metrics = demuxer.getMetrics();
+    TEST_ASSERT(metrics.packets_delivered == count, "Delivered packets should match returned packets");
+    TEST_ASSERT(metrics.packets_read == metrics.packets_delivered + metrics.packets_discarded,
+               "Every read packet should be delivered or discarded");
+    TEST_ASSERT(metrics.read_latency.count >= metrics.packets_read, "Every read should be timed");
+    TEST_ASSERT(metrics.seek_latency.count == 2, "Both seeks should be counted");
+    int video_index = demuxer.getStreamIndex();
+    TEST_ASSERT(metrics.streams[video_index].packets_read == count, "Per-stream counters should track the video stream");
+    TEST_ASSERT(metrics.read_latency.percentileNs(0.5) <= metrics.read_latency.percentileNs(0.99),
+               "Percentiles should be ordered");
+    std::cout << "read " << metrics.packets_read << " packets / " << metrics.bytes_read << " bytes, discard ratio "
+              << metrics.discardRatio() << ", blocked in read " << metrics.read_latency.total_ns / 1000
+              << "us, read p50/p99 " << metrics.read_latency.percentileNs(0.5) << "/"
+              << metrics.read_latency.percentileNs(0.99) << "ns, seek mean " << metrics.seek_latency.meanNs() << "ns"
+              << std::endl;
+    
+    // 记录本身的开销
+    DemuxMetrics recorder;
+    const int iterations = 1000000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        recorder.recordDelivered(i & 0xfff);
+        recorder.recordDiscarded(i & 3, i & 0xfff);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    TEST_ASSERT(recorder.snapshot().packets_delivered == iterations, "Recorder should count every call");
+    std::cout << "metrics recording: " << static_cast<double>(ns) / (2 * iterations) << " ns/record" << std::endl;
+    
+    demuxer.close();
+    TEST_ASSERT(demuxer.getMetrics().packets_read == 0, "Metrics should reset on close");
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 在本地端口上提供文件的前一部分数据，然后一直停住，模拟卡住的网络读取
+class StallingServer {
+public:
+    bool start(const std::string& filename, double fraction) {
+        std::ifstream file(filename, std::ios::binary);
+        data_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        data_.resize(static_cast<size_t>(data_.size() * fraction));
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_fd_, 1) != 0 || getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port_ = ntohs(addr.sin_port);
+        thread_ = std::thread([this]() {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            size_t sent = 0;
+            while (sent < data_.size()) {
+                ssize_t ret = send(fd, data_.data() + sent, data_.size() - sent, MSG_NOSIGNAL);
+                if (ret <= 0) {
+                    break;
+                }
+                sent += ret;
+            }
+            while (!stop_) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            ::close(fd);
+        });
+        return true;
+    }
+
+    void stop() {
+        stop_ = true;
+        shutdown(listen_fd_, SHUT_RDWR); // 没有连接时让accept返回
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        ::close(listen_fd_);
+    }
+
+    std::string url() const { return "tcp://127.0.0.1:" + std::to_string(port_); }
+
+private:
+    std::vector<char> data_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+// 测试25: close()打断阻塞的读取，IO截止时间
+bool testInterruptibleIO() {
+    const std::string test_file = "test_interrupt.ts";
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=5:size=320x240:rate=30 "
+                     "-c:v libx264 -f mpegts -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    OpenOptions options;
+    options.fast_open = true;
+    
+    // 读取卡住之后，另一个线程的close()应该在有限时间内打断它
+    {
+        StallingServer server;
+        TEST_ASSERT(server.start(test_file, 0.6), "Should start stalling server");
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setOpenOptions(options);
+        TEST_ASSERT(demuxer.open(server.url()), "Should open stream over tcp");
+        
+        std::atomic<bool> reader_done(false);
+        DemuxStatus reader_status = DemuxStatus::OK;
+        std::thread reader([&]() {
+            PacketPtr packet = makePacket();
+            while (demuxer.readPacket(packet.get())) {
+            }
+            reader_status = demuxer.getLastStatus();
+            reader_done = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        TEST_ASSERT(!reader_done, "Reader should be blocked on the stalled stream");
+        
+        auto start = std::chrono::steady_clock::now();
+        demuxer.close();
+        auto close_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        reader.join();
+        std::cout << "close() preempted blocked read in " << close_ms << "ms" << std::endl;
+        TEST_ASSERT(close_ms < 1000, "close() should interrupt the blocked read quickly");
+        TEST_ASSERT(reader_status == DemuxStatus::ABORTED, "Interrupted read should report ABORTED");
+        server.stop();
+    }
+    
+    // 不重新定位的切换轨道等读取完成，不打断它
+    {
+        StallingServer server;
+        TEST_ASSERT(server.start(test_file, 0.6), "Should start stalling server");
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setOpenOptions(options);
+        TEST_ASSERT(demuxer.open(server.url()), "Should open stream over tcp");
+        
+        std::atomic<bool> reader_done(false);
+        std::thread reader([&]() {
+            PacketPtr packet = makePacket();
+            while (demuxer.readPacket(packet.get())) {
+            }
+            reader_done = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        std::atomic<bool> switch_done(false);
+        std::thread switcher([&]() {
+            demuxer.selectTrack(MediaType::VIDEO, demuxer.getStreamIndex());
+            switch_done = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        TEST_ASSERT(!reader_done, "Track switch without reseek should not interrupt the blocked read");
+        TEST_ASSERT(!switch_done, "Track switch should wait for the read to finish");
+        demuxer.close();
+        reader.join();
+        switcher.join();
+        TEST_ASSERT(reader_done && switch_done, "close() should release both threads");
+        server.stop();
+    }
+    
+    // 预读模式下消费者阻塞在空队列上，另一个线程的close()停止预读后它拿到ABORTED，不会访问已经释放的队列
+    {
+        StallingServer server;
+        TEST_ASSERT(server.start(test_file, 0.6), "Should start stalling server");
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setOpenOptions(options);
+        TEST_ASSERT(demuxer.open(server.url()), "Should open stream over tcp");
+        TEST_ASSERT(demuxer.startReadAhead(), "Should start read-ahead");
+        
+        std::atomic<bool> reader_done(false);
+        DemuxStatus reader_status = DemuxStatus::OK;
+        std::thread reader([&]() {
+            PacketPtr packet = makePacket();
+            while (demuxer.readPacket(packet.get())) {
+            }
+            reader_status = demuxer.getLastStatus();
+            reader_done = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        TEST_ASSERT(!reader_done, "Reader should be blocked on the empty read-ahead queue");
+        demuxer.close();
+        reader.join();
+        TEST_ASSERT(reader_status == DemuxStatus::ABORTED, "Consumer woken by close() should report ABORTED");
+        TEST_ASSERT(!demuxer.isReadAhead(), "close() should stop read-ahead");
+        server.stop();
+    }
+    
+    // 本地文件上反复让close()和正在读取的消费者竞争，之后还能重新打开并预读
+    for (int round = 0; round < 20; round++) {
+        Demuxer demuxer(MediaType::VIDEO);
+        TEST_ASSERT(demuxer.open(test_file), "Should open local file");
+        TEST_ASSERT(demuxer.startReadAhead(), "Should start read-ahead");
+        std::thread reader([&]() {
+            PacketPtr packet = makePacket();
+            while (demuxer.readPacket(packet.get())) {
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(round % 5));
+        demuxer.close();
+        reader.join();
+        TEST_ASSERT(demuxer.open(test_file) && demuxer.startReadAhead(), "Should reopen and restart read-ahead");
+        PacketPtr packet = makePacket();
+        TEST_ASSERT(demuxer.readPacket(packet.get()), "Restarted read-ahead should deliver packets");
+        demuxer.close();
+    }
+    
+    // 超过截止时间的读取报告TIMEOUT
+    {
+        StallingServer server;
+        TEST_ASSERT(server.start(test_file, 0.6), "Should start stalling server");
+        Demuxer demuxer(MediaType::VIDEO);
+        options.io_timeout_us = 300000;
+        demuxer.setOpenOptions(options);
+        TEST_ASSERT(demuxer.open(server.url()), "Should open stream with io timeout");
+        
+        PacketPtr packet = makePacket();
+        auto start = std::chrono::steady_clock::now();
+        while (demuxer.readPacket(packet.get())) {
+            start = std::chrono::steady_clock::now();
+        }
+        auto stall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        TEST_ASSERT(demuxer.getLastStatus() == DemuxStatus::TIMEOUT, "Stalled read should report TIMEOUT");
+        TEST_ASSERT(!demuxer.isEOF(), "Timeout should not be treated as EOF");
+        TEST_ASSERT(stall_ms < 1500, "Read should give up shortly after the deadline");
+        demuxer.close();
+        server.stop();
+    }
+    
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 模拟拖动进度条：UI线程每隔几毫秒发出一次定位，读包线程持续读取
+// 统计每个请求从发出到读到目标位置的包所用的时间，被后来的请求替换掉的请求不计入
+static void runScrub(Demuxer& demuxer, bool coalesce, std::vector<int64_t>& latencies_us) {
+    struct Request {
+        int64_t target_us;
+        std::chrono::steady_clock::time_point time;
+        int id;
+    };
+    std::mutex request_mutex;
+    Request latest = {0, std::chrono::steady_clock::now(), -1};
+    std::atomic<bool> done(false);
+    
+    std::thread reader([&]() {
+        PacketPtr packet = makePacket();
+        AVStream* stream = demuxer.getAVStream();
+        int satisfied = -1;
+        while (!done) {
+            if (!demuxer.readPacket(packet.get())) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            int64_t pts_us = av_rescale_q(pts, stream->time_base, AV_TIME_BASE_Q);
+            std::lock_guard<std::mutex> lock(request_mutex);
+            if (latest.id > satisfied && pts_us >= latest.target_us && pts_us < latest.target_us + 500000) {
+                satisfied = latest.id;
+                latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - latest.time).count());
+            }
+        }
+    });
+    
+    for (int i = 0; i < 60; i++) {
+        int64_t target = 500000 + i * 120000;
+        {
+            std::lock_guard<std::mutex> lock(request_mutex);
+            latest = {target, std::chrono::steady_clock::now(), i};
+        }
+        if (coalesce) {
+            demuxer.requestSeek(target, AVSEEK_FLAG_BACKWARD);
+        } else {
+            demuxer.seek(target, AVSEEK_FLAG_BACKWARD);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300)); // 等最后一个请求完成
+    done = true;
+    reader.join();
+}
+
+static int64_t medianOf(std::vector<int64_t> values) {
+    if (values.empty()) {
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// 测试26: 定位请求合并
+bool testSeekCoalescing() {
+    const std::string test_file = "test_seek_coalescing.mp4";
+    
+    // 10秒，每秒一个关键帧
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=10:size=320x240:rate=30 "
+                     "-c:v libx264 -g 30 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for seek requests");
+    TEST_ASSERT(demuxer.startIndexing(), "Should start indexing");
+    for (int i = 0; i < 500 && !demuxer.isIndexComplete(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    TEST_ASSERT(demuxer.isIndexComplete(), "Index should complete");
+    AVStream* stream = demuxer.getAVStream();
+    PacketPtr packet = makePacket();
+    
+    // 还没执行的请求被新请求替换，只执行最后一个
+    int serial = demuxer.getSeekSerial();
+    demuxer.requestSeek(2000000, AVSEEK_FLAG_BACKWARD);
+    demuxer.requestSeek(6000000, AVSEEK_FLAG_BACKWARD);
+    TEST_ASSERT(demuxer.hasPendingSeek(), "Requests should stay pending until the next read");
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read after seek request");
+    int64_t pts_us = av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q);
+    TEST_ASSERT(pts_us >= 5000000 && pts_us <= 6000000, "Only the latest request should be executed");
+    TEST_ASSERT(demuxer.getSeekSerial() == serial + 1, "Exactly one container seek should run");
+    SeekRequestStats stats = demuxer.getSeekRequestStats();
+    TEST_ASSERT(stats.requested == 2 && stats.executed == 1 && stats.coalesced == 1, "Stats should count the coalesced request");
+    
+    // 目标在当前GOP中还没读到的位置，直接往后读
+    std::this_thread::sleep_for(std::chrono::milliseconds(60)); // 避开限速
+    demuxer.requestSeek(pts_us + 500000, AVSEEK_FLAG_BACKWARD);
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should keep reading inside the GOP");
+    TEST_ASSERT(demuxer.getSeekSerial() == serial + 1, "Target inside the current GOP should not seek");
+    TEST_ASSERT(demuxer.getSeekRequestStats().skipped_in_gop == 1, "Skipped request should be counted");
+    
+    // 距离上一次定位太近的请求被推迟，之后的读取执行它
+    SeekRequestOptions options;
+    options.min_interval_us = 200000;
+    demuxer.setSeekRequestOptions(options);
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek directly");
+    demuxer.requestSeek(8000000, AVSEEK_FLAG_BACKWARD);
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read while the request is deferred");
+    TEST_ASSERT(demuxer.hasPendingSeek(), "Rate-limited request should stay pending");
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read after the rate limit");
+    TEST_ASSERT(!demuxer.hasPendingSeek(), "Deferred request should run once the interval has passed");
+    pts_us = av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q);
+    TEST_ASSERT(pts_us >= 7000000 && pts_us <= 8000000, "Deferred request should land near its target");
+    TEST_ASSERT(demuxer.getSeekRequestStats().deferred == 1, "Deferred request should be counted");
+    
+    // 拖动进度条的对比
+    std::vector<int64_t> direct_latencies;
+    int direct_start = demuxer.getSeekSerial();
+    runScrub(demuxer, false, direct_latencies);
+    int direct_executed = demuxer.getSeekSerial() - direct_start;
+    
+    demuxer.setSeekRequestOptions(SeekRequestOptions());
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should rewind before coalesced scrub");
+    SeekRequestStats before = demuxer.getSeekRequestStats();
+    std::vector<int64_t> coalesced_latencies;
+    runScrub(demuxer, true, coalesced_latencies);
+    SeekRequestStats after = demuxer.getSeekRequestStats();
+    
+    std::cout << "direct seek(): 60 requested, " << direct_executed << " executed, median time to target "
+              << medianOf(direct_latencies) << "us (" << direct_latencies.size() << " reached)" << std::endl;
+    std::cout << "requestSeek(): " << after.requested - before.requested << " requested, "
+              << after.executed - before.executed << " executed, " << after.skipped_in_gop - before.skipped_in_gop
+              << " skipped in GOP, median time to target " << medianOf(coalesced_latencies) << "us ("
+              << coalesced_latencies.size() << " reached)" << std::endl;
+    TEST_ASSERT(after.executed - before.executed < after.requested - before.requested,
+               "Coalescing should execute fewer container seeks than requested");
+    TEST_ASSERT(!coalesced_latencies.empty(), "Scrubbing should reach the targets");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+static int64_t percentileOf(std::vector<int64_t> values, double p) {
+    if (values.empty()) {
+        return -1;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+// Y平面的简单校验和，用来比较两种方式解出的帧是否一致
+static uint64_t lumaChecksum(const AVFrame* frame) {
+    uint64_t sum = 0;
+    for (int y = 0; y < frame->height; y++) {
+        const uint8_t* row = frame->data[0] + static_cast<int64_t>(y) * frame->linesize[0];
+        for (int x = 0; x < frame->width; x++) {
+            sum = sum * 31 + row[x];
+        }
+    }
+    return sum;
+}
+
+// 断言提前返回时也要释放帧
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+
+// 对一个文件做一组随机的精确定位，检查返回的帧覆盖目标时间，输出延迟分位数
+static bool runAccurateSeeks(const std::string& label, const std::string& file, const AccurateSeekOptions& options,
+                             const std::vector<int64_t>& targets, std::vector<uint64_t>& checksums) {
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(file), "Should open " + label + " file");
+    AccurateSeeker seeker(demuxer);
+    TEST_ASSERT(seeker.open(options), "Should open accurate seeker for " + label);
+    
+    FramePtr frame(av_frame_alloc());
+    TEST_ASSERT(frame, "Should allocate frame");
+    const int64_t frame_us = 1000000 / 30;
+    std::vector<int64_t> latencies;
+    int64_t decoded = 0;
+    int64_t discarded = 0;
+    bool exact = true;
+    checksums.clear();
+    for (int64_t target : targets) {
+        if (!seeker.seek(target, frame.get())) {
+            exact = false;
+            break;
+        }
+        const AccurateSeekStats& stats = seeker.getLastStats();
+        // 返回的帧的显示区间要包含目标时间
+        if (stats.frame_pts > target || stats.frame_pts + frame_us <= target) {
+            std::cerr << label << ": target " << target << "us got frame " << stats.frame_pts << "us" << std::endl;
+            exact = false;
+        }
+        latencies.push_back(stats.total_us);
+        decoded += stats.frames_decoded;
+        discarded += stats.frames_discarded;
+        checksums.push_back(lumaChecksum(frame.get()));
+    }
+    TEST_ASSERT(exact, label + " seeks should land on the exact frame");
+    
+    std::cout << label << ": " << targets.size() << " seeks, p50 " << percentileOf(latencies, 0.5) << "us, p90 "
+              << percentileOf(latencies, 0.9) << "us, p99 " << percentileOf(latencies, 0.99) << "us, "
+              << decoded / static_cast<int64_t>(targets.size()) << " frames decoded and "
+              << discarded / static_cast<int64_t>(targets.size()) << " discarded per seek" << std::endl;
+    return true;
+}
+
+// 测试27: 精确定位
+bool testAccurateSeek() {
+    const std::string long_gop_file = "test_accurate_seek_long_gop.mp4";
+    const std::string intra_file = "test_accurate_seek_intra.mp4";
+    
+    // 10秒30帧，长GOP（250帧一个关键帧，带B帧）和全关键帧各一个
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=10:size=640x360:rate=30 "
+                     "-c:v libx264 -g 250 -bf 3 -y " + long_gop_file + " 2>/dev/null";
+    std::string intra_cmd = "ffmpeg -f lavfi -i testsrc=duration=10:size=640x360:rate=30 "
+                           "-c:v libx264 -g 1 -y " + intra_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0 || std::system(intra_cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        std::remove(long_gop_file.c_str());
+        std::remove(intra_file.c_str());
+        return true;
+    }
+    
+    // 固定种子的随机目标，避开整帧边界
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int64_t> distribution(0, 9900000);
+    std::vector<int64_t> targets;
+    for (int i = 0; i < 40; i++) {
+        targets.push_back(distribution(rng));
+    }
+    
+    AccurateSeekOptions fast;
+    AccurateSeekOptions full;
+    full.skip_nonref = false;
+    full.skip_loop_filter = false;
+    std::vector<uint64_t> fast_checksums;
+    std::vector<uint64_t> full_checksums;
+    bool ok = runAccurateSeeks("long GOP, skipping", long_gop_file, fast, targets, fast_checksums) &&
+              runAccurateSeeks("long GOP, full decode", long_gop_file, full, targets, full_checksums);
+    // 只跳过非参考帧，目标帧的内容不受影响
+    bool same_frames = !ok || fast_checksums == full_checksums;
+    if (ok && same_frames) {
+        ok = runAccurateSeeks("all-intra", intra_file, fast, targets, fast_checksums);
+    }
+    
+    // 目标超出最后一帧时返回最后一帧
+    bool sought = true;
+    int64_t last_pts = INT64_MAX;
+    if (ok && same_frames) {
+        Demuxer demuxer(MediaType::VIDEO);
+        AccurateSeeker seeker(demuxer);
+        FramePtr frame(av_frame_alloc());
+        sought = frame && demuxer.open(long_gop_file) && seeker.open() && seeker.seek(60000000, frame.get());
+        last_pts = seeker.getLastStats().frame_pts;
+    }
+    
+    // 断言失败提前返回之前删掉测试文件
+    std::remove(long_gop_file.c_str());
+    std::remove(intra_file.c_str());
+    TEST_ASSERT(same_frames, "Skipping non-reference frames should not change the target frame");
+    TEST_ASSERT(sought, "Seeking past the end should return the last frame");
+    TEST_ASSERT(last_pts >= 9900000, "Last frame should be near the end");
+    return ok;
+}
+
+// 测试28: 并行缩略图提取
+bool testThumbnailEngine() {
+    const std::string test_file = "test_thumbnails.mp4";
+    
+    // 60秒，每2秒一个关键帧
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=60:size=640x360:rate=30 "
+                     "-c:v libx264 -preset ultrafast -g 60 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    ThumbnailOptions options;
+    options.count = 60;
+    options.thumb_width = 128;
+    options.columns = 10;
+    options.threads = 1;
+    ThumbnailEngine serial_engine(options);
+    SpriteSheet serial_sheet;
+    TEST_ASSERT(serial_engine.generate(test_file, serial_sheet), "Serial extraction should succeed");
+    ThumbnailStats serial_stats = serial_engine.getLastStats();
+    TEST_ASSERT(serial_stats.failed == 0, "No thumbnail should fail");
+    TEST_ASSERT(serial_stats.extracted + serial_stats.reused == options.count, "Every thumbnail should be filled");
+    TEST_ASSERT(serial_sheet.thumb_height == 72, "Height should follow the aspect ratio");
+    TEST_ASSERT(serial_sheet.rows == 6 && serial_sheet.pixels.size() == static_cast<size_t>(6 * 72 * 10 * 128 * 4),
+               "Sprite sheet should be preallocated for all cells");
+    
+    // 每张缩略图都使用目标之前最近的关键帧，关键帧每2秒一个
+    bool nearest = true;
+    for (int i = 0; i < options.count; i++) {
+        int64_t target = 60000000LL * (2 * i + 1) / (2 * options.count);
+        int64_t keyframe = serial_sheet.timestamps[i];
+        if (keyframe == AV_NOPTS_VALUE || keyframe > target || target - keyframe >= 2000000) {
+            nearest = false;
+        }
+    }
+    TEST_ASSERT(nearest, "Each thumbnail should come from the nearest preceding keyframe");
+    
+    // 多线程的结果与单线程完全一致
+    int hardware_threads = std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+    options.threads = hardware_threads;
+    ThumbnailEngine parallel_engine(options);
+    SpriteSheet parallel_sheet;
+    TEST_ASSERT(parallel_engine.generate(test_file, parallel_sheet), "Parallel extraction should succeed");
+    ThumbnailStats parallel_stats = parallel_engine.getLastStats();
+    TEST_ASSERT(parallel_stats.threads == std::min(hardware_threads, options.count), "Should use the requested threads");
+    TEST_ASSERT(parallel_sheet.pixels == serial_sheet.pixels, "Parallel sprite sheet should match the serial one");
+    TEST_ASSERT(parallel_sheet.timestamps == serial_sheet.timestamps, "Parallel timestamps should match the serial ones");
+    
+    std::cout << "1 thread: " << serial_stats.total_us << "us, " << parallel_stats.threads << " threads: "
+              << parallel_stats.total_us << "us, speedup " << static_cast<double>(serial_stats.total_us) / parallel_stats.total_us
+              << "x (" << parallel_stats.extracted << " decoded, " << parallel_stats.reused << " reused, lowres "
+              << parallel_stats.lowres << ")" << std::endl;
+    
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试29: 分段并行扫描
+bool testSegmentScanner() {
+    const std::string test_file = "test_segment_scan.mp4";
+    
+    // 30秒音视频，每秒一个关键帧
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=30:size=320x240:rate=30 "
+                     "-f lavfi -i sine=frequency=1000:duration=30 "
+                     "-c:v libx264 -preset ultrafast -g 30 -c:a aac -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    ScanOptions sequential_options;
+    sequential_options.mode = ScanMode::SEQUENTIAL;
+    SegmentScanner sequential(sequential_options);
+    ScanResult expected;
+    TEST_ASSERT(sequential.scan(test_file, expected), "Sequential scan should succeed");
+    TEST_ASSERT(!expected.parallel && expected.segments == 1, "Sequential scan should use one segment");
+    TEST_ASSERT(expected.keyframes.size() == 30, "Should find one keyframe per second");
+    TEST_ASSERT(expected.dts_errors == 0 && expected.corrupt_packets == 0, "Clean file should pass integrity checks");
+    TEST_ASSERT(expected.bitrate_bytes.size() >= 30, "Bitrate graph should cover the whole file");
+    
+    // 并行扫描的合并结果与顺序扫描完全一致
+    ScanOptions parallel_options;
+    parallel_options.mode = ScanMode::PARALLEL;
+    parallel_options.threads = 4;
+    SegmentScanner parallel(parallel_options);
+    std::vector<int64_t> visited(64, 0);
+    parallel.setVisitor([&](int segment, const AVPacket*) {
+        visited[segment]++; // 每段只在一个线程中回调
+    });
+    ScanResult result;
+    std::vector<ScanSegmentResult> segments;
+    TEST_ASSERT(parallel.scan(test_file, result, &segments), "Parallel scan should succeed");
+    TEST_ASSERT(result.parallel && result.segments > 1 && result.segments <= 16, "Parallel scan should use several segments");
+    TEST_ASSERT(result.packets == expected.packets && result.bytes == expected.bytes, "Every packet should be counted exactly once");
+    TEST_ASSERT(result.dts_errors == 0, "Segment boundaries should keep timestamps increasing");
+    TEST_ASSERT(result.bitrate_bytes == expected.bitrate_bytes, "Merged bitrate graph should match the sequential one");
+    bool same_keyframes = result.keyframes.size() == expected.keyframes.size();
+    for (size_t i = 0; same_keyframes && i < result.keyframes.size(); i++) {
+        same_keyframes = result.keyframes[i].pts == expected.keyframes[i].pts && result.keyframes[i].pos == expected.keyframes[i].pos;
+    }
+    TEST_ASSERT(same_keyframes, "Merged keyframes should match the sequential ones in order");
+    int64_t visited_total = 0;
+    for (size_t i = 0; i < segments.size(); i++) {
+        TEST_ASSERT(visited[i] == segments[i].packets, "Visitor should see each segment's packets");
+        visited_total += visited[i];
+    }
+    TEST_ASSERT(visited_total == expected.packets, "Visitor should see every packet once");
+    
+    bool rotational = false;
+    bool known = SegmentScanner::isRotationalStorage(test_file, rotational);
+    std::cout << "sequential: " << expected.total_us << "us, parallel: " << result.total_us << "us on " << result.threads
+              << " threads, " << result.segments << " segments (partition " << result.partition_us << "us), storage "
+              << (known ? (rotational ? "rotational" : "non-rotational") : "unknown") << std::endl;
+    
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试30: 已打开上下文的缓存
+bool testDemuxerPool() {
+    const std::string test_file = "test_demuxer_pool.mp4";
+    
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 不使用缓存时第一个包的内容，用来确认缓存的上下文回到了文件开头
+    Demuxer reference(MediaType::VIDEO);
+    TEST_ASSERT(reference.open(test_file), "Should open reference demuxer");
+    PacketPtr first = makePacket();
+    TEST_ASSERT(reference.readPacket(first.get()), "Should read first packet");
+    reference.close();
+    
+    const int rounds = 50;
+    std::vector<int64_t> cold_latencies;
+    for (int i = 0; i < rounds; i++) {
+        Demuxer demuxer(MediaType::VIDEO);
+        TEST_ASSERT(demuxer.open(test_file), "Should open without pool");
+        cold_latencies.push_back(demuxer.getOpenTiming().total_us);
+    }
+    
+    DemuxerPool pool;
+    std::vector<int64_t> warm_latencies;
+    bool rewound = true;
+    {
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setDemuxerPool(&pool);
+        PacketPtr packet = makePacket();
+        for (int i = 0; i < rounds; i++) {
+            TEST_ASSERT(demuxer.open(test_file), "Should open with pool");
+            TEST_ASSERT(demuxer.getOpenTiming().pool_hit == (i > 0), "Only the first open should miss the pool");
+            if (i > 0) {
+                warm_latencies.push_back(demuxer.getOpenTiming().total_us);
+            }
+            // 取出的上下文从文件开头读起
+            if (!demuxer.readPacket(packet.get()) || packet->pts != first->pts || packet->size != first->size) {
+                rewound = false;
+            }
+            // 读到中途关闭，下一次打开之前要回到开头
+            for (int j = 0; j < i % 7; j++) {
+                demuxer.readPacket(packet.get());
+            }
+            demuxer.close();
+        }
+    }
+    TEST_ASSERT(rewound, "Pooled contexts should be handed back rewound");
+    DemuxerPoolStats stats = pool.getStats();
+    TEST_ASSERT(stats.hits == rounds - 1 && stats.misses == 1, "Pool should count hits and misses");
+    TEST_ASSERT(stats.entries == 1 && stats.bytes > 0, "Closed context should stay in the pool");
+    
+    // 同一个文件同时打开两次，两个上下文都可以缓存；数量超过上限时淘汰最旧的
+    {
+        DemuxerPoolOptions options;
+        options.max_entries = 1;
+        pool.setOptions(options);
+        Demuxer a(MediaType::VIDEO);
+        Demuxer b(MediaType::AUDIO);
+        a.setDemuxerPool(&pool);
+        b.setDemuxerPool(&pool);
+        TEST_ASSERT(a.open(test_file) && a.getOpenTiming().pool_hit, "First demuxer should take the pooled context");
+        TEST_ASSERT(b.open(test_file) && !b.getOpenTiming().pool_hit, "Second demuxer should open its own context");
+        TEST_ASSERT(b.getStreamIndex() >= 0, "Audio demuxer should find the audio stream");
+        a.close();
+        b.close();
+        stats = pool.getStats();
+        TEST_ASSERT(stats.entries == 1 && stats.evicted == 1, "Pool should evict beyond max_entries");
+        // 缓存的上下文可以交给另一种类型的Demuxer
+        Demuxer c(MediaType::VIDEO);
+        c.setDemuxerPool(&pool);
+        TEST_ASSERT(c.open(test_file) && c.getOpenTiming().pool_hit, "Pooled context should serve any media type");
+        TEST_ASSERT(c.readPacket(first.get()) && first->stream_index == c.getStreamIndex(), "Should read video from a pooled context");
+    }
+    
+    // 文件被修改后缓存的上下文不再使用
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=2:size=160x120:rate=30 -c:v libx264 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) == 0) {
+        Demuxer demuxer(MediaType::VIDEO);
+        demuxer.setDemuxerPool(&pool);
+        TEST_ASSERT(demuxer.open(test_file) && !demuxer.getOpenTiming().pool_hit, "Modified file should not use the stale context");
+        TEST_ASSERT(pool.getStats().stale == 1, "Stale context should be counted");
+        TEST_ASSERT(demuxer.getDuration() < 3000000, "Reopened file should have the new duration");
+    }
+    
+    // 打开选项不同的上下文不能复用：探测预算和自定义IO都是打开时决定的
+    {
+        OpenOptions mmap_options;
+        mmap_options.use_mmap = true;
+        Demuxer mapped(MediaType::VIDEO);
+        mapped.setDemuxerPool(&pool);
+        mapped.setOpenOptions(mmap_options);
+        TEST_ASSERT(mapped.open(test_file) && !mapped.getOpenTiming().pool_hit,
+                   "Context opened with other options should not be reused");
+        mapped.close();
+        TEST_ASSERT(mapped.open(test_file) && mapped.getOpenTiming().pool_hit, "Same options should reuse the context");
+        // 打开之后修改选项不改变放回缓存的上下文对应的选项
+        mapped.setOpenOptions(OpenOptions());
+        mapped.close();
+        mapped.setOpenOptions(mmap_options);
+        TEST_ASSERT(mapped.open(test_file) && mapped.getOpenTiming().pool_hit,
+                   "Context should be pooled under the options it was opened with");
+        mapped.close();
+        Demuxer plain(MediaType::VIDEO);
+        plain.setDemuxerPool(&pool);
+        TEST_ASSERT(plain.open(test_file) && !plain.getOpenTiming().pool_hit,
+                   "Default options should not take the memory-mapped context");
+    }
+    
+    std::cout << "reopen latency: cold median " << medianOf(cold_latencies) << "us, p99 "
+              << percentileOf(cold_latencies, 0.99) << "us; pooled median " << medianOf(warm_latencies) << "us, p99 "
+              << percentileOf(warm_latencies, 0.99) << "us; hit rate " << pool.getStats().hitRate() << std::endl;
+    
+    pool.clear();
+    TEST_ASSERT(pool.getStats().entries == 0, "Clear should close pooled contexts");
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试31: 运行时切换轨道
+bool testTrackSwitching() {
+    const std::string test_file = "test_tracks.mp4";
+    
+    // 一条视频和两条不同语言的音轨
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=6:size=320x240:rate=30 "
+                     "-f lavfi -i sine=frequency=440:duration=6 -f lavfi -i sine=frequency=880:duration=6 "
+                     "-map 0 -map 1 -map 2 -c:v libx264 -c:a aac "
+                     "-metadata:s:a:0 language=eng -metadata:s:a:1 language=jpn -metadata:s:a:1 title=Commentary "
+                     "-y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(test_file), "Should open file with two audio tracks");
+    std::vector<TrackInfo> tracks = demuxer.getTracks();
+    TEST_ASSERT(tracks.size() == 3, "Should list all tracks");
+    TEST_ASSERT(tracks[0].codec_type == AVMEDIA_TYPE_VIDEO && tracks[0].codec_name == "h264" && tracks[0].width == 320,
+               "Video track metadata should be listed");
+    TEST_ASSERT(tracks[1].language == "eng" && tracks[1].selected, "First audio track should be selected by default");
+    TEST_ASSERT(tracks[2].language == "jpn" && tracks[2].title == "Commentary" && !tracks[2].selected,
+               "Second audio track should be listed but not selected");
+    TEST_ASSERT(tracks[2].sample_rate > 0 && tracks[2].channels > 0 && tracks[2].codec_name == "aac",
+               "Audio track metadata should be listed");
+    int jpn = demuxer.findTrack(MediaType::AUDIO, "jpn");
+    TEST_ASSERT(jpn == 2, "Should find the track by language");
+    TEST_ASSERT(demuxer.findTrack(MediaType::AUDIO, "fra") == -1, "Missing language should not be found");
+    TEST_ASSERT(demuxer.getDiscardStats().streams_discarded == 1, "Unselected audio track should be discarded");
+    
+    // 读大约两秒的音频
+    AVStream* old_stream = demuxer.getAVStream(MediaType::AUDIO);
+    PacketPtr packet = makePacket();
+    int64_t last_us = 0;
+    while (last_us < 2000000 && demuxer.readPacket(MediaType::AUDIO, packet.get())) {
+        TEST_ASSERT(packet->stream_index == 1, "Should read the default audio track");
+        last_us = av_rescale_q(packet->pts, old_stream->time_base, AV_TIME_BASE_Q);
+    }
+    
+    // 非法的切换
+    TEST_ASSERT(!demuxer.selectTrack(MediaType::AUDIO, 0), "Video stream is not an audio track");
+    TEST_ASSERT(!demuxer.selectTrack(MediaType::VIDEO, 1), "Audio stream is not a video track");
+    TEST_ASSERT(!demuxer.selectTrack(MediaType::AUDIO, 9), "Out-of-range stream should be rejected");
+    
+    // 切换后新音轨从当前位置接着输出，不需要定位
+    int serial = demuxer.getSeekSerial();
+    auto switch_start = std::chrono::steady_clock::now();
+    TEST_ASSERT(demuxer.selectTrack(MediaType::AUDIO, jpn), "Should switch audio track");
+    int64_t switch_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - switch_start).count();
+    TEST_ASSERT(demuxer.getSeekSerial() == serial, "Switching should not seek");
+    TEST_ASSERT(demuxer.getStreamIndex(MediaType::AUDIO) == jpn, "Audio stream index should follow the switch");
+    TEST_ASSERT(demuxer.getDiscardStats().streams_discarded == 1, "Old audio track should now be discarded");
+    TEST_ASSERT(demuxer.getTracks()[2].selected && !demuxer.getTracks()[1].selected, "Selection flags should update");
+    TEST_ASSERT(demuxer.readPacket(MediaType::AUDIO, packet.get()), "Should read from the new track");
+    AVStream* new_stream = demuxer.getAVStream(MediaType::AUDIO);
+    int64_t resumed_us = av_rescale_q(packet->pts, new_stream->time_base, AV_TIME_BASE_Q);
+    TEST_ASSERT(packet->stream_index == jpn, "Packets should come from the new track");
+    TEST_ASSERT(resumed_us > last_us - 1000000 && resumed_us < last_us + 1000000,
+               "New track should resume near the current position");
+    TEST_ASSERT(demuxer.readPacket(MediaType::VIDEO, packet.get()), "Video should keep flowing after the switch");
+    
+    // 要求定位时回到当前位置
+    TEST_ASSERT(demuxer.selectTrack(MediaType::AUDIO, 1, true), "Should switch back with reseek");
+    TEST_ASSERT(demuxer.getSeekSerial() == serial + 1, "Reseek should run one container seek");
+    TEST_ASSERT(demuxer.readPacket(MediaType::AUDIO, packet.get()) && packet->stream_index == 1,
+               "Should read the original track after switching back");
+    
+    // 对比关闭、重新打开再定位的方式
+    auto reopen_start = std::chrono::steady_clock::now();
+    demuxer.close();
+    TEST_ASSERT(demuxer.open(test_file), "Should reopen");
+    TEST_ASSERT(demuxer.seek(last_us, AVSEEK_FLAG_BACKWARD), "Should seek after reopening");
+    int64_t reopen_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - reopen_start).count();
+    std::cout << "track switch: " << switch_us << "us, close/open/seek: " << reopen_us << "us" << std::endl;
+    demuxer.close();
+    
+    // 放回缓存的上下文沿用打开时选出的音轨，切换过的音轨不会带给下一次打开
+    DemuxerPool pool;
+    {
+        Demuxer pooled;
+        pooled.setDemuxerPool(&pool);
+        TEST_ASSERT(pooled.open(test_file), "Should open with pool");
+        TEST_ASSERT(pooled.selectTrack(MediaType::AUDIO, jpn), "Should switch before closing");
+        pooled.close();
+        TEST_ASSERT(pooled.open(test_file) && pooled.getOpenTiming().pool_hit, "Should reuse the pooled context");
+        TEST_ASSERT(pooled.getStreamIndex(MediaType::AUDIO) == 1, "Pooled context should keep the track chosen at open time");
+        TEST_ASSERT(pooled.getTracks()[1].selected && !pooled.getTracks()[2].selected,
+                   "Switched track should not be selected after reopening");
+        TEST_ASSERT(pooled.readPacket(MediaType::AUDIO, packet.get()) && packet->stream_index == 1,
+                   "Should read the default track from the pooled context");
+    }
+    pool.clear();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 把字幕写成srt文件，cues为{开始毫秒, 结束毫秒, 文本}
+static bool writeSrt(const std::string& path, const std::vector<std::tuple<int64_t, int64_t, std::string>>& cues) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    auto stamp = [](int64_t ms) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d,%03d", static_cast<int>(ms / 3600000),
+                      static_cast<int>(ms / 60000 % 60), static_cast<int>(ms / 1000 % 60), static_cast<int>(ms % 1000));
+        return std::string(buf);
+    };
+    int number = 1;
+    for (const auto& cue : cues) {
+        out << number++ << "\n" << stamp(std::get<0>(cue)) << " --> " << stamp(std::get<1>(cue)) << "\n"
+            << std::get<2>(cue) << "\n\n";
+    }
+    return static_cast<bool>(out);
+}
+
+// 测试32: 字幕流和稀疏流的读取上限
+bool testSubtitleStreams() {
+    const std::string srt_file = "test_subs.srt";
+    const std::string test_file = "test_subs.mkv";
+    
+    // 前两条字幕重叠，第三条隔了六秒多
+    TEST_ASSERT(writeSrt(srt_file, {{500, 1500, "Hello"}, {1000, 2000, "Overlap"}, {8000, 9000, "Later"}}),
+               "Should write srt file");
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=10:size=320x240:rate=30 -f lavfi -i sine=frequency=440:duration=10 "
+                     "-i " + srt_file + " -map 0 -map 1 -map 2 -c:v libx264 -g 30 -c:a aac -c:s srt "
+                     "-metadata:s:s:0 language=eng -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        std::remove(srt_file.c_str());
+        return true;
+    }
+    
+    // 多流模式下字幕默认不输出
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(test_file), "Should open file with subtitles");
+    int sub = demuxer.findTrack(MediaType::SUBTITLE, "eng");
+    TEST_ASSERT(sub == 2, "Should find the subtitle track");
+    TEST_ASSERT(demuxer.getTracks()[sub].codec_type == AVMEDIA_TYPE_SUBTITLE && !demuxer.getTracks()[sub].selected,
+               "Subtitle track should not be selected by default");
+    TEST_ASSERT(demuxer.getDiscardStats().streams_discarded == 1, "Subtitle track should be discarded by default");
+    PacketPtr packet = makePacket();
+    TEST_ASSERT(!demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "No subtitle packets before selecting the track");
+    
+    TEST_ASSERT(!demuxer.selectTrack(MediaType::SUBTITLE, 1), "Audio stream is not a subtitle track");
+    TEST_ASSERT(demuxer.selectTrack(MediaType::SUBTITLE, sub), "Should select the subtitle track");
+    TEST_ASSERT(demuxer.getDiscardStats().streams_discarded == 0, "Subtitle track should no longer be discarded");
+    PendingPacketOptions pending_options;
+    pending_options.max_pending_packets = 200;
+    demuxer.setPendingPacketOptions(pending_options);
+    
+    TEST_ASSERT(demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "Should read the first subtitle");
+    AVStream* sub_stream = demuxer.getAVStream(MediaType::SUBTITLE);
+    TEST_ASSERT(packet->stream_index == sub, "Packet should come from the subtitle track");
+    TEST_ASSERT(av_rescale_q(packet->pts, sub_stream->time_base, AV_TIME_BASE_Q) == 500000, "First subtitle should start at 0.5s");
+    TEST_ASSERT(demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "Should read the overlapping subtitle");
+    
+    // 下一条字幕在8秒，读到暂存上限就停下
+    TEST_ASSERT(!demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "Next subtitle is beyond the pending limit");
+    TEST_ASSERT(demuxer.getLastStatus() == DemuxStatus::AGAIN, "Sparse read should report AGAIN");
+    TEST_ASSERT(!demuxer.isEOF(), "Sparse read should not reach EOF");
+    int64_t read_at_limit = demuxer.getMetrics().packets_read;
+    std::cout << "packets read when the sparse limit was hit: " << read_at_limit << std::endl;
+    TEST_ASSERT(read_at_limit < 300, "Buffered audio/video should stay bounded");
+    TEST_ASSERT(!demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "Full pending queues should not be read further");
+    TEST_ASSERT(demuxer.getMetrics().packets_read == read_at_limit, "No packets should be read while pending is full");
+    
+    // 视频往后读，顺路把字幕放进暂存队列；音频暂存满了时由音频消费者取走
+    AVStream* video_stream = demuxer.getAVStream(MediaType::VIDEO);
+    while (true) {
+        if (!demuxer.readPacket(MediaType::VIDEO, packet.get())) {
+            TEST_ASSERT(demuxer.getLastStatus() == DemuxStatus::AGAIN, "Video should only stop at the pending limit");
+            while (demuxer.readPacket(MediaType::AUDIO, packet.get())) {
+            }
+            continue;
+        }
+        if (av_rescale_q(packet->pts, video_stream->time_base, AV_TIME_BASE_Q) >= 8500000) {
+            break;
+        }
+    }
+    TEST_ASSERT(demuxer.readPacket(MediaType::SUBTITLE, packet.get()), "Should read the later subtitle after video caught up");
+    TEST_ASSERT(av_rescale_q(packet->pts, sub_stream->time_base, AV_TIME_BASE_Q) == 8000000, "Later subtitle should start at 8s");
+    TEST_ASSERT(std::string(reinterpret_cast<const char*>(packet->data), packet->size).find("Later") != std::string::npos,
+               "Subtitle packet should carry its text");
+    
+    TEST_ASSERT(demuxer.selectTrack(MediaType::SUBTITLE, -1), "Should deselect the subtitle track");
+    TEST_ASSERT(demuxer.getStreamIndex(MediaType::SUBTITLE) == -1, "Subtitle track should be deselected");
+    TEST_ASSERT(demuxer.getDiscardStats().streams_discarded == 1, "Deselected subtitle track should be discarded again");
+    TEST_ASSERT(!demuxer.selectTrack(MediaType::AUDIO, -1), "Audio track cannot be deselected");
+    demuxer.close();
+    
+    // 单流的字幕Demuxer
+    Demuxer sub_demuxer(MediaType::SUBTITLE);
+    TEST_ASSERT(sub_demuxer.open(test_file), "Should open subtitle demuxer");
+    TEST_ASSERT(sub_demuxer.getStreamIndex() == sub, "Subtitle demuxer should select the subtitle stream");
+    int sub_packets = 0;
+    while (sub_demuxer.readPacket(packet.get())) {
+        TEST_ASSERT(packet->stream_index == sub, "Only subtitle packets should be returned");
+        sub_packets++;
+    }
+    TEST_ASSERT(sub_packets == 3 && sub_demuxer.isEOF(), "Subtitle demuxer should read all subtitles");
+    sub_demuxer.close();
+    
+    // 预加载缓存，内嵌和外挂的字幕结果相同
+    for (const std::string& file : {test_file, srt_file}) {
+        SubtitleCache cache;
+        TEST_ASSERT(cache.load(file), "Should load subtitles into cache");
+        TEST_ASSERT(cache.size() == 3 && cache.getCodecName() == "subrip", "Cache should hold all subtitles");
+        std::vector<const SubtitleCue*> active;
+        TEST_ASSERT(cache.find(1200000, active) == 2 && active[0]->text == "Hello" && active[1]->text == "Overlap",
+                   "Overlapping subtitles should both be active");
+        TEST_ASSERT(cache.at(1200000)->text == "Overlap", "Latest active subtitle should be returned");
+        TEST_ASSERT(cache.at(1700000)->text == "Overlap", "Subtitle should stay until its end");
+        TEST_ASSERT(cache.at(400000) == nullptr && cache.at(5000000) == nullptr, "No subtitle in the gaps");
+        TEST_ASSERT(cache.next(5000000) && cache.next(5000000)->start_us == 8000000, "Next subtitle should start at 8s");
+        TEST_ASSERT(cache.at(8500000) && cache.at(8500000)->text == "Later", "Later subtitle should be active");
+        TEST_ASSERT(cache.at(9000000) == nullptr, "End time should be exclusive");
+    }
+    
+    // 查找性能：一万条字幕，二分查找对比线性扫描
+    const std::string big_srt = "test_subs_big.srt";
+    std::vector<std::tuple<int64_t, int64_t, std::string>> big_cues;
+    for (int i = 0; i < 10000; i++) {
+        big_cues.emplace_back(i * 300, i * 300 + 250, "line " + std::to_string(i));
+    }
+    TEST_ASSERT(writeSrt(big_srt, big_cues), "Should write large srt file");
+    SubtitleCache big;
+    TEST_ASSERT(big.load(big_srt), "Should load large srt file");
+    TEST_ASSERT(big.size() == big_cues.size(), "All cues should be loaded");
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int64_t> dist(0, 3000000000LL);
+    std::vector<int64_t> queries(200000);
+    for (int64_t& query : queries) {
+        query = dist(rng);
+    }
+    auto bench_start = std::chrono::steady_clock::now();
+    size_t hits = 0;
+    for (int64_t query : queries) {
+        hits += big.at(query) != nullptr;
+    }
+    double indexed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bench_start).count() / queries.size();
+    bench_start = std::chrono::steady_clock::now();
+    size_t linear_hits = 0;
+    const std::vector<SubtitleCue>& all = big.getCues();
+    for (size_t q = 0; q < 2000; q++) {
+        for (const SubtitleCue& cue : all) {
+            if (cue.start_us <= queries[q] && queries[q] < cue.end_us) {
+                linear_hits++;
+                break;
+            }
+        }
+    }
+    double linear_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bench_start).count() / 2000;
+    size_t check_hits = 0;
+    for (size_t q = 0; q < 2000; q++) {
+        check_hits += big.at(queries[q]) != nullptr;
+    }
+    TEST_ASSERT(check_hits == linear_hits, "Indexed lookup should match linear scan");
+    std::cout << "subtitle cache: " << big.size() << " cues loaded in " << big.getLoadTimeUs() << "us, lookup "
+              << indexed_ns << "ns (linear " << linear_ns << "ns), hit rate " << static_cast<double>(hits) / queries.size() << std::endl;
+    
+    // 一条贯穿全片的字幕加一万条短字幕：查找不能因为这条长字幕退化成线性扫描
+    const std::string long_srt = "test_subs_long.srt";
+    std::vector<std::tuple<int64_t, int64_t, std::string>> long_cues;
+    long_cues.emplace_back(0, 3000000, "Title");
+    long_cues.insert(long_cues.end(), big_cues.begin(), big_cues.end());
+    TEST_ASSERT(writeSrt(long_srt, long_cues), "Should write srt file with a long cue");
+    SubtitleCache mixed;
+    TEST_ASSERT(mixed.load(long_srt), "Should load srt file with a long cue");
+    TEST_ASSERT(mixed.size() == long_cues.size(), "All cues should be loaded");
+    bench_start = std::chrono::steady_clock::now();
+    std::vector<const SubtitleCue*> active;
+    size_t active_total = 0;
+    for (int64_t query : queries) {
+        active_total += mixed.find(query, active);
+    }
+    double mixed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bench_start).count() / queries.size();
+    // 和线性扫描的结果对比，包括顺序和最晚开始的一条
+    const std::vector<SubtitleCue>& mixed_all = mixed.getCues();
+    bool same = true;
+    for (size_t q = 0; q < 2000 && same; q++) {
+        std::vector<const SubtitleCue*> expected;
+        for (const SubtitleCue& cue : mixed_all) {
+            if (cue.start_us <= queries[q] && queries[q] < cue.end_us) {
+                expected.push_back(&cue);
+            }
+        }
+        mixed.find(queries[q], active);
+        same = active == expected && mixed.at(queries[q]) == (expected.empty() ? nullptr : expected.back());
+    }
+    TEST_ASSERT(same, "Lookup with a long cue should match linear scan");
+    TEST_ASSERT(mixed.at(260000)->text == "Title" && mixed.at(100000)->text == "line 0",
+               "Short cue should be the latest active one inside the long cue");
+    std::cout << "subtitle cache with a long cue: find " << mixed_ns << "ns, "
+              << static_cast<double>(active_total) / queries.size() << " active per lookup" << std::endl;
+    
+    std::remove(long_srt.c_str());
+    std::remove(big_srt.c_str());
+    std::remove(srt_file.c_str());
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试33: 时间戳换算成微秒的包描述
+bool testPacketInfo() {
+    const std::string test_file = "test_packet_info.mp4";
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    TEST_ASSERT(sizeof(PacketInfo) == 32, "PacketInfo should be 32 bytes");
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(test_file), "Should open test file");
+    AVFormatContext* ctx = demuxer.getFormatContext();
+    
+    // 和直接用AVStream换算的结果一致
+    PacketPtr packet = makePacket();
+    PacketInfo info;
+    int checked = 0;
+    bool saw_key = false;
+    while (checked < 200 && demuxer.readPacket(packet.get(), info)) {
+        AVStream* stream = ctx->streams[packet->stream_index];
+        TEST_ASSERT(info.stream_index == packet->stream_index && info.size == packet->size, "Index and size should match");
+        TEST_ASSERT(info.pts_us == av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q), "pts should be in microseconds");
+        TEST_ASSERT(info.dts_us == av_rescale_q(packet->dts, stream->time_base, AV_TIME_BASE_Q), "dts should be in microseconds");
+        TEST_ASSERT(info.duration_us == av_rescale_q(packet->duration, stream->time_base, AV_TIME_BASE_Q), "duration should be in microseconds");
+        TEST_ASSERT(info.isKeyframe() == ((packet->flags & AV_PKT_FLAG_KEY) != 0), "Keyframe flag should match");
+        MediaType expected = stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ? MediaType::VIDEO : MediaType::AUDIO;
+        TEST_ASSERT(info.type == expected, "Media type should match the stream");
+        saw_key = saw_key || (info.type == MediaType::VIDEO && info.isKeyframe());
+        checked++;
+    }
+    TEST_ASSERT(checked == 200 && saw_key, "Should describe packets including a video keyframe");
+    TEST_ASSERT(demuxer.readPacket(MediaType::AUDIO, packet.get(), info) && info.type == MediaType::AUDIO,
+               "Typed read should fill the descriptor");
+    
+    packet->stream_index = 99;
+    TEST_ASSERT(!demuxer.describePacket(packet.get(), info), "Unknown stream should not be described");
+    
+    // 热循环对比：统计已缓冲的视频时长
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should seek to start");
+    const int batch = 256;
+    std::vector<AVPacket*> packets(batch);
+    for (AVPacket*& p : packets) {
+        p = av_packet_alloc();
+    }
+    int count = demuxer.readPackets(packets.data(), batch);
+    std::vector<PacketInfo> infos(count);
+    TEST_ASSERT(count > 0 && demuxer.describePackets(packets.data(), count, infos.data()) == count, "Should describe a batch");
+    
+    const int rounds = 2000;
+    int64_t raw_total = 0;
+    auto bench_start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++) {
+            const AVPacket* p = packets[i];
+            const AVStream* stream = ctx->streams[p->stream_index];
+            if (stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+                raw_total += av_rescale_q(p->duration, stream->time_base, AV_TIME_BASE_Q);
+            }
+        }
+    }
+    double raw_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bench_start).count() / (rounds * count);
+    int64_t info_total = 0;
+    bench_start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const PacketInfo& pi : infos) {
+            if (pi.type == MediaType::VIDEO) {
+                info_total += pi.duration_us;
+            }
+        }
+    }
+    double info_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - bench_start).count() / (rounds * count);
+    TEST_ASSERT(raw_total == info_total, "Both loops should compute the same buffered duration");
+    std::cout << "buffered duration per packet: AVPacket+AVStream " << raw_ns << "ns, PacketInfo " << info_ns << "ns" << std::endl;
+    
+    // 消费者线程描述包的同时反复关闭和重新打开，描述结果要么失败要么是完整的
+    demuxer.close();
+    std::atomic<bool> stop(false);
+    std::atomic<int64_t> described(0);
+    std::thread consumer([&]() {
+        PacketInfo pi;
+        while (!stop) {
+            if (demuxer.describePacket(packets[0], pi)) {
+                described++;
+            }
+        }
+    });
+    bool reopened = true;
+    for (int i = 0; i < 50; i++) {
+        reopened = demuxer.open(test_file) && reopened;
+        demuxer.close();
+    }
+    stop = true;
+    consumer.join();
+    TEST_ASSERT(reopened, "Should reopen while another thread describes packets");
+    std::cout << "described " << described << " packets while reopening" << std::endl;
+    
+    for (AVPacket*& p : packets) {
+        av_packet_free(&p);
+    }
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试34: 一个Demuxer的包分发给多个接收端
+bool testPacketTee() {
+    const std::string test_file = "test_tee.mp4";
+    if (!createTestVideoFile(test_file)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    // 不分发时的读取耗时作为基准
+    Demuxer baseline;
+    TEST_ASSERT(baseline.open(test_file), "Should open baseline demuxer");
+    PacketPtr packet = makePacket();
+    int total = 0;
+    auto read_start = std::chrono::steady_clock::now();
+    while (baseline.readPacket(packet.get())) {
+        total++;
+    }
+    int64_t baseline_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - read_start).count();
+    baseline.close();
+    
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(test_file), "Should open test file");
+    int video_index = demuxer.getStreamIndex(MediaType::VIDEO);
+    PacketTee tee(demuxer);
+    
+    // 接收端拿到的是同一块数据的引用
+    auto probe = tee.addSink("probe");
+    TEST_ASSERT(tee.readPacket(packet.get()), "Should read through the tee");
+    TeePacket item;
+    TEST_ASSERT(probe->tryPop(item), "Probe sink should receive the packet");
+    TEST_ASSERT(item.packet->data == packet->data && item.packet->buf->buffer == packet->buf->buffer,
+               "Sink packet should share the payload");
+    TEST_ASSERT(item.info.stream_index == packet->stream_index && item.info.size == packet->size, "Sink should get the descriptor");
+    tee.removeSink(probe);
+    TEST_ASSERT(probe->isClosed() && tee.getSinkCount() == 0, "Removed sink should be closed");
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should rewind");
+    
+    // 录制：BLOCK，不丢包
+    TeeSinkOptions record_options;
+    record_options.capacity = 64;
+    record_options.policy = TeeOverflowPolicy::BLOCK;
+    auto record = tee.addSink("record", record_options);
+    // 分析：队列很小，播放期间不取
+    TeeSinkOptions analyze_options;
+    analyze_options.capacity = 8;
+    analyze_options.policy = TeeOverflowPolicy::DROP_NEWEST;
+    auto analyze = tee.addSink("analyze", analyze_options);
+    // 预览：只要视频，消费得慢，丢包后从关键帧恢复
+    TeeSinkOptions preview_options;
+    preview_options.capacity = 16;
+    preview_options.policy = TeeOverflowPolicy::DROP_UNTIL_KEYFRAME;
+    preview_options.streams = {video_index};
+    auto preview = tee.addSink("preview", preview_options);
+    TEST_ASSERT(tee.getSinkCount() == 3, "Should have three sinks");
+    
+    std::atomic<int> recorded{0};
+    std::thread record_thread([&]() {
+        TeePacket received;
+        while (record->pop(received)) {
+            recorded++;
+        }
+    });
+    std::vector<int64_t> preview_pts;
+    std::vector<bool> preview_key;
+    std::thread preview_thread([&]() {
+        TeePacket received;
+        while (preview->pop(received)) {
+            preview_pts.push_back(received.info.pts_us);
+            preview_key.push_back(received.info.isKeyframe());
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+    
+    std::vector<int64_t> video_pts;
+    int played = 0;
+    read_start = std::chrono::steady_clock::now();
+    while (tee.readPacket(packet.get())) {
+        if (packet->stream_index == video_index) {
+            video_pts.push_back(av_rescale_q(packet->pts, demuxer.getAVStream(MediaType::VIDEO)->time_base, AV_TIME_BASE_Q));
+        }
+        played++;
+    }
+    int64_t tee_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - read_start).count();
+    tee.finish();
+    record_thread.join();
+    preview_thread.join();
+    
+    TEST_ASSERT(played == total, "Playback should see every packet");
+    TEST_ASSERT(recorded == total && record->getStats().dropped == 0, "Blocking sink should receive every packet");
+    TeeSinkStats analyze_stats = analyze->getStats();
+    TEST_ASSERT(analyze_stats.delivered == 8 && analyze_stats.dropped == total - 8, "Full sink should drop without stalling playback");
+    int left = 0;
+    while (analyze->tryPop(item)) {
+        left++;
+    }
+    TEST_ASSERT(left == 8, "Queued packets should still be readable after finish");
+    
+    // 预览收到的每一段连续的包都从关键帧开始
+    TeeSinkStats preview_stats = preview->getStats();
+    TEST_ASSERT(preview_stats.delivered == static_cast<int64_t>(preview_pts.size()), "Preview should receive what was delivered");
+    TEST_ASSERT(preview_stats.delivered + preview_stats.dropped == static_cast<int64_t>(video_pts.size()),
+               "Preview should only see video packets");
+    size_t position = 0;
+    for (size_t i = 0; i < preview_pts.size(); i++) {
+        size_t found = std::find(video_pts.begin() + position, video_pts.end(), preview_pts[i]) - video_pts.begin();
+        TEST_ASSERT(found < video_pts.size(), "Preview packet should come from the video stream");
+        if (i > 0 && found != position) {
+            TEST_ASSERT(preview_key[i], "After a gap the preview should resume on a keyframe");
+        }
+        position = found + 1;
+    }
+    std::cout << "tee: " << total << " packets, plain read " << baseline_us << "us, with 3 sinks " << tee_us
+              << "us, record blocked " << record->getStats().blocked_us << "us, preview dropped " << preview_stats.dropped
+              << std::endl;
+    
+    // 后台分发
+    TEST_ASSERT(demuxer.seek(0, AVSEEK_FLAG_BACKWARD), "Should rewind for background fan-out");
+    PacketTee pump(demuxer);
+    TeeSinkOptions pump_options;
+    pump_options.policy = TeeOverflowPolicy::BLOCK;
+    auto first = pump.addSink("first", pump_options);
+    auto second = pump.addSink("second", pump_options);
+    TEST_ASSERT(pump.start(), "Should start background fan-out");
+    TEST_ASSERT(!pump.start(), "Should not start twice");
+    int first_count = 0;
+    int second_count = 0;
+    std::thread second_thread([&]() {
+        TeePacket received;
+        while (second->pop(received)) {
+            second_count++;
+        }
+    });
+    while (first->pop(item)) {
+        first_count++;
+    }
+    second_thread.join();
+    pump.stop();
+    TEST_ASSERT(first_count == total && second_count == total, "Every sink should receive the whole file");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试35: 读包时建立的关键帧索引有空洞时的定位
+bool testSeekIndexGaps() {
+    const std::string test_file = "test_index_gaps.mp4";
+    // 20秒，每秒一个关键帧
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=20:size=160x120:rate=30 "
+                     "-c:v libx264 -g 30 -sc_threshold 0 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for gap test");
+    AVStream* stream = demuxer.getAVStream();
+    PacketPtr packet = makePacket();
+    // 读到until_us为止，返回最后一个包的时间
+    auto read_until = [&](int64_t until_us) {
+        int64_t last_us = AV_NOPTS_VALUE;
+        while (demuxer.readPacket(packet.get())) {
+            last_us = av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q);
+            if (last_us >= until_us) {
+                break;
+            }
+        }
+        return last_us;
+    };
+    // 定位后读到的第一个包的时间
+    auto first_after_seek = [&]() {
+        return demuxer.readPacket(packet.get()) ? av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q) : AV_NOPTS_VALUE;
+    };
+    
+    // 读0-2.5秒，跳到12秒再读到14.5秒，索引在2秒和12秒之间是空洞
+    read_until(2500000);
+    int64_t landed = 0;
+    TEST_ASSERT(demuxer.seek(12000000, AVSEEK_FLAG_BACKWARD, &landed), "Should seek beyond the index");
+    TEST_ASSERT(landed == AV_NOPTS_VALUE, "Target beyond the index should not use it");
+    read_until(14500000);
+    
+    // 目标在空洞中，不能落到2秒的关键帧上
+    TEST_ASSERT(demuxer.seek(7500000, AVSEEK_FLAG_BACKWARD, &landed), "Should seek into the gap");
+    TEST_ASSERT(landed == AV_NOPTS_VALUE, "Target inside the gap should fall back to the container seek");
+    int64_t first_us = first_after_seek();
+    std::cout << "seek into the gap landed at " << first_us << "us" << std::endl;
+    TEST_ASSERT(first_us >= 6500000 && first_us <= 7500000, "Seek into the gap should land on the keyframe before the target");
+    
+    // 目标在连续读过的范围中，用索引
+    TEST_ASSERT(demuxer.seek(1500000, AVSEEK_FLAG_BACKWARD, &landed), "Should seek inside the indexed range");
+    TEST_ASSERT(landed != AV_NOPTS_VALUE && landed <= 1500000 && landed > 500000, "Indexed seek should land on the previous keyframe");
+    TEST_ASSERT(first_after_seek() == landed, "First packet should be the landing keyframe");
+    
+    // 从7秒连续读到12秒之后，空洞被填平
+    TEST_ASSERT(demuxer.seek(7500000, AVSEEK_FLAG_BACKWARD), "Should seek into the gap again");
+    read_until(12500000);
+    TEST_ASSERT(demuxer.seek(10500000, AVSEEK_FLAG_BACKWARD, &landed), "Should seek inside the filled range");
+    TEST_ASSERT(landed != AV_NOPTS_VALUE && landed <= 10500000 && landed > 9500000, "Filled range should use the index");
+    TEST_ASSERT(demuxer.seek(11500000, AVSEEK_FLAG_BACKWARD, &landed), "Should seek next to the old gap boundary");
+    TEST_ASSERT(landed != AV_NOPTS_VALUE && landed <= 11500000 && landed > 10500000,
+               "Keyframe at the old gap boundary should now be linked to the one before it");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
+// 测试36: 关键帧索引在当前GOP之后有空洞时的定位请求
+bool testSeekRequestAcrossIndexGap() {
+    const std::string test_file = "test_request_index_gap.mp4";
+    // 20秒，每秒一个关键帧
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=20:size=160x120:rate=30 "
+                     "-c:v libx264 -g 30 -sc_threshold 0 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    
+    Demuxer demuxer(MediaType::VIDEO);
+    TEST_ASSERT(demuxer.open(test_file), "Should open file for gap request test");
+    AVStream* stream = demuxer.getAVStream();
+    PacketPtr packet = makePacket();
+    auto read_until = [&](int64_t until_us) {
+        while (demuxer.readPacket(packet.get())) {
+            if (av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q) >= until_us) {
+                break;
+            }
+        }
+    };
+    
+    // 读0-2.5秒，跳到12秒再读到14.5秒，索引中2秒的下一项是12秒，中间是空洞
+    read_until(2500000);
+    TEST_ASSERT(demuxer.seek(12000000, AVSEEK_FLAG_BACKWARD), "Should seek beyond the index");
+    read_until(14500000);
+    
+    // 回到2秒的GOP中读几个包
+    TEST_ASSERT(demuxer.seek(2000000, AVSEEK_FLAG_BACKWARD), "Should seek back to the indexed range");
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read inside the GOP");
+    }
+    
+    // 7.5秒不在2秒的GOP中，不能因为索引的下一项是12秒就继续往后读
+    std::this_thread::sleep_for(std::chrono::milliseconds(60)); // 避开限速
+    SeekRequestStats before = demuxer.getSeekRequestStats();
+    int serial = demuxer.getSeekSerial();
+    demuxer.requestSeek(7500000, AVSEEK_FLAG_BACKWARD);
+    TEST_ASSERT(demuxer.readPacket(packet.get()), "Should read after the seek request");
+    int64_t pts_us = av_rescale_q(packet->pts, stream->time_base, AV_TIME_BASE_Q);
+    SeekRequestStats after = demuxer.getSeekRequestStats();
+    std::cout << "request across the index gap landed at " << pts_us << "us" << std::endl;
+    TEST_ASSERT(after.skipped_in_gop == before.skipped_in_gop, "Request across the gap should not be skipped");
+    TEST_ASSERT(after.executed == before.executed + 1 && demuxer.getSeekSerial() == serial + 1,
+               "Request across the gap should run a container seek");
+    TEST_ASSERT(pts_us >= 6500000 && pts_us <= 7500000, "Request across the gap should land near its target");
+    
+    demuxer.close();
+    std::remove(test_file.c_str());
+    return true;
+}
+
 int main() {
     std::cout << "Starting Demuxer Tests..." << std::endl;
     
@@ -344,6 +2688,32 @@ int main() {
     RUN_TEST(testSeek);
     RUN_TEST(testEOFDetection);
     RUN_TEST(testMultipleOpenClose);
+    RUN_TEST(testReadPacketReuse);
+    RUN_TEST(testMultiStreamDemuxer);
+    RUN_TEST(testDiscardUnusedStreams);
+    RUN_TEST(testFastOpen);
+    RUN_TEST(testKeyframeIndexSeek);
+    RUN_TEST(testSeekIndexLookup);
+    RUN_TEST(testSeekIndexFile);
+    RUN_TEST(testSeekIndexReopen);
+    RUN_TEST(testReadAhead);
+    RUN_TEST(testMmapIO);
+    RUN_TEST(testUringIO);
+    RUN_TEST(testPacketPool);
+    RUN_TEST(testReadPackets);
+    RUN_TEST(testDemuxMetrics);
+    RUN_TEST(testInterruptibleIO);
+    RUN_TEST(testSeekCoalescing);
+    RUN_TEST(testAccurateSeek);
+    RUN_TEST(testThumbnailEngine);
+    RUN_TEST(testSegmentScanner);
+    RUN_TEST(testDemuxerPool);
+    RUN_TEST(testTrackSwitching);
+    RUN_TEST(testSubtitleStreams);
+    RUN_TEST(testPacketInfo);
+    RUN_TEST(testPacketTee);
+    RUN_TEST(testSeekIndexGaps);
+    RUN_TEST(testSeekRequestAcrossIndexGap);
     
     // 输出测试结果
     std::cout << "\n=== Test Summary ===" << std::endl;
@@ -0,0 +1,329 @@
+// Demuxer读包路径的堆分配次数测试
+// 通过替换libc的分配函数统计每个包触发的malloc次数，对比旧的readPacket()与复用packet的readPacket(AVPacket*)，
+// 以及预读队列和多流暂存队列使用和不使用PacketPool时的差别
+
+#include <iostream>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "demuxer/demuxer.hpp"
+#include "utils/logger.hpp"
+
+#if defined(__GLIBC__)
+// glibc导出的原始分配函数，替换版本在统计后转发给它们
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+    void __libc_free(void *ptr);
+}
+
+static std::atomic<bool> g_counting{false};
+static std::atomic<long> g_alloc_count{0};
+
+static inline void countAlloc()
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// FFmpeg的av_malloc在Linux上走posix_memalign，其他代码走malloc/calloc/realloc
+extern "C"
+{
+    void *malloc(size_t size)
+    {
+        countAlloc();
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        countAlloc();
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        countAlloc();
+        return __libc_realloc(ptr, size);
+    }
+
+    void free(void *ptr)
+    {
+        __libc_free(ptr);
+    }
+
+    int posix_memalign(void **memptr, size_t alignment, size_t size)
+    {
+        countAlloc();
+        void *ptr = __libc_memalign(alignment, size);
+        if (!ptr)
+        {
+            return ENOMEM;
+        }
+        *memptr = ptr;
+        return 0;
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        countAlloc();
+        return __libc_memalign(alignment, size);
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        countAlloc();
+        return __libc_memalign(alignment, size);
+    }
+}
+#endif
+
+// 创建一个音视频交织的测试文件，音频包会穿插在视频包之间
+static bool createTestVideoFile(const std::string &filename)
+{
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=5:size=320x240:rate=30 "
+                      "-f lavfi -i sine=frequency=1000:duration=5 "
+                      "-c:v libx264 -c:a aac -t 5 -y " + filename + " 2>/dev/null";
+    return std::system(cmd.c_str()) == 0;
+}
+
+// 开始和结束计数，返回平均每个包的分配次数
+static void startCounting()
+{
+#if defined(__GLIBC__)
+    g_alloc_count = 0;
+    g_counting = true;
+#endif
+}
+
+static double stopCounting(int packets_read)
+{
+#if defined(__GLIBC__)
+    g_counting = false;
+    return packets_read > 0 ? static_cast<double>(g_alloc_count.load()) / packets_read : 0.0;
+#else
+    (void)packets_read;
+    return 0.0;
+#endif
+}
+
+// 统计用旧接口读取count个包的平均分配次数
+static double measureAllocatingApi(Demuxer &demuxer, int count, int &packets_read)
+{
+    packets_read = 0;
+    startCounting();
+    for (int i = 0; i < count; i++)
+    {
+        AVPacket *packet = demuxer.readPacket();
+        if (!packet)
+        {
+            break;
+        }
+        packets_read++;
+        av_packet_free(&packet);
+    }
+    return stopCounting(packets_read);
+}
+
+// 统计用复用packet的新接口读取count个包的平均分配次数
+static double measureReusingApi(Demuxer &demuxer, AVPacket *packet, int count, int &packets_read)
+{
+    packets_read = 0;
+    startCounting();
+    for (int i = 0; i < count; i++)
+    {
+        if (!demuxer.readPacket(packet))
+        {
+            break;
+        }
+        packets_read++;
+    }
+    av_packet_unref(packet);
+    return stopCounting(packets_read);
+}
+
+// 预读模式下从头读到EOF，返回读到的包数
+static int drainReadAhead(Demuxer &demuxer, AVPacket *packet)
+{
+    int packets_read = 0;
+    demuxer.seek(0, AVSEEK_FLAG_BACKWARD);
+    if (!demuxer.startReadAhead())
+    {
+        return 0;
+    }
+    while (demuxer.readPacket(packet))
+    {
+        packets_read++;
+    }
+    demuxer.stopReadAhead();
+    av_packet_unref(packet);
+    return packets_read;
+}
+
+// 统计预读模式下读完整个文件的平均分配次数
+// 先完整读一遍作为预热，第二遍才计数，这时缓冲池中已经有上一遍放回的包结构体
+static double measureReadAhead(Demuxer &demuxer, AVPacket *packet, int &packets_read)
+{
+    drainReadAhead(demuxer, packet);
+    startCounting();
+    packets_read = drainReadAhead(demuxer, packet);
+    return stopCounting(packets_read);
+}
+
+// 多流模式下交替读取视频和音频，统计平均分配次数，读到另一种类型的包会进入暂存队列
+static double measureTypedReads(Demuxer &demuxer, AVPacket *packet, int count, int &packets_read)
+{
+    for (int pass = 0; pass < 2; pass++)
+    {
+        demuxer.seek(0, AVSEEK_FLAG_BACKWARD);
+        if (pass == 1)
+        {
+            startCounting();
+        }
+        packets_read = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (!demuxer.readPacket(i % 2 == 0 ? MediaType::VIDEO : MediaType::AUDIO, packet))
+            {
+                break;
+            }
+            packets_read++;
+        }
+        av_packet_unref(packet);
+    }
+    return stopCounting(packets_read);
+}
+
+// 对比使用和不使用PacketPool时预读队列和暂存队列的分配次数，返回是否通过
+static bool comparePacketPool(const std::string &test_file)
+{
+    PacketPool pool;
+    PacketPtr packet = makePacket();
+
+    Demuxer plain(MediaType::VIDEO);
+    Demuxer pooled(MediaType::VIDEO);
+    pooled.setPacketPool(&pool);
+    if (!plain.open(test_file) || !pooled.open(test_file))
+    {
+        std::cerr << "FAIL: Should open test file for pool comparison" << std::endl;
+        return false;
+    }
+    int plain_packets = 0;
+    int pooled_packets = 0;
+    double plain_allocs = measureReadAhead(plain, packet.get(), plain_packets);
+    double pooled_allocs = measureReadAhead(pooled, packet.get(), pooled_packets);
+    plain.close();
+    pooled.close();
+
+    Demuxer plain_typed;
+    Demuxer pooled_typed;
+    pooled_typed.setPacketPool(&pool);
+    if (!plain_typed.open(test_file) || !pooled_typed.open(test_file))
+    {
+        std::cerr << "FAIL: Should open test file for typed pool comparison" << std::endl;
+        return false;
+    }
+    const int typed_reads = 120;
+    int plain_typed_packets = 0;
+    int pooled_typed_packets = 0;
+    double plain_typed_allocs = measureTypedReads(plain_typed, packet.get(), typed_reads, plain_typed_packets);
+    double pooled_typed_allocs = measureTypedReads(pooled_typed, packet.get(), typed_reads, pooled_typed_packets);
+    plain_typed.close();
+    pooled_typed.close();
+
+    PacketPoolStats stats = pool.getStats();
+    std::cout << "read-ahead unpooled:   " << plain_allocs << " mallocs/packet over " << plain_packets << " packets" << std::endl;
+    std::cout << "read-ahead pooled:     " << pooled_allocs << " mallocs/packet over " << pooled_packets << " packets" << std::endl;
+    std::cout << "typed reads unpooled:  " << plain_typed_allocs << " mallocs/packet over " << plain_typed_packets << " packets" << std::endl;
+    std::cout << "typed reads pooled:    " << pooled_typed_allocs << " mallocs/packet over " << pooled_typed_packets << " packets" << std::endl;
+    std::cout << "pool: " << stats.requests << " requests, hit rate " << stats.hitRate() << ", high water "
+              << stats.high_water_bytes << " bytes" << std::endl;
+
+    if (plain_packets == 0 || pooled_packets != plain_packets || plain_typed_packets == 0 ||
+        pooled_typed_packets != plain_typed_packets)
+    {
+        std::cerr << "FAIL: Pooled and unpooled demuxers should read the same packets" << std::endl;
+        return false;
+    }
+    // 预读线程为每个入队的包分配一个结构体，池中有空闲的结构体时这次分配应该省掉
+    if (pooled_allocs + 0.5 > plain_allocs)
+    {
+        std::cerr << "FAIL: Pooled read-ahead should save an allocation per packet" << std::endl;
+        return false;
+    }
+    // 只有进入暂存队列的包才分配结构体，省下的次数取决于交织方式
+    if (pooled_typed_allocs >= plain_typed_allocs)
+    {
+        std::cerr << "FAIL: Pooled typed reads should allocate less" << std::endl;
+        return false;
+    }
+    std::cout << "PASS: Packet pool saves " << (plain_allocs - pooled_allocs) << " mallocs/packet with read-ahead, "
+              << (plain_typed_allocs - pooled_typed_allocs) << " with typed reads" << std::endl;
+    return true;
+}
+
+int main()
+{
+#if !defined(__GLIBC__)
+    std::cout << "WARNING: malloc interposition requires glibc, skipping allocation test" << std::endl;
+    return 0;
+#else
+    utils::Logger::setGlobalLevel(utils::LogLevel::ERROR);
+
+    const std::string test_file = "test_alloc.mp4";
+    if (!createTestVideoFile(test_file))
+    {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return 0;
+    }
+
+    Demuxer demuxer(MediaType::VIDEO);
+    if (!demuxer.open(test_file))
+    {
+        std::cerr << "FAIL: Should open test file for allocation test" << std::endl;
+        std::remove(test_file.c_str());
+        return 1;
+    }
+
+    const int packets_per_run = 60;
+
+    // 旧接口：每个包分配一个AVPacket，每个非目标流的包也分配并释放一次
+    int old_packets = 0;
+    double old_allocs = measureAllocatingApi(demuxer, packets_per_run, old_packets);
+
+    // 回到文件开头，用同一段数据测新接口
+    demuxer.seek(0, AVSEEK_FLAG_BACKWARD);
+    PacketPtr packet = makePacket();
+    int new_packets = 0;
+    double new_allocs = measureReusingApi(demuxer, packet.get(), packets_per_run, new_packets);
+
+    demuxer.close();
+    bool pool_passed = comparePacketPool(test_file);
+    std::remove(test_file.c_str());
+
+    std::cout << "readPacket():          " << old_allocs << " mallocs/packet over " << old_packets << " packets" << std::endl;
+    std::cout << "readPacket(AVPacket*): " << new_allocs << " mallocs/packet over " << new_packets << " packets" << std::endl;
+
+    if (old_packets == 0 || new_packets == 0)
+    {
+        std::cerr << "FAIL: Should read packets with both APIs" << std::endl;
+        return 1;
+    }
+    // 剩下的分配来自av_read_frame内部的负载缓冲区，结构体分配应该至少省掉一次
+    if (new_allocs + 0.9 > old_allocs)
+    {
+        std::cerr << "FAIL: Reusing API should save at least one allocation per packet" << std::endl;
+        return 1;
+    }
+    std::cout << "PASS: Reusing API saves " << (old_allocs - new_allocs) << " mallocs/packet" << std::endl;
+    return pool_passed ? 0 : 1;
+#endif
+}
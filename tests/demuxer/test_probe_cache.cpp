@@ -0,0 +1,275 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "demuxer/demuxer.hpp"
+#include "demuxer/probe_cache.hpp"
+#include "utils/logger.hpp"
+
+// 简单的测试框架宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "FAIL: " << message << " at line " << __LINE__ << std::endl; \
+            return false; \
+        } else { \
+            std::cout << "PASS: " << message << std::endl; \
+        } \
+    } while(0)
+
+#define RUN_TEST(test_func) \
+    do { \
+        std::cout << "\n=== Running " << #test_func << " ===" << std::endl; \
+        if (test_func()) { \
+            std::cout << #test_func << " PASSED" << std::endl; \
+            passed_tests++; \
+        } else { \
+            std::cout << #test_func << " FAILED" << std::endl; \
+            failed_tests++; \
+        } \
+        total_tests++; \
+    } while(0)
+
+// 全局测试统计
+static int total_tests = 0;
+static int passed_tests = 0;
+static int failed_tests = 0;
+
+// 写一个内容任意的文件，缓存只关心它的路径、大小和修改时间
+static void writeDummyFile(const std::string& filename, const std::string& content) {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+// 构造一个带视频和音频流的探测结果
+static ProbeResult makeResult(int width) {
+    ProbeResult result;
+    result.video_stream_index = 0;
+    result.audio_stream_index = 1;
+    result.duration = 5000000;
+    result.streams.resize(2);
+    result.streams[0].codec_type = AVMEDIA_TYPE_VIDEO;
+    result.streams[0].width = width;
+    result.streams[0].height = 240;
+    result.streams[0].extradata = {1, 2, 3, 4};
+    result.streams[1].codec_type = AVMEDIA_TYPE_AUDIO;
+    result.streams[1].sample_rate = 44100;
+    result.streams[1].nb_channels = 2;
+    return result;
+}
+
+static void removeCache(const std::string& cache_file) {
+    std::remove(cache_file.c_str());
+    std::remove((cache_file + ".lock").c_str());
+}
+
+// 测试1: 保存后能读回相同的结果
+bool testStoreAndLookup() {
+    const std::string cache_file = "test_probe_cache.bin";
+    const std::string media_file = "test_probe_media_a.bin";
+    removeCache(cache_file);
+    writeDummyFile(media_file, "media a");
+    
+    ProbeCache cache(cache_file);
+    ProbeResult result;
+    TEST_ASSERT(!cache.lookup(media_file, result), "Empty cache should miss");
+    TEST_ASSERT(cache.store(media_file, makeResult(320)), "Should store probe result");
+    TEST_ASSERT(cache.lookup(media_file, result), "Should hit after store");
+    TEST_ASSERT(result.video_stream_index == 0 && result.audio_stream_index == 1, "Stream indices should round-trip");
+    TEST_ASSERT(result.duration == 5000000, "Duration should round-trip");
+    TEST_ASSERT(result.streams.size() == 2, "Stream count should round-trip");
+    TEST_ASSERT(result.streams[0].width == 320 && result.streams[0].extradata.size() == 4, "Video parameters should round-trip");
+    TEST_ASSERT(result.streams[1].sample_rate == 44100, "Audio parameters should round-trip");
+    TEST_ASSERT(cache.getHits() == 1 && cache.getMisses() == 1, "Hit and miss counters should be updated");
+    
+    removeCache(cache_file);
+    std::remove(media_file.c_str());
+    return true;
+}
+
+// 测试2: 文件变化后缓存失效
+bool testStaleEntry() {
+    const std::string cache_file = "test_probe_cache_stale.bin";
+    const std::string media_file = "test_probe_media_stale.bin";
+    removeCache(cache_file);
+    writeDummyFile(media_file, "original");
+    
+    ProbeCache cache(cache_file);
+    TEST_ASSERT(cache.store(media_file, makeResult(320)), "Should store probe result");
+    writeDummyFile(media_file, "modified and longer");
+    ProbeResult result;
+    TEST_ASSERT(!cache.lookup(media_file, result), "Changed file should miss");
+    
+    removeCache(cache_file);
+    std::remove(media_file.c_str());
+    return true;
+}
+
+// 测试3: 超出条目上限时淘汰最久未使用的条目
+bool testLruEviction() {
+    const std::string cache_file = "test_probe_cache_lru.bin";
+    const std::string file_a = "test_probe_media_lru_a.bin";
+    const std::string file_b = "test_probe_media_lru_b.bin";
+    const std::string file_c = "test_probe_media_lru_c.bin";
+    removeCache(cache_file);
+    writeDummyFile(file_a, "a");
+    writeDummyFile(file_b, "b");
+    writeDummyFile(file_c, "c");
+    
+    ProbeCache cache(cache_file, 2);
+    ProbeResult result;
+    TEST_ASSERT(cache.store(file_a, makeResult(1)), "Should store A");
+    TEST_ASSERT(cache.store(file_b, makeResult(2)), "Should store B");
+    TEST_ASSERT(cache.lookup(file_a, result), "Should hit A and refresh it");
+    TEST_ASSERT(cache.store(file_c, makeResult(3)), "Should store C");
+    TEST_ASSERT(cache.lookup(file_a, result), "Recently used A should survive");
+    TEST_ASSERT(cache.lookup(file_c, result), "New entry C should be present");
+    TEST_ASSERT(!cache.lookup(file_b, result), "Least recently used B should be evicted");
+    
+    removeCache(cache_file);
+    std::remove(file_a.c_str());
+    std::remove(file_b.c_str());
+    std::remove(file_c.c_str());
+    return true;
+}
+
+// 测试4: 损坏的缓存文件被当作空缓存
+bool testCorruptCache() {
+    const std::string cache_file = "test_probe_cache_corrupt.bin";
+    const std::string media_file = "test_probe_media_corrupt.bin";
+    removeCache(cache_file);
+    writeDummyFile(media_file, "media");
+    
+    ProbeCache cache(cache_file);
+    TEST_ASSERT(cache.store(media_file, makeResult(320)), "Should store probe result");
+    
+    // 截断缓存文件
+    std::ifstream in(cache_file, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    writeDummyFile(cache_file, data.substr(0, data.size() / 2));
+    
+    ProbeResult result;
+    TEST_ASSERT(!cache.lookup(media_file, result), "Truncated entry should miss");
+    TEST_ASSERT(cache.store(media_file, makeResult(640)), "Should store over truncated cache");
+    TEST_ASSERT(cache.lookup(media_file, result) && result.streams[0].width == 640, "Should hit after rewrite");
+    
+    // 完全无关的内容
+    writeDummyFile(cache_file, "not a probe cache");
+    TEST_ASSERT(!cache.lookup(media_file, result), "Garbage cache should miss");
+    
+    removeCache(cache_file);
+    std::remove(media_file.c_str());
+    return true;
+}
+
+// 测试5: 多个进程同时读写同一个缓存
+bool testConcurrentProcesses() {
+    const std::string cache_file = "test_probe_cache_mp.bin";
+    const int process_count = 4;
+    const int rounds = 20;
+    removeCache(cache_file);
+    for (int i = 0; i < process_count; i++) {
+        writeDummyFile("test_probe_media_mp_" + std::to_string(i) + ".bin", std::to_string(i));
+    }
+    
+    for (int i = 0; i < process_count; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            ProbeCache cache(cache_file);
+            std::string media_file = "test_probe_media_mp_" + std::to_string(i) + ".bin";
+            for (int round = 0; round < rounds; round++) {
+                ProbeResult result;
+                cache.store(media_file, makeResult(i));
+                if (!cache.lookup(media_file, result) || result.streams[0].width != i) {
+                    _exit(1);
+                }
+            }
+            _exit(0);
+        }
+    }
+    bool all_ok = true;
+    for (int i = 0; i < process_count; i++) {
+        int status = 0;
+        wait(&status);
+        all_ok = all_ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    TEST_ASSERT(all_ok, "Every process should read back its own entry");
+    
+    ProbeCache cache(cache_file);
+    for (int i = 0; i < process_count; i++) {
+        ProbeResult result;
+        std::string media_file = "test_probe_media_mp_" + std::to_string(i) + ".bin";
+        TEST_ASSERT(cache.lookup(media_file, result) && result.streams[0].width == i,
+                   "Cache should keep every process's entry");
+        std::remove(media_file.c_str());
+    }
+    
+    removeCache(cache_file);
+    return true;
+}
+
+// 测试6: Demuxer第二次打开同一文件时命中缓存并跳过avformat_find_stream_info
+bool testDemuxerProbeCache() {
+    const std::string test_file = "test_probe_cache_video.mp4";
+    const std::string cache_file = "test_probe_cache_demuxer.bin";
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=5:size=320x240:rate=30 "
+                      "-f lavfi -i sine=frequency=1000:duration=5 "
+                      "-c:v libx264 -c:a aac -t 5 -y " + test_file + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    removeCache(cache_file);
+    
+    ProbeCache cache(cache_file);
+    Demuxer first(MediaType::VIDEO);
+    first.setProbeCache(&cache);
+    TEST_ASSERT(first.open(test_file), "First open should succeed");
+    TEST_ASSERT(!first.getOpenTiming().probe_cache_hit, "First open should miss the cache");
+    AVCodecParameters* first_par = first.getAVStream()->codecpar;
+    
+    Demuxer second(MediaType::VIDEO);
+    second.setProbeCache(&cache);
+    TEST_ASSERT(second.open(test_file), "Second open should succeed");
+    const OpenTiming& timing = second.getOpenTiming();
+    std::cout << "first open: " << first.getOpenTiming().total_us << "us, cached open: " << timing.total_us << "us" << std::endl;
+    TEST_ASSERT(timing.probe_cache_hit, "Second open should hit the cache");
+    TEST_ASSERT(timing.find_stream_info_us == 0, "Cached open should skip avformat_find_stream_info");
+    TEST_ASSERT(second.getStreamIndex() == first.getStreamIndex(), "Cached open should select the same stream");
+    AVCodecParameters* second_par = second.getAVStream()->codecpar;
+    TEST_ASSERT(second_par->width == first_par->width && second_par->format == first_par->format,
+               "Cached open should restore codec parameters");
+    TEST_ASSERT(second.getDuration() == first.getDuration(), "Cached open should restore duration");
+    PacketPtr packet = second.readPacketPtr();
+    TEST_ASSERT(packet != nullptr, "Should read packets after cached open");
+    
+    first.close();
+    second.close();
+    removeCache(cache_file);
+    std::remove(test_file.c_str());
+    return true;
+}
+
+int main() {
+    std::cout << "Starting ProbeCache Tests..." << std::endl;
+    
+    RUN_TEST(testStoreAndLookup);
+    RUN_TEST(testStaleEntry);
+    RUN_TEST(testLruEviction);
+    RUN_TEST(testCorruptCache);
+    RUN_TEST(testConcurrentProcesses);
+    RUN_TEST(testDemuxerProbeCache);
+    
+    // 输出测试结果
+    std::cout << "\n=== Test Summary ===" << std::endl;
+    std::cout << "Total tests: " << total_tests << std::endl;
+    std::cout << "Passed: " << passed_tests << std::endl;
+    std::cout << "Failed: " << failed_tests << std::endl;
+    
+    return failed_tests == 0 ? 0 : 1;
+}
@@ -0,0 +1,312 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <sys/stat.h>
+
+#include "demuxer/demuxer.hpp"
+#include "muxer/muxer.hpp"
+#include "utils/logger.hpp"
+
+// 简单的测试框架宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << "FAIL: " << message << " at line " << __LINE__ << std::endl; \
+            return false; \
+        } else { \
+            std::cout << "PASS: " << message << std::endl; \
+        } \
+    } while(0)
+
+#define RUN_TEST(test_func) \
+    do { \
+        std::cout << "\n=== Running " << #test_func << " ===" << std::endl; \
+        if (test_func()) { \
+            std::cout << #test_func << " PASSED" << std::endl; \
+            passed_tests++; \
+        } else { \
+            std::cout << #test_func << " FAILED" << std::endl; \
+            failed_tests++; \
+        } \
+        total_tests++; \
+    } while(0)
+
+// 全局测试统计
+static int total_tests = 0;
+static int passed_tests = 0;
+static int failed_tests = 0;
+
+// 创建一个带视频和音频的测试文件
+static bool createTestVideoFile(const std::string& filename, int seconds = 5, const std::string& size = "320x240") {
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=" + std::to_string(seconds) + ":size=" + size + ":rate=30 "
+                     "-f lavfi -i sine=frequency=1000:duration=" + std::to_string(seconds) + " "
+                     "-c:v libx264 -preset ultrafast -bf 2 -c:a aac -y " + filename + " 2>/dev/null";
+    return std::system(cmd.c_str()) == 0;
+}
+
+static int64_t fileSize(const std::string& filename) {
+    struct stat st;
+    return ::stat(filename.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_size) : 0;
+}
+
+// 一个文件中每种类型的包，时间戳换算成微秒，用来比较转封装前后的内容
+struct TrackDump {
+    std::vector<int64_t> pts_us;
+    std::vector<int> sizes;
+    int keyframes = 0;
+    std::string codec;
+};
+
+static bool dumpTracks(const std::string& filename, TrackDump& video, TrackDump& audio) {
+    Demuxer demuxer;
+    if (!demuxer.open(filename)) {
+        return false;
+    }
+    if (demuxer.getAVStream(MediaType::VIDEO)) {
+        video.codec = avcodec_get_name(demuxer.getAVStream(MediaType::VIDEO)->codecpar->codec_id);
+    }
+    if (demuxer.getAVStream(MediaType::AUDIO)) {
+        audio.codec = avcodec_get_name(demuxer.getAVStream(MediaType::AUDIO)->codecpar->codec_id);
+    }
+    PacketPtr packet = makePacket();
+    PacketInfo info;
+    while (demuxer.readPacket(packet.get(), info)) {
+        TrackDump& dump = info.type == MediaType::VIDEO ? video : audio;
+        dump.pts_us.push_back(info.pts_us);
+        dump.sizes.push_back(info.size);
+        dump.keyframes += info.isKeyframe() ? 1 : 0;
+    }
+    return demuxer.isEOF();
+}
+
+// 比较两份内容，时间戳允许差一个输出时间基的舍入
+static bool sameTrack(const TrackDump& a, const TrackDump& b) {
+    if (a.codec != b.codec || a.sizes != b.sizes || a.keyframes != b.keyframes || a.pts_us.size() != b.pts_us.size()) {
+        return false;
+    }
+    // 不同容器的起始时间可能不同（例如MP4的编辑列表），比较相对于第一个包的时间
+    for (size_t i = 0; i < a.pts_us.size(); i++) {
+        int64_t da = a.pts_us[i] - a.pts_us[0];
+        int64_t db = b.pts_us[i] - b.pts_us[0];
+        if (std::abs(da - db) > 1000) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 测试1: 打开和关闭
+bool testOpenClose() {
+    Muxer muxer;
+    TEST_ASSERT(!muxer.open(""), "Empty filename should fail");
+    MuxerOptions bad_format;
+    bad_format.format = "no_such_format";
+    TEST_ASSERT(!muxer.open("test_bad.out", bad_format), "Unknown format should fail");
+    TEST_ASSERT(!muxer.open("test_unknown.no_such_extension"), "Unknown extension should fail");
+
+    TEST_ASSERT(muxer.open("test_empty.mkv"), "Should open mkv output");
+    TEST_ASSERT(muxer.isOpen() && std::string(muxer.getFormatContext()->oformat->name) == "matroska",
+               "Format should be guessed from the extension");
+    TEST_ASSERT(!muxer.writeHeader(), "Header without streams should fail");
+    TEST_ASSERT(muxer.addStream(nullptr) == -1, "Null stream should be rejected");
+    TEST_ASSERT(muxer.close(), "Closing without a header should succeed");
+    TEST_ASSERT(!muxer.isOpen(), "Muxer should be closed");
+    TEST_ASSERT(muxer.close(), "Closing twice should be harmless");
+
+    std::remove("test_empty.mkv");
+    return true;
+}
+
+// 测试2: MP4和MKV互相转封装，内容不变
+bool testRemuxRoundTrip() {
+    const std::string source = "test_remux_source.mp4";
+    const std::string mkv = "test_remux.mkv";
+    const std::string mp4 = "test_remux_back.mp4";
+    if (!createTestVideoFile(source)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+
+    MuxerStats stats;
+    TEST_ASSERT(Muxer::remux(source, mkv, {}, MuxerOptions(), &stats), "Should remux mp4 to mkv");
+    TEST_ASSERT(stats.packets > 0 && stats.dropped == 0 && stats.file_size == fileSize(mkv), "Stats should describe the output");
+    MuxerOptions faststart;
+    faststart.faststart = true;
+    TEST_ASSERT(Muxer::remux(mkv, mp4, {}, faststart), "Should remux mkv back to mp4");
+
+    TrackDump source_video, source_audio, mkv_video, mkv_audio, mp4_video, mp4_audio;
+    TEST_ASSERT(dumpTracks(source, source_video, source_audio), "Should read source");
+    TEST_ASSERT(dumpTracks(mkv, mkv_video, mkv_audio), "Should read mkv");
+    TEST_ASSERT(dumpTracks(mp4, mp4_video, mp4_audio), "Should read mp4");
+    TEST_ASSERT(stats.packets == static_cast<int64_t>(source_video.sizes.size() + source_audio.sizes.size()),
+               "Every packet should be written");
+    TEST_ASSERT(sameTrack(source_video, mkv_video) && sameTrack(source_audio, mkv_audio), "mkv should carry the same packets");
+    TEST_ASSERT(sameTrack(source_video, mp4_video) && sameTrack(source_audio, mp4_audio), "mp4 should carry the same packets");
+
+    // faststart把moov放到mdat前面
+    std::ifstream in(mp4, std::ios::binary);
+    std::string head(4096, '\0');
+    in.read(&head[0], head.size());
+    size_t moov = head.find("moov");
+    size_t mdat = head.find("mdat");
+    TEST_ASSERT(moov != std::string::npos && (mdat == std::string::npos || moov < mdat), "faststart should put moov first");
+
+    std::remove(source.c_str());
+    std::remove(mkv.c_str());
+    std::remove(mp4.c_str());
+    return true;
+}
+
+// 测试3: 只提取一条轨道
+bool testExtractTrack() {
+    const std::string source = "test_extract_source.mp4";
+    const std::string audio_only = "test_extract.m4a";
+    const std::string video_only = "test_extract.mkv";
+    if (!createTestVideoFile(source)) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+
+    TEST_ASSERT(Muxer::remux(source, audio_only, {MediaType::AUDIO}), "Should extract audio");
+    TEST_ASSERT(Muxer::remux(source, video_only, {MediaType::VIDEO}), "Should extract video");
+    TrackDump source_video, source_audio, audio_video, audio_audio, video_video, video_audio;
+    TEST_ASSERT(dumpTracks(source, source_video, source_audio), "Should read source");
+    TEST_ASSERT(dumpTracks(audio_only, audio_video, audio_audio), "Should read extracted audio");
+    TEST_ASSERT(dumpTracks(video_only, video_video, video_audio), "Should read extracted video");
+    TEST_ASSERT(audio_video.sizes.empty() && sameTrack(source_audio, audio_audio), "Audio file should hold only the audio track");
+    TEST_ASSERT(video_audio.sizes.empty() && sameTrack(source_video, video_video), "Video file should hold only the video track");
+    TEST_ASSERT(fileSize(audio_only) < fileSize(source), "Extracted track should be smaller than the source");
+    TEST_ASSERT(!Muxer::remux(source, "test_extract_none.mkv", {MediaType::SUBTITLE}), "Missing track type should fail");
+
+    std::remove(source.c_str());
+    std::remove(audio_only.c_str());
+    std::remove(video_only.c_str());
+    std::remove("test_extract_none.mkv");
+    return true;
+}
+
+// 测试4: 手动添加流和写包
+bool testManualMux() {
+    const std::string source = "test_manual_source.mkv";
+    const std::string srt = "test_manual.srt";
+    const std::string output = "test_manual.mp4";
+    {
+        std::ofstream out(srt);
+        out << "1\n00:00:01,000 --> 00:00:02,000\nHello\n\n";
+    }
+    std::string cmd = "ffmpeg -f lavfi -i testsrc=duration=3:size=320x240:rate=30 -f lavfi -i sine=duration=3 -i " + srt +
+                      " -map 0 -map 1 -map 2 -c:v libx264 -c:a aac -c:s srt -y " + source + " 2>/dev/null";
+    if (std::system(cmd.c_str()) != 0) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        std::remove(srt.c_str());
+        return true;
+    }
+
+    Demuxer demuxer;
+    TEST_ASSERT(demuxer.open(source), "Should open source");
+    TEST_ASSERT(demuxer.selectTrack(MediaType::SUBTITLE, 2), "Should select subtitle track");
+    Muxer muxer;
+    TEST_ASSERT(muxer.open(output), "Should open mp4 output");
+    TEST_ASSERT(muxer.addStream(demuxer, MediaType::SUBTITLE) == -1, "mp4 should reject srt subtitles");
+    int video_out = muxer.addStream(demuxer, MediaType::VIDEO);
+    TEST_ASSERT(video_out == 0, "Video should be the first output stream");
+    TEST_ASSERT(muxer.addStream(demuxer, MediaType::VIDEO) == video_out, "Adding the same stream twice should reuse it");
+    TEST_ASSERT(muxer.hasStream(demuxer.getStreamIndex(MediaType::VIDEO)), "Video input should be mapped");
+    TEST_ASSERT(!muxer.hasStream(demuxer.getStreamIndex(MediaType::AUDIO)), "Audio input should not be mapped");
+
+    PacketPtr packet = makePacket();
+    int video_packets = 0;
+    int other_packets = 0;
+    while (demuxer.readPacket(packet.get())) {
+        bool is_video = packet->stream_index == demuxer.getStreamIndex(MediaType::VIDEO);
+        TEST_ASSERT(muxer.writePacket(packet.get()), "Should write packet");
+        TEST_ASSERT(packet->data == nullptr, "Written packet should be consumed");
+        (is_video ? video_packets : other_packets)++;
+    }
+    TEST_ASSERT(muxer.addStream(demuxer, MediaType::AUDIO) == -1, "Streams cannot be added after the header");
+    TEST_ASSERT(muxer.getStats().packets == video_packets, "Only video packets should be written");
+    TEST_ASSERT(muxer.getStats().dropped == other_packets, "Unmapped packets should be counted as dropped");
+    TEST_ASSERT(muxer.close(), "Should write trailer");
+    demuxer.close();
+
+    TrackDump video, audio;
+    TEST_ASSERT(dumpTracks(output, video, audio), "Should read output");
+    TEST_ASSERT(static_cast<int>(video.sizes.size()) == video_packets && audio.sizes.empty(), "Output should hold the video track only");
+
+    std::remove(source.c_str());
+    std::remove(srt.c_str());
+    std::remove(output.c_str());
+    return true;
+}
+
+// 测试5: 转封装吞吐量，对比只读取同一个文件
+bool testRemuxThroughput() {
+    const std::string source = "test_throughput.mp4";
+    const std::string mkv = "test_throughput.mkv";
+    const std::string mp4 = "test_throughput_back.mp4";
+    if (!createTestVideoFile(source, 20, "1280x720")) {
+        std::cout << "WARNING: Cannot create test video file, skipping test" << std::endl;
+        return true;
+    }
+    double source_mb = fileSize(source) / (1024.0 * 1024.0);
+
+    // 每项取三次中最快的一次，减少页缓存和调度的干扰
+    auto best_of = [](int runs, const auto& body) {
+        int64_t best = INT64_MAX;
+        for (int i = 0; i < runs; i++) {
+            auto start = std::chrono::steady_clock::now();
+            if (!body()) {
+                return int64_t(-1);
+            }
+            best = std::min<int64_t>(best, std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    };
+    int64_t read_us = best_of(3, [&]() {
+        Demuxer demuxer;
+        if (!demuxer.open(source)) {
+            return false;
+        }
+        PacketPtr packet = makePacket();
+        while (demuxer.readPacket(packet.get())) {
+        }
+        return demuxer.isEOF();
+    });
+    int64_t to_mkv_us = best_of(3, [&]() { return Muxer::remux(source, mkv); });
+    int64_t to_mp4_us = best_of(3, [&]() { return Muxer::remux(mkv, mp4); });
+    TEST_ASSERT(read_us > 0 && to_mkv_us > 0 && to_mp4_us > 0, "All runs should succeed");
+
+    auto rate = [&](int64_t us) { return source_mb / (us / 1000000.0); };
+    std::cout << "source " << source_mb << "MB: read only " << rate(read_us) << "MB/s, mp4->mkv " << rate(to_mkv_us)
+              << "MB/s, mkv->mp4 " << rate(to_mp4_us) << "MB/s" << std::endl;
+    TEST_ASSERT(std::abs(fileSize(mp4) - fileSize(source)) < fileSize(source) / 10, "Round trip should keep the size");
+
+    std::remove(source.c_str());
+    std::remove(mkv.c_str());
+    std::remove(mp4.c_str());
+    return true;
+}
+
+int main() {
+    std::cout << "Starting Muxer Tests..." << std::endl;
+
+    RUN_TEST(testOpenClose);
+    RUN_TEST(testRemuxRoundTrip);
+    RUN_TEST(testExtractTrack);
+    RUN_TEST(testManualMux);
+    RUN_TEST(testRemuxThroughput);
+
+    // 输出测试结果
+    std::cout << "\n=== Test Summary ===" << std::endl;
+    std::cout << "Total tests: " << total_tests << std::endl;
+    std::cout << "Passed: " << passed_tests << std::endl;
+    std::cout << "Failed: " << failed_tests << std::endl;
+
+    return failed_tests == 0 ? 0 : 1;
+}
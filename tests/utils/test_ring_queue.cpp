@@ -0,0 +1,292 @@
+#include "../../src/utils/ring_queue.hpp"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace utils;
+
+// 作为对照的互斥锁加条件变量的有界队列
+template <typename T>
+class MutexQueue
+{
+public:
+    explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+
+    bool push(T &&item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return queue_.size() < capacity_ || closed_; });
+        if (closed_) {
+            return false;
+        }
+        queue_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    bool pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !queue_.empty() || closed_; });
+        if (queue_.empty()) {
+            return false;
+        }
+        item = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    size_t capacity_;
+    bool closed_ = false;
+    std::deque<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// 测试SPSC队列的基本操作
+void testSpscBasic() {
+    std::cout << "测试SPSC队列基本操作..." << std::endl;
+
+    SpscQueue<int> queue(3);
+    assert(queue.capacity() == 4); // 向上取整到2的幂
+    assert(queue.empty());
+
+    // 队列操作放在assert外面，定义了NDEBUG时也会执行
+    for (int i = 0; i < 4; ++i) {
+        [[maybe_unused]] bool pushed = queue.tryPush(i);
+        assert(pushed);
+    }
+    assert(queue.full());
+    [[maybe_unused]] bool overflow = queue.tryPush(100);
+    assert(!overflow);
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        [[maybe_unused]] bool popped = queue.tryPop(value);
+        assert(popped);
+        assert(value == i);
+    }
+    [[maybe_unused]] bool underflow = queue.tryPop(value);
+    assert(!underflow);
+
+    // 关闭后不能放入，剩余元素仍然可以取出
+    [[maybe_unused]] bool pushed_open = queue.push(7);
+    queue.close();
+    [[maybe_unused]] bool pushed_closed = queue.push(8);
+    [[maybe_unused]] bool popped_rest = queue.pop(value);
+    [[maybe_unused]] bool popped_empty = queue.pop(value);
+    assert(pushed_open && !pushed_closed);
+    assert(popped_rest && value == 7);
+    assert(!popped_empty);
+
+    std::cout << "✓ SPSC队列基本操作测试通过" << std::endl;
+}
+
+// 测试只能移动的元素
+void testMoveOnly() {
+    std::cout << "测试只能移动的元素..." << std::endl;
+
+    {
+        SpscQueue<std::unique_ptr<int>> queue(8);
+        [[maybe_unused]] bool pushed = queue.tryPush(std::make_unique<int>(1));
+        [[maybe_unused]] bool pushed_blocking = queue.push(std::make_unique<int>(2));
+        std::unique_ptr<int> item;
+        [[maybe_unused]] bool popped = queue.tryPop(item);
+        assert(pushed && pushed_blocking);
+        assert(popped && *item == 1);
+        // 剩下的元素在析构时释放
+    }
+    {
+        MpscQueue<std::unique_ptr<int>> queue(8);
+        [[maybe_unused]] bool pushed = queue.tryPush(std::make_unique<int>(3));
+        std::unique_ptr<int> item;
+        [[maybe_unused]] bool popped = queue.pop(item);
+        [[maybe_unused]] bool pushed_again = queue.tryPush(std::make_unique<int>(4));
+        assert(pushed && pushed_again);
+        assert(popped && *item == 3);
+    }
+
+    // 共享计数确认所有元素都被析构
+    auto counter = std::make_shared<int>(0);
+    {
+        MpscQueue<std::shared_ptr<int>> queue(4);
+        for (int i = 0; i < 4; ++i) {
+            [[maybe_unused]] bool pushed = queue.tryPush(counter);
+            assert(pushed);
+        }
+        assert(counter.use_count() == 5);
+    }
+    assert(counter.use_count() == 1);
+
+    std::cout << "✓ 只能移动的元素测试通过" << std::endl;
+}
+
+// 测试SPSC队列跨线程传递时的顺序，队列很小，双方都会经常阻塞
+void testSpscThreads() {
+    std::cout << "测试SPSC队列跨线程传递..." << std::endl;
+
+    const int count = 200000;
+    SpscQueue<int> queue(16);
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            queue.push(i);
+        }
+        queue.close();
+    });
+
+    int expected = 0;
+    int value;
+    while (queue.pop(value)) {
+        assert(value == expected);
+        expected++;
+    }
+    producer.join();
+    assert(expected == count);
+
+    std::cout << "✓ SPSC队列跨线程传递测试通过" << std::endl;
+}
+
+// 测试MPSC队列：所有元素都被取到，且每个生产者内部的顺序不变
+void testMpscThreads() {
+    std::cout << "测试MPSC队列多生产者..." << std::endl;
+
+    const int producers = 4;
+    const int per_producer = 50000;
+    MpscQueue<int64_t> queue(32);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < per_producer; ++i) {
+                queue.push(static_cast<int64_t>(p) << 32 | i);
+            }
+        });
+    }
+    std::thread closer([&]() {
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        queue.close();
+    });
+
+    std::vector<int64_t> last(producers, -1);
+    int total = 0;
+    int64_t value;
+    while (queue.pop(value)) {
+        int p = static_cast<int>(value >> 32);
+        int64_t i = value & 0xffffffff;
+        assert(i == last[p] + 1);
+        last[p] = i;
+        total++;
+    }
+    closer.join();
+    assert(total == producers * per_producer);
+
+    std::cout << "✓ MPSC队列多生产者测试通过" << std::endl;
+}
+
+// 元素是放入时的时间戳（纳秒），消费者据此计算排队延迟
+static int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 运行一次基准测试，输出吞吐量和延迟分位数
+template <typename Queue>
+void runBenchmark(const char *name, Queue &queue, int producers, int per_producer) {
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(producers) * per_producer);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < per_producer; ++i) {
+                int64_t timestamp = nowNanoseconds();
+                queue.push(std::move(timestamp));
+            }
+        });
+    }
+    std::thread closer([&]() {
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        queue.close();
+    });
+
+    int64_t timestamp;
+    while (queue.pop(timestamp)) {
+        latencies.push_back(nowNanoseconds() - timestamp);
+    }
+    closer.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    assert(latencies.size() == static_cast<size_t>(producers) * per_producer);
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))] / 1000.0;
+    };
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << " producers=" << producers << ": " << static_cast<int64_t>(latencies.size() / seconds)
+              << " ops/s, p50 " << percentile(0.5) << "us, p99 " << percentile(0.99) << "us, p99.9 "
+              << percentile(0.999) << "us, max " << latencies.back() / 1000.0 << "us" << std::endl;
+}
+
+// 与互斥锁加条件变量的队列对比吞吐量和尾延迟
+void testPerformance() {
+    std::cout << "测试性能..." << std::endl;
+
+    const int total = 400000;
+    const size_t capacity = 256;
+    {
+        SpscQueue<int64_t> queue(capacity);
+        runBenchmark("spsc ", queue, 1, total);
+    }
+    for (int producers = 1; producers <= 8; producers *= 2) {
+        {
+            MpscQueue<int64_t> queue(capacity);
+            runBenchmark("mpsc ", queue, producers, total / producers);
+        }
+        {
+            MutexQueue<int64_t> queue(capacity);
+            runBenchmark("mutex", queue, producers, total / producers);
+        }
+    }
+
+    std::cout << "✓ 性能测试完成" << std::endl;
+}
+
+int main() {
+    std::cout << "开始环形队列测试..." << std::endl << std::endl;
+
+    try {
+        testSpscBasic();
+        testMoveOnly();
+        testSpscThreads();
+        testMpscThreads();
+        testPerformance();
+
+        std::cout << std::endl << "🎉 所有测试都通过了！" << std::endl;
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "测试失败: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "测试失败: 未知异常" << std::endl;
+        return 1;
+    }
+}